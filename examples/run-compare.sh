@@ -0,0 +1,73 @@
+#!/bin/sh
+#
+# Before/after benchmark of two CrocoPat binaries on the bundled workloads.
+# ./run-compare.sh OLD_CROCOPAT NEW_CROCOPAT [MB] 2>& run-compare.log
+#
+# Runs each pattern on each project with both binaries (same BDD size
+# option -m MB, default 4) and reports times and memory per run.
+# The outputs of both binaries must be equal.
+# Times and memory are measured with GNU time (/usr/bin/time).
+# Without it, only the real time is reported (with date), no memory.
+
+if [ $# -lt 2 ]; then
+    echo "Usage: $0 OLD_CROCOPAT NEW_CROCOPAT [MB]"
+    exit 1
+fi
+OLD=$1
+NEW=$2
+MB=${3:-4}
+
+TIME=""
+for t in /usr/bin/time /bin/time; do
+    if [ -x $t ] && $t -f "" true 2>/dev/null; then
+	TIME=$t
+	break
+    fi
+done
+
+# measure LABEL COMMAND...: Runs COMMAND and reports its costs on stderr.
+measure() {
+    label=$1
+    shift
+    if [ -n "$TIME" ]; then
+	$TIME -f "%U user,\t%S sys,\t%M max resid set size\t$label" "$@"
+    else
+	start=`date +%s%N`
+	"$@"
+	end=`date +%s%N`
+	printf "%s ms real\t%s\n" $(( (end - start) / 1000000 )) "$label" >&2
+    fi
+}
+
+projects="\
+JHotDraw52 \
+JDK140AWT \
+JWAM16FullAndreas \
+jdk14v2 \
+"
+
+patterns="\
+Composite \
+ClassesInCycles \
+Cycles \
+SimilarClassesSort \
+SimilarClassesEX \
+InhDegenerate \
+SubclassKnowledge \
+Closure \
+"
+
+for pat in $patterns
+do
+    echo "=================================================="
+    echo "    Processing pattern $pat ..."
+    for proj in $projects
+    do
+	echo "----------------------------------------------"
+	echo "Processing project $proj ..."
+	measure old ${OLD} -m ${MB} programs/${pat}.rml < projects/${proj}.rsf > /tmp/run-compare.$$.old
+	measure new ${NEW} -m ${MB} programs/${pat}.rml < projects/${proj}.rsf > /tmp/run-compare.$$.new
+	cmp -s /tmp/run-compare.$$.old /tmp/run-compare.$$.new || echo "Outputs differ."
+    done;
+done;
+rm -f /tmp/run-compare.$$.*
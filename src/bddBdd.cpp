@@ -36,22 +36,77 @@
 #include <cstdlib>
 #include <cstring>
 #include <climits>
+#include <map>
 
 bddNode* bddBdd::mNodes = 0;
 unsigned bddBdd::mMaxNodeNr;
+unsigned bddBdd::mNodeNrLimit = 0;
 unsigned bddBdd::mFree;
+unsigned bddBdd::mFreeNr;
+unsigned bddBdd::mGcLiveNr = 0;
+unsigned bddBdd::mOldNr = 0;
 
-multiset<unsigned> bddBdd::mExtRefs;
+unsigned* bddBdd::mExtRefCnts = 0;
+unsigned bddBdd::mExtRefNr = 0;
 
-unsigned* bddBdd::mUniqueHash = 0;
+bddUniqueBucket* bddBdd::mUniqueHash = 0;
+void* bddBdd::mUniqueHashMem = 0;
 unsigned bddBdd::mUniqueHBitNr;
-bddBinEntry* bddBdd::mBinCache = 0;
-unsigned bddBdd::mBinCBitNr;
-bddStatEntry* bddBdd::mStatCache = 0;
-unsigned bddBdd::mStatCBitNr;
-
-/// For renameVars().
-unsigned bddBdd::mRenameCnt = 0;
+bddCache<bddBinEntry> bddBdd::mApplyCache;
+bddCache<bddBinEntry> bddBdd::mQuantCache;
+bddCache<bddTerEntry> bddBdd::mAndExistsCache;
+bddCache<bddTerEntry> bddBdd::mIteCache;
+bddCache<bddBinEntry> bddBdd::mVarCache;
+bddCache<bddStatEntry> bddBdd::mStatCache;
+
+/// For replaceVars().
+map<vector<unsigned>, unsigned> bddBdd::mReplaceKeys;
+
+/// For parallel operations.
+bddTaskPool bddBdd::mPool;
+unsigned bddBdd::mForkDepth = 0;
+bool bddBdd::mParallel = false;
+volatile int bddBdd::mFreeLock = 0;
+
+/// For reorderBlocks().
+unsigned bddBdd::mReorderThreshold = 0;
+bool bddBdd::mReorderDue = false;
+unsigned* bddBdd::mRefCnts = 0;
+vector< vector<unsigned> > bddBdd::mVarNodes;
+unsigned bddBdd::mLiveNr = 0;
+
+/// For compact().
+bool bddBdd::mCompactDue = false;
+double bddBdd::mCompactFarRatio = 0;
+unsigned* bddBdd::mForward = 0;
+
+/// For the traversals.
+unsigned short* bddBdd::mStamps = 0;
+unsigned short bddBdd::mEpoch = 0;
+
+/// For reclaimInOp().
+unsigned short bddBdd::mOpEpoch = 0;
+bool bddBdd::mGcInOp = false;
+
+/// For printStats().
+unsigned long bddBdd::mCallNr[mOpNr];
+bddProbeCounts bddBdd::mProbeCounts = { 0, 0, 0 };
+vector<bddProbeCounts> bddBdd::mThreadProbeCounts;
+unsigned long bddBdd::mGcNr = 0;
+unsigned long bddBdd::mGcMinorNr = 0;
+double bddBdd::mGcTime = 0;
+unsigned long bddBdd::mReclaimedNr = 0;
+unsigned bddBdd::mPeakLiveNr = 0;
+unsigned bddBdd::mPeakUsedNr = 0;
+unsigned bddBdd::mPeakMarkNr = 0;
+unsigned long bddBdd::mCreatedNr = 0;
+bddObserver bddBdd::mObserver = 0;
+unsigned long bddBdd::mGrowNr = 0;
+unsigned long bddBdd::mUniqueResizeNr = 0;
+unsigned long bddBdd::mReorderNr = 0;
+unsigned long bddBdd::mCompactNr = 0;
+unsigned long bddBdd::mCompactSkipNr = 0;
+unsigned long bddBdd::mResumeNr = 0;
 
 /////////////////////////////////////////////////////////////////
 /// Ensures that p1 <= p2.
@@ -65,14 +120,16 @@ bddBdd::normalize(unsigned& p1, unsigned& p2)
   }
 }
 
-/// Hash functions.
+/// Hash function. The high bits select the bucket, 
+///   the low bits (and the high bits) give the tag.
 inline unsigned 
-bddBdd::hash (unsigned i, unsigned hashBitNr) 
+bddBdd::hash(unsigned i, unsigned j, unsigned k) 
 {
-  unsigned mask = (1u << hashBitNr) - 1;
-  return i & mask;
+  return ((i * 14099753 + j) * 9243337 + k) * 3901787;
 }
 
+/*
+/// Additional hash functions for comparison.
 inline unsigned 
 bddBdd::hash(unsigned i, unsigned j, unsigned k, unsigned hashBitNr) 
 {
@@ -83,8 +140,6 @@ bddBdd::hash(unsigned i, unsigned j, unsigned k, unsigned hashBitNr)
     (k<<(hashBitNr>>2)) + (k>>(hashBitNr>>2))) & mask;
 }
 
-/*
-/// Additional hash functions for comparison.
 inline unsigned 
 bddBdd::hash(unsigned i, unsigned j, unsigned hashBitNr) {
   unsigned mask = (1u << hashBitNr) - 1;
@@ -98,638 +153,2441 @@ bddBdd::hash(unsigned i, unsigned j, unsigned hashBitNr) {
   return ((i * 17765507 + j) * 9243337) >> (32-hashBitNr);
 }
 
-inline unsigned 
-bddBdd::hash(unsigned i, unsigned j, unsigned k, unsigned hashBitNr) {
-  return (((i * 14099753 + j) * 9243337 + k) * 3901787) >> (32-hashBitNr);
-}
 */
 
 /// Marks (mark=1) all nodes of the BDD with the root pRoot.
+///   Iterative with an explicit stack, because the depth of the BDD 
+///   is only bounded by the number of variables.
+///   A node is marked when it is pushed, i.e., at most once.
+void 
+bddBdd::mark(unsigned pRoot, vector<unsigned>& pStack) 
+{
+  if(mNodes[getNode(pRoot)].mark)
+  {
+    return;
+  }
+  mNodes[getNode(pRoot)].mark = 1;
+  pStack.push_back(getNode(pRoot));
+  while(!pStack.empty())
+  {
+    const bddNode& lNode = mNodes[pStack.back()];
+    pStack.pop_back();
+    // Note: Terminal nodes are always marked.
+    if(!mNodes[getNode(lNode.low)].mark)
+    {
+      mNodes[getNode(lNode.low)].mark = 1;
+      pStack.push_back(getNode(lNode.low));
+    }
+    if(!mNodes[getNode(lNode.high)].mark)
+    {
+      mNodes[getNode(lNode.high)].mark = 1;
+      pStack.push_back(getNode(lNode.high));
+    }
+  }
+}
+
+/// Marks (mark=1) all young nodes of the BDD with the root pRoot.
+///   Stops at old nodes, because their sons are old, too.
 void 
-bddBdd::mark(unsigned pRoot) 
+bddBdd::markYoung(unsigned pRoot, vector<unsigned>& pStack) 
+{
+  pStack.push_back(getNode(pRoot));
+  while(!pStack.empty())
+  {
+    bddNode& lNode = mNodes[pStack.back()];
+    pStack.pop_back();
+    if(!lNode.mark  &&  !lNode.old) 
+    {
+      lNode.mark = 1;
+      pStack.push_back(getNode(lNode.low));
+      pStack.push_back(getNode(lNode.high));
+    }
+  }
+}
+
+/// After a garbage collection between operations, the nodes protected 
+///   by the previous operation are dead or externally referenced,
+///   and the freed nodes must not remain protected.
+void
+bddBdd::unprotectIfSafe()
+{
+  if(!mGcInOp)
+  {
+    mOpEpoch = newEpoch();
+  }
+}
+
+/// Returns a new stamp for a traversal, never mOpEpoch. When the epochs 
+///   wrap around, all stamps are reset, such that no node carries the 
+///   new stamp. The protected nodes (see protect()) keep their protection
+///   with the stamp 1.
+unsigned short
+bddBdd::newEpoch()
 {
-  if(!mNodes[pRoot].mark) 
+  ++mEpoch;
+  if(mEpoch == mOpEpoch)
   {
-    mNodes[pRoot].mark = 1;
-    mark(mNodes[pRoot].low);
-    mark(mNodes[pRoot].high); 
+    ++mEpoch;
   }
+  if(mEpoch == 0)
+  {
+    for(unsigned lCnt = 0; lCnt < mMaxNodeNr; ++lCnt)
+    {
+      mStamps[lCnt] = (mOpEpoch != 0  &&  mStamps[lCnt] == mOpEpoch) ? 1 : 0;
+    }
+    mOpEpoch = 1;
+    mEpoch = 2;
+  }
+  return mEpoch;
 }
 
-/// Unmarks (mark=0) all nodes of the BDD with the root pRoot.
-/// Terminal always remain marked.
+/// Moves all young nodes of the BDD with the root pRoot 
+///   into the old generation. Stops at old nodes, 
+///   because their sons are old, too. The terminal is always old.
+///   The old bit is the visited marker of the traversal.
 void 
-bddBdd::unMark(unsigned pRoot) 
+bddBdd::promote(unsigned pRoot, vector<unsigned>& pStack) 
 {
-  if(mNodes[pRoot].mark && pRoot != 0 && pRoot != 1)
+  pStack.push_back(getNode(pRoot));
+  while(!pStack.empty())
   {
-    mNodes[pRoot].mark = 0;
-    unMark(mNodes[pRoot].low);
-    unMark(mNodes[pRoot].high);
+    bddNode& lNode = mNodes[pStack.back()];
+    pStack.pop_back();
+    if(!lNode.old) 
+    {
+      lNode.old = 1;
+      ++mOldNr;
+      pStack.push_back(getNode(lNode.low));
+      pStack.push_back(getNode(lNode.high));
+    }
   }
 }
 
+/// Inserts node pNode into the list of unused nodes.
+void
+bddBdd::freeNode(unsigned pNode)
+{
+  mOldNr -= mNodes[pNode].old;
+  mNodes[pNode].old = 0;
+  mNodes[pNode].low = mFree;
+  mFree = pNode;
+  ++mFreeNr;
+}
+
 /// Garbage collection: All dead nodes (i.e. all nodes which are not reachable
-/// from a node in mExtRefs) are freed (i.e. inserted into unused-list mFree).
-/// Terminal nodes are never freed.
+/// from an externally referenced node) are freed 
+/// (i.e. inserted into unused-list mFree).
+/// Terminal nodes are never freed. Live nodes keep their generation.
 void 
 bddBdd::gc() 
 {
+  const bddObserved lObserved(mObserver, "gc");
+  const clock_t lStart = clock();
+  const unsigned lUsedNr = mMaxNodeNr - 1 - mFreeNr;
   // Mark all live nodes.
-  for(multiset<unsigned>::iterator lIt = mExtRefs.begin();
-      lIt != mExtRefs.end();
-      lIt++)
+  vector<unsigned> lStack;
+  for(unsigned lCnt = 1; lCnt < mMaxNodeNr; ++lCnt)
   {
-    mark(*lIt);
+    if(mExtRefCnts[lCnt] != 0  ||  isProtected(lCnt))
+    {
+      mark(lCnt << 1, lStack);
+    }
   }
   
-  // Clear hash and caches.
-  memset(mUniqueHash, 0, (1u << mUniqueHBitNr) * sizeof(unsigned));
-  memset(mStatCache, 0, (1u << mStatCBitNr) * sizeof(bddStatEntry));
-  memset(mBinCache, 0, (1u << mBinCBitNr) * sizeof(bddBinEntry));
+  // Drop the cache entries with dead nodes, the others remain valid.
+  mApplyCache.sweep(&isMarked);
+  mQuantCache.sweep(&isMarked);
+  mAndExistsCache.sweep(&isMarked);
+  mIteCache.sweep(&isMarked);
+  mVarCache.sweep(&isMarked);
+  mStatCache.sweep(&isMarked);
+
+  const unsigned lFarNr = sweep(false);
+  mGcLiveNr = mMaxNodeNr - 1 - mFreeNr;
+  checkScatter(lFarNr);
+  ++mGcNr;
+  countGc(lStart, lUsedNr);
+  unprotectIfSafe();
+}
+
+/// Minor garbage collection: Only the young nodes reachable from
+///   externally referenced nodes are marked, old nodes are not traversed.
+///   Dead old nodes remain until the next (major) gc().
+void 
+bddBdd::gcMinor() 
+{
+  const bddObserved lObserved(mObserver, "gcMinor");
+  const clock_t lStart = clock();
+  const unsigned lUsedNr = mMaxNodeNr - 1 - mFreeNr;
+  vector<unsigned> lStack;
+  for(unsigned lCnt = 1; lCnt < mMaxNodeNr; ++lCnt)
+  {
+    if(mExtRefCnts[lCnt] != 0  ||  isProtected(lCnt))
+    {
+      markYoung(lCnt << 1, lStack);
+    }
+  }
+
+  // Drop the cache entries with dead nodes, the others remain valid.
+  mApplyCache.sweep(&isMarkedOrOld);
+  mQuantCache.sweep(&isMarkedOrOld);
+  mAndExistsCache.sweep(&isMarkedOrOld);
+  mIteCache.sweep(&isMarkedOrOld);
+  mVarCache.sweep(&isMarkedOrOld);
+  mStatCache.sweep(&isMarkedOrOld);
+
+  const unsigned lFarNr = sweep(true);
+  mGcLiveNr = mMaxNodeNr - 1 - mFreeNr;
+  checkScatter(lFarNr);
+  ++mGcMinorNr;
+  countGc(lStart, lUsedNr);
+  unprotectIfSafe();
+}
+
+/// Updates the statistics after a garbage collection that started 
+///   at processor time pStart with pUsedNr used nodes.
+void
+bddBdd::countGc(clock_t pStart, unsigned pUsedNr)
+{
+  mGcTime += (double) (clock() - pStart) / CLOCKS_PER_SEC;
+  if(pUsedNr > mGcLiveNr)
+  {
+    mReclaimedNr += pUsedNr - mGcLiveNr;
+  }
+  mPeakUsedNr = max(mPeakUsedNr, pUsedNr);
+  mPeakMarkNr = max(mPeakMarkNr, pUsedNr);
+  mPeakLiveNr = max(mPeakLiveNr, mGcLiveNr);
+}
+
+/// Frees all unmarked nodes, except old nodes if pKeepOld.
+///   Unmarks the other nodes and inserts them into the cleared mUniqueHash.
+///   One sequential pass over the node array is much faster 
+///   than removing the dead nodes one by one from mUniqueHash.
+/// Returns the number of edges between used nodes that lead to a son
+///   farther away than mCompactNearNr nodes.
+unsigned
+bddBdd::sweep(bool pKeepOld)
+{
+  memset(mUniqueHash, 0, (1u << mUniqueHBitNr) * sizeof(bddUniqueBucket));
 
   mFree = 0;
-  for(unsigned lCnt = mMaxNodeNr-1; lCnt >= 2; --lCnt) 
+  mFreeNr = 0;
+  unsigned result = 0;
+  for(unsigned lCnt = mMaxNodeNr-1; lCnt >= 1; --lCnt) 
   {
-    if(!mNodes[lCnt].mark) 
+    // Load the bucket of a node some iterations ahead.
+    if(lCnt > mSweepAhead)
+    {
+      const bddNode& lNode = mNodes[lCnt - mSweepAhead];
+      BDD_PREFETCH(&mUniqueHash[
+        hash(lNode.var, lNode.low, lNode.high) >> (32 - mUniqueHBitNr)]);
+    }
+    if(!mNodes[lCnt].mark  &&  !(pKeepOld  &&  mNodes[lCnt].old)) 
     { 
       // Free dead nodes.
-      mNodes[lCnt].low = mFree;
-      mFree = lCnt;
+      freeNode(lCnt);
     } 
     else 
     {                
       mNodes[lCnt].mark = 0;
       // Insert live nodes into mUniqueHash.
-      unsigned lHashIndex = hash(
-        mNodes[lCnt].var, mNodes[lCnt].low, mNodes[lCnt].high, mUniqueHBitNr);
-      mNodes[lCnt].next = mUniqueHash[lHashIndex];
-      mUniqueHash[lHashIndex] = lCnt;
+      hashInsert(lCnt);
+      const unsigned lSons[2] = { getNode(mNodes[lCnt].low), 
+                                  getNode(mNodes[lCnt].high) };
+      for(unsigned lSon = 0; lSon < 2; ++lSon)
+      {
+        if(lSons[lSon] != 0  
+           &&  (lSons[lSon] > lCnt ? lSons[lSon] - lCnt : lCnt - lSons[lSon])
+               > mCompactNearNr)
+        {
+          ++result;
+        }
+      }
     }
   }
+  return result;
 }
 
-
-/// Returns the mNodes-index of the node with the passed var-, low- and
-/// high-values. If such node does not exists, it is inserted into
-/// mNodes and mUniqueHash. If there are no free nodes left, throws exception.
-unsigned 
-bddBdd::insert(unsigned pVar, unsigned pLow, unsigned pHigh) 
+/// The used nodes are scattered if more than half of the edges between 
+///   them lead more than one page away, and at least twice as many
+///   as after the last compaction (relative to the number of live nodes). 
+///   Otherwise compaction would not gain much, e.g. for BDDs with many 
+///   nodes per level, which breadth-first placement cannot keep together.
+void
+bddBdd::checkScatter(unsigned pFarNr)
 {
-  unsigned lHashIndex;
-  unsigned lResult;
-
-  // BDD-reduction of nodes with equal high- and low-child.
-  if(pHigh == pLow) 
+  if(mGcLiveNr < mCompactMinNr  ||  mGcLiveNr == 0)
   {
-    return pLow;
+    return;
+  }
+  const double lFarRatio = (double) pFarNr / mGcLiveNr;
+  if(lFarRatio > 1  &&  lFarRatio > 2 * mCompactFarRatio)
+  {
+    mCompactDue = true;
   }
+}
 
-  // Search mUniqueHash.
-  lHashIndex = hash(pVar, pLow, pHigh, mUniqueHBitNr);
-  lResult = mUniqueHash[lHashIndex];  
-  while(lResult) 
+/// Moves all live nodes into the old generation.
+void
+bddBdd::promoteAll()
+{
+  vector<unsigned> lStack;
+  for(unsigned lCnt = 1; lCnt < mMaxNodeNr; ++lCnt)
   {
-    if(   mNodes[lResult].var == pVar 
-       && mNodes[lResult].low == pLow
-       && mNodes[lResult].high == pHigh) 
+    if(mExtRefCnts[lCnt] != 0)
     {
-      return lResult;
+      promote(lCnt << 1, lStack);
     }
-    lResult = mNodes[lResult].next;
   }
+}
 
-  // Create new node.
-  if(mFree == 0)
+/// Appends the unplaced nodes below the externally referenced node 
+///   pNode to pOrder, breadth-first, i.e., level by level.
+///   Assigns them the free slots from pSlot on as new indices.
+void
+bddBdd::placeBreadthFirst(unsigned pNode, 
+                          vector<unsigned>& pOrder, 
+                          unsigned& pSlot)
+{
+  unsigned lNode = pNode;
+  for(unsigned lNext = pOrder.size(); ; ++lNext)
   {
-    throw "Error: BDD package out of memory\n";
+    const unsigned lSons[2] = { getNode(mNodes[lNode].low), 
+                                getNode(mNodes[lNode].high) };
+    for(unsigned lSon = 0; lSon < 2; ++lSon)
+    {
+      if(lSons[lSon] != 0  &&  mForward[lSons[lSon]] == 0)
+      {
+        // Externally referenced nodes stay in place.
+        while(mExtRefCnts[pSlot] != 0)
+        {
+          ++pSlot;
+        }
+        pOrder.push_back(lSons[lSon]);
+        mForward[lSons[lSon]] = pSlot;
+        ++pSlot;
+      }
+    }
+    if(lNext == pOrder.size())
+    {
+      return;
+    }
+    lNode = pOrder[lNext];
   }
-
-  lResult = mFree;
-  mFree = mNodes[lResult].low;
-  mNodes[lResult].var = pVar;
-  mNodes[lResult].low = pLow;
-  mNodes[lResult].high = pHigh;
-  mNodes[lResult].next = mUniqueHash[lHashIndex];
-  mUniqueHash[lHashIndex] = lResult;
-
-  return lResult;
 }
 
-/// Check if there is any BDD node between the variable ids.
-/// Returns 'true' if any such node is found.
-bool 
-bddBdd::testVars_(unsigned pRoot, 
-                  unsigned pVarIdFirst, 
-                  unsigned pVarIdLast)
+/// Compacting garbage collection. The externally referenced nodes stay 
+///   in place, such that the BDD objects need not be rewritten. 
+///   The other used nodes move into the free slots from the beginning
+///   of the node array, breadth-first from the externally referenced 
+///   nodes in ascending order. The nodes are moved in place along the 
+///   chains of the permutation, only the table mForward is allocated.
+void
+bddBdd::compact()
 {
-  // Note: Terminal nodes are always marked.
-  if(mNodes[pRoot].mark)
+  const bddObserved lObserved(mObserver, "compact");
+  gc();
+  mCompactDue = false;
+
+  mForward = (unsigned*) calloc(mMaxNodeNr, sizeof(unsigned));
+  if(!mForward)
   {
-    return false;
+    ++mCompactSkipNr;
+    return;
   }
-  mNodes[pRoot].mark = 1;
 
-  // Node after forbidden range.
-  if(mNodes[pRoot].var > pVarIdLast)
+  // Old indices of the moving nodes, in the new order.
+  vector<unsigned> lOrder;
+  unsigned lSlot = 1;
+  for(unsigned lCnt = 1; lCnt < mMaxNodeNr; ++lCnt)
   {
-    return false;
+    if(mExtRefCnts[lCnt] != 0)
+    {
+      mForward[lCnt] = lCnt;
+    }
   }
-  
-  // Node within forbidden range.
-  if(    mNodes[pRoot].var <= pVarIdLast 
-     &&  mNodes[pRoot].var >= pVarIdFirst )
+  for(unsigned lCnt = 1; lCnt < mMaxNodeNr; ++lCnt)
   {
-    return true;
+    if(mExtRefCnts[lCnt] != 0)
+    {
+      placeBreadthFirst(lCnt, lOrder, lSlot);
+    }
   }
 
-  // Process node in front of forbidden range.
-  if( testVars_(mNodes[pRoot].low,  pVarIdFirst, pVarIdLast) )
+  // Move the nodes. A chain starts with a node whose content is taken 
+  //   out, and continues while the target slot holds a node that has 
+  //   not moved yet. It ends with a free slot, or the start of the chain.
+  vector<bool> lMoved(mMaxNodeNr, false);
+  for(unsigned lCnt = 0; lCnt < lOrder.size(); ++lCnt)
   {
-    return true;
+    unsigned lCur = lOrder[lCnt];
+    if(lMoved[lCur])
+    {
+      continue;
+    }
+    bddNode lContent = mNodes[lCur];
+    lMoved[lCur] = true;
+    for(;;)
+    {
+      const unsigned lTarget = mForward[lCur];
+      if(mForward[lTarget] != 0  &&  mExtRefCnts[lTarget] == 0  
+         &&  !lMoved[lTarget])
+      {
+        const bddNode lNext = mNodes[lTarget];
+        mNodes[lTarget] = lContent;
+        lMoved[lTarget] = true;
+        lContent = lNext;
+        lCur = lTarget;
+      }
+      else
+      {
+        mNodes[lTarget] = lContent;
+        break;
+      }
+    }
   }
 
-  return testVars_(mNodes[pRoot].high,  pVarIdFirst, pVarIdLast);
-}
-
-/// Returns number of represented tuples of the BDD with root pRoot.
-/// pVar is the first and pMaxVar is the maximum id of a variable.
-/// The BDD must not contain nodes with other variable ids.
-double 
-bddBdd::getTupleNr_(unsigned pRoot, unsigned pVar, unsigned pMaxVar)
-{
-  // Terminal case.
-  if(pVar > pMaxVar)
+  // Rewrite the edges of the used nodes, and mark them for sweep().
+  //   lUsed holds the new indices of the used nodes.
+  vector<bool> lUsed(mMaxNodeNr, false);
+  for(unsigned lCnt = 1; lCnt < mMaxNodeNr; ++lCnt)
   {
-    return (pRoot == 0 ? 0.0 : 1.0);
+    if(mExtRefCnts[lCnt] != 0)
+    {
+      lUsed[lCnt] = true;
+    }
   }
-
-  // pVar <= pMaxVar.
-
-  // Reduced node?
-  if(pVar < mNodes[pRoot].var)
+  for(unsigned lCnt = 0; lCnt < lOrder.size(); ++lCnt)
   {
-    return 2 * getTupleNr_(pRoot, pVar + 1, pMaxVar);
+    lUsed[mForward[lOrder[lCnt]]] = true;
   }
-
-  // Forbid nodes with variable id less than 'pVar'.
-  assert(pVar == mNodes[pRoot].var);
-
-  // Now pVar == mNodes[pRoot].var holds.
-  // Result in cache?
-  unsigned lCacheIndex = hash(pRoot, mStatCBitNr);
-  if(mStatCache[lCacheIndex].root == pRoot)
+  unsigned lUsedNr = 0;
+  for(unsigned lCnt = 1; lCnt < mMaxNodeNr; ++lCnt)
   {
-    return mStatCache[lCacheIndex].result;
+    if(lUsed[lCnt])
+    {
+      bddNode& lNode = mNodes[lCnt];
+      lNode.low = forwardEdge(lNode.low);
+      lNode.high = forwardEdge(lNode.high);
+      lNode.mark = 1;
+      ++lUsedNr;
+    }
+    else
+    {
+      // Vacated slots keep their old content, which is no old node.
+      mNodes[lCnt].old = 0;
+    }
   }
-
-  mStatCache[lCacheIndex].result 
-    = getTupleNr_(mNodes[pRoot].low, pVar + 1, pMaxVar)
-    + getTupleNr_(mNodes[pRoot].high, pVar + 1, pMaxVar);
-  mStatCache[lCacheIndex].root = pRoot;
-
-  return mStatCache[lCacheIndex].result;
+  // After gc(), all used nodes are reachable.
+  assert(lUsedNr == mGcLiveNr);
+
+  mApplyCache.relocate(&forwardEdge);
+  mQuantCache.relocate(&forwardEdge);
+  mAndExistsCache.relocate(&forwardEdge);
+  mIteCache.relocate(&forwardEdge);
+  mVarCache.relocate(&forwardEdge);
+  mStatCache.relocate(&forwardEdge);
+  free(mForward);
+  mForward = 0;
+
+  // The stamps belong to the old indices.
+  memset(mStamps, 0, (size_t) mMaxNodeNr * sizeof(unsigned short));
+  mEpoch = 0;
+  mOpEpoch = newEpoch();
+
+  const unsigned lFarNr = sweep(false);
+  mCompactFarRatio = (mGcLiveNr == 0) ? 0 : (double) lFarNr / mGcLiveNr;
+  ++mCompactNr;
 }
 
-/// Returns the elements pVar ... pMaxVar of an arbitrary tuple of the BDD.
-unsigned 
-bddBdd::getTuple_(unsigned pRoot, unsigned pVar, unsigned pMaxVar)
+/// Collects the young generation before an operation, if less than 
+///   1/16 of the nodes is free, and at least 1/4 of the nodes was 
+///   created since the last garbage collection.
+///   Most of these nodes are intermediate results, i.e., dead.
+///   Otherwise, the operation calls reclaimInOp() if necessary.
+///   Starts the protection of the intermediate results (see protect()).
+void
+bddBdd::gcIfDue()
 {
-  // Terminal case.
-  if(pVar > pMaxVar)
+  mOpEpoch = newEpoch();
+  if(mFreeNr >= mMaxNodeNr / 16)
   {
-    return 0;
+    return;
   }
-
-  // pVar <= pMaxVar.
-
-  // Reduced node?
-  if(pVar < mNodes[pRoot].var)
+  if(mMaxNodeNr - 1 - mFreeNr >= mGcLiveNr + mMaxNodeNr / 4)
   {
-    return getTuple_(pRoot, pVar + 1, pMaxVar);
+    gcMinor();
+    if(mReorderThreshold != 0  &&  mGcLiveNr > mReorderThreshold)
+    {
+      mReorderDue = true;
+    }
   }
+}
 
-  if(pVar > mNodes[pRoot].var)
+/// Returns the floor of the binary logarithm of pNr (pNr > 0).
+static unsigned
+log2floor(unsigned pNr)
+{
+  unsigned lResult = 0;
+  while(pNr > 1)
   {
-    if (mNodes[pRoot].low != 0) {
-      return getTuple_(mNodes[pRoot].low, pVar, pMaxVar);
-    } else { 
-      return getTuple_(mNodes[pRoot].high, pVar, pMaxVar);
-    } 
+    pNr >>= 1;
+    ++lResult;
   }
-
-  // pVar == mNodes[pRoot].var.
-
-  if (mNodes[pRoot].low != 0) {
-    return getTuple_(mNodes[pRoot].low, pVar + 1, pMaxVar);
-  } else { 
-    return getTuple_(mNodes[pRoot].high, pVar + 1, pMaxVar)
-      + (1 << (pMaxVar - pVar));
-  } 
+  return lResult;
 }
 
-/// Returns number of nodes of the BDD with root pRoot.
-/// (Terminal nodes are not counted). Side effect: counted nodes are marked.
-unsigned 
-bddBdd::getNodeNr_(unsigned pRoot) 
+/// Returns the number of bits (at least pMinBitNr, at most mUniqueHBitMax)
+///   of a unique table that holds pNodeNr nodes with some room for probing.
+unsigned
+bddBdd::getUniqueHBitNr(unsigned pMinBitNr, unsigned pNodeNr)
 {
-  // Note: Terminal nodes are always marked.
-  if(mNodes[pRoot].mark)
+  const size_t lSlotNr = (size_t) pNodeNr + pNodeNr / 4;
+  unsigned lBitNr = pMinBitNr;
+  while(lBitNr < mUniqueHBitMax
+        && ((size_t) bddUniqueBucket::mSlotNr << lBitNr) < lSlotNr)
   {
-    return 0;
+    ++lBitNr;
   }
-  mNodes[pRoot].mark = 1;
-
-  return getNodeNr_(mNodes[pRoot].low) + getNodeNr_(mNodes[pRoot].high) + 1;
+  return lBitNr;
 }
 
-/// Computes the number of nodes per variable id.
-void 
-bddBdd::getNodesPerVarId_(unsigned pRoot, 
-                          map<unsigned, unsigned>& pBddNodesPerVar)
+/// Replaces mUniqueHash by an empty table with 2^pBitNr buckets,
+///   aligned to cache lines. Keeps the old table if memory is exhausted.
+bool
+bddBdd::allocUniqueHash(unsigned pBitNr)
 {
-  // Note: Terminal nodes are always marked.
-  if( !mNodes[pRoot].mark )
+  const size_t lLineSize = sizeof(bddUniqueBucket);
+  void* lMem = malloc((size_t) (1u << pBitNr) * sizeof(bddUniqueBucket)
+                      + lLineSize);
+  if(!lMem)
   {
-    mNodes[pRoot].mark = 1;
-    if ( pBddNodesPerVar.find(mNodes[pRoot].var) != pBddNodesPerVar.end() ) {
-      ++ pBddNodesPerVar[mNodes[pRoot].var];
-    } else {
-      pBddNodesPerVar[mNodes[pRoot].var] = 1;
-    }
-    getNodesPerVarId_(mNodes[pRoot].low,  pBddNodesPerVar); 
-    getNodesPerVarId_(mNodes[pRoot].high, pBddNodesPerVar);
+    return false;
   }
+  free(mUniqueHashMem);
+  mUniqueHashMem = lMem;
+  mUniqueHash = (bddUniqueBucket*) 
+    ((char*) lMem + lLineSize - (size_t) lMem % lLineSize);
+  mUniqueHBitNr = pBitNr;
+  memset(mUniqueHash, 0, (1u << mUniqueHBitNr) * sizeof(bddUniqueBucket));
+  return true;
 }
 
-/// Creates output graph representation for BDD with root pRoot.
-void 
-bddBdd::getGraph_(unsigned pRoot, 
-                  multimap<unsigned,bddGraphNode>& pGraph)
+/// Grows the node array by factor 2 (but not beyond mNodeNrLimit),
+///   and the hash table and the caches by the same factor.
+/// The new nodes are not yet in the list of unused nodes, 
+///   i.e., gc() has to be called afterwards.
+/// Returns false if the node array cannot grow.
+bool 
+bddBdd::grow()
 {
-  // Note: Terminal nodes are always marked.
-  if( !mNodes[pRoot].mark )
+  const bddObserved lObserved(mObserver, "grow");
+  unsigned lNewMaxNodeNr = mMaxNodeNr;
+  if(mMaxNodeNr <= mNodeNrMax / 2)
+  {
+    lNewMaxNodeNr = 2 * mMaxNodeNr;
+  }
+  else
+  {
+    lNewMaxNodeNr = mNodeNrMax;
+  }
+  if(mNodeNrLimit != 0  &&  lNewMaxNodeNr > mNodeNrLimit + 1)
+  {
+    lNewMaxNodeNr = mNodeNrLimit + 1;
+  }
+  if(lNewMaxNodeNr <= mMaxNodeNr)
   {
-    mNodes[pRoot].mark = 1;
+    return false;
+  }
 
-    bddGraphNode node;
-    node.id   = pRoot;
-    node.var  = mNodes[pRoot].var;
-    node.low  = mNodes[pRoot].low;
-    node.high = mNodes[pRoot].high;
-    pGraph.insert( pair<unsigned,bddGraphNode>(node.var, node) );
+  // Reference counters first, such that they always cover mNodes.
+  unsigned* lExtRefCnts = (unsigned*) realloc(mExtRefCnts, 
+    (size_t) lNewMaxNodeNr * sizeof(unsigned));
+  if(!lExtRefCnts)
+  {
+    return false;
+  }
+  mExtRefCnts = lExtRefCnts;
+  memset(mExtRefCnts + mMaxNodeNr, 0, 
+         (size_t) (lNewMaxNodeNr - mMaxNodeNr) * sizeof(unsigned));
 
-    getGraph_(mNodes[pRoot].low,  pGraph); 
-    getGraph_(mNodes[pRoot].high, pGraph);
+  unsigned short* lStamps = (unsigned short*) realloc(mStamps, 
+    (size_t) lNewMaxNodeNr * sizeof(unsigned short));
+  if(!lStamps)
+  {
+    return false;
   }
-}
+  mStamps = lStamps;
+  memset(mStamps + mMaxNodeNr, 0, 
+         (size_t) (lNewMaxNodeNr - mMaxNodeNr) * sizeof(unsigned short));
 
-/// Prints BDD with root pRoot as reduced binary decision tree.
-void 
-bddBdd::print_(ostream& pS, unsigned pRoot)
-{
-  if(pRoot == 1) 
+  bddNode* lNodes 
+    = (bddNode*) realloc(mNodes, (size_t) lNewMaxNodeNr * sizeof(bddNode));
+  if(!lNodes)
   {
-    cout << 'T';
+    return false;
   }
-  else 
+  mNodes = lNodes;
+  memset(mNodes + mMaxNodeNr, 0, 
+         (size_t) (lNewMaxNodeNr - mMaxNodeNr) * sizeof(bddNode));
+
+  // The unique table must hold all nodes, with some room for probing.
+  //   Until mMaxNodeNr is updated, the new nodes do not exist.
+  const unsigned lUniqueHBitNr 
+    = getUniqueHBitNr(mUniqueHBitNr, lNewMaxNodeNr);
+  if(lUniqueHBitNr > mUniqueHBitNr)
   {
-    if(pRoot == 0)
-    {
-      cout << 'F';
-    }
-    else 
+    if(!allocUniqueHash(lUniqueHBitNr))
     {
-      cout << '(';
-      print_(pS, mNodes[pRoot].low);
-      cout << ' ' << mNodes[pRoot].var << ' ';
-      print_(pS, mNodes[pRoot].high);
-      cout << ')';
+      return false;
     }
-  }
+    ++mUniqueResizeNr;
+  }
+
+  const unsigned lBitDelta = log2floor(lNewMaxNodeNr) - log2floor(mMaxNodeNr);
+  mMaxNodeNr = lNewMaxNodeNr;
+
+  // The hash table is rebuilt by gc(), the caches rehash their entries.
+  //   If the caches cannot grow, they keep their size.
+  mApplyCache.grow(lBitDelta);
+  mQuantCache.grow(lBitDelta);
+  mAndExistsCache.grow(lBitDelta);
+  mIteCache.grow(lBitDelta);
+  mVarCache.grow(lBitDelta);
+  mStatCache.grow(lBitDelta);
+  ++mGrowNr;
+  return true;
 }
 
-/// Checks if pRoot2 represents a subset of pRoot1
-bool 
-bddBdd::setContains_(unsigned pRoot1, unsigned pRoot2) 
+/// Provides free nodes while insert() runs out of nodes during an 
+///   operation, such that the operation continues: The intermediate 
+///   results (see protect()) are live, like externally referenced nodes.
+///   Collects the young generation, or all garbage if this leaves 
+///   less than a quarter of the nodes free. Grows the node array 
+///   if less than a quarter of the nodes is free afterwards.
+///   Not during reordering, which counts references itself (see ref()),
+///   and not during parallel operations, whose threads cannot stop.
+void
+bddBdd::reclaimInOp()
 {
-  unsigned lCacheIndex;
-  unsigned lResult;
-
-  // Terminal cases.
-  if(pRoot1 == 1)
+  if(isParallel()  ||  mRefCnts != 0)
   {
-    return true;
+    return;
   }
-  if(pRoot2 == 0)
+  mGcInOp = true;
+  gcMinor();
+  if(mFreeNr < mMaxNodeNr / 4)
   {
-    return true;
+    gc();
   }
-  if(pRoot1 == pRoot2)
+  if(mReorderThreshold != 0  &&  mGcLiveNr > mReorderThreshold)
   {
-    return true;
+    mReorderDue = true;
   }
-  if(pRoot1 == 0) // Assumes pRoot2 != 0.
+  if(mFreeNr < mMaxNodeNr / 4  &&  grow())
   {
-    return false;
+    gc();
   }
-  if(pRoot2 == 1) // Assumes pRoot1 != 1.
+  mGcInOp = false;
+  ++mResumeNr;
+}
+
+/// Provides free nodes after insert() failed, although reclaimInOp() ran,
+///   before the operation is restarted:
+///   Collects the young generation, or all garbage if this leaves 
+///   less than a quarter of the nodes free. Grows the node array 
+///   if less than a quarter of the nodes is free afterwards, 
+///   or if a previous try (pTry > 0) of the same operation failed already.
+/// Aborts the program if the operation failed before 
+///   and the node array cannot grow any more.
+void 
+bddBdd::reclaim(unsigned pTry)
+{
+  if(pTry == 0)
   {
-    return false;
+    gcMinor();
   }
-  
-  // Result in Cache?
-  lCacheIndex = hash(mSetContains, pRoot1, pRoot2, mBinCBitNr);
-  if(mBinCache[lCacheIndex].op == mSetContains
-    && mBinCache[lCacheIndex].root1 == pRoot1
-    && mBinCache[lCacheIndex].root2 == pRoot2) 
+  if(pTry > 0  ||  mFreeNr < mMaxNodeNr / 4)
   {
-    return mBinCache[lCacheIndex].result;
+    gc();
   }
-
-  // Compute result.
-  if(mNodes[pRoot1].var < mNodes[pRoot2].var)
+  if(mReorderThreshold != 0  &&  mGcLiveNr > mReorderThreshold)
   {
-    lResult = setContains_(mNodes[pRoot1].low, pRoot2)
-      && setContains_(mNodes[pRoot1].high, pRoot2);
+    mReorderDue = true;
   }
-  else 
+  if(pTry > 0  ||  mFreeNr < mMaxNodeNr / 4)
   {
-    if(mNodes[pRoot1].var == mNodes[pRoot2].var)
+    if(grow())
     {
-      lResult = setContains_(mNodes[pRoot1].low, mNodes[pRoot2].low)
-        && setContains_(mNodes[pRoot1].high, mNodes[pRoot2].high);
+      gc();
     }
-    else 
+    else if(pTry > 0  ||  mFreeNr == 0)
     {
-      lResult = setContains_(pRoot1, mNodes[pRoot2].low)
-        && setContains_(pRoot1, mNodes[pRoot2].high);
+      cerr << "Error: BDD package out of memory." << endl;
+      exit(EXIT_FAILURE);
     }
   }
+}
 
-  // Write result into cache.
-  mBinCache[lCacheIndex].result = lResult;
-  mBinCache[lCacheIndex].op = mSetContains;
-  mBinCache[lCacheIndex].root1 = pRoot1;
-  mBinCache[lCacheIndex].root2 = pRoot2;
 
-  return lResult;
+/// Adds a search in mUniqueHash that visited pProbeNr buckets 
+///   to the statistics.
+inline void
+bddBdd::countProbes(unsigned pProbeNr, bddProbeCounts& pCounts)
+{
+  ++pCounts.lookupNr;
+  pCounts.probeNr += pProbeNr;
+  if(pProbeNr > pCounts.probeMax)
+  {
+    pCounts.probeMax = pProbeNr;
+  }
 }
 
-unsigned 
-bddBdd::complement_(unsigned pRoot) 
+/// Searches mUniqueHash, from the home bucket on 
+///   until a bucket that never overflowed.
+unsigned
+bddBdd::findNode(unsigned pVar, unsigned pLow, unsigned pHigh, 
+                 unsigned pHash, bool pShared)
 {
-  unsigned lCacheIndex;
-  unsigned lResult;
+  const unsigned short lTag = getTag(pHash);
+  const unsigned lMask = (1u << mUniqueHBitNr) - 1;
+  unsigned lBucket = pHash >> (32 - mUniqueHBitNr);
+  bddProbeCounts& lCounts 
+    = pShared ? mThreadProbeCounts[mPool.getIndex()] : mProbeCounts;
+  for(unsigned lProbeNr = 1; ; ++lProbeNr)
+  {
+    const bddUniqueBucket& lCurBucket = mUniqueHash[lBucket];
+    unsigned lMatch = pShared ? lCurBucket.matchShared(lTag) 
+                              : lCurBucket.match(lTag);
+    for(unsigned lSlot = 0; lMatch != 0; ++lSlot, lMatch >>= 1)
+    {
+      const unsigned lNode = lCurBucket.nodes[lSlot];
+      if(   (lMatch & 1)
+         && mNodes[lNode].var == pVar 
+         && mNodes[lNode].low == pLow
+         && mNodes[lNode].high == pHigh) 
+      {
+        countProbes(lProbeNr, lCounts);
+        return lNode;
+      }
+    }
+    if(pShared ? !lCurBucket.isOverflowShared() : !lCurBucket.overflow)
+    {
+      countProbes(lProbeNr, lCounts);
+      return 0;
+    }
+    lBucket = (lBucket + 1) & lMask;
+  }
+}
 
-  if(pRoot == 0)
+/// Returns the edge to the node with the passed var-, low- and
+/// high-edges. If such node does not exists, it is inserted into
+/// mNodes and mUniqueHash. If there are no free nodes left, throws exception.
+unsigned 
+bddBdd::insert(unsigned pVar, unsigned pLow, unsigned pHigh) 
+{
+  // BDD-reduction of nodes with equal high- and low-child.
+  if(pHigh == pLow) 
   {
-    return 1;
+    return pLow;
   }
-  if(pRoot == 1)
+
+  // Canonical form: The low edge of a stored node is regular.
+  //   Store the negated node and return a complemented edge instead.
+  if(pLow & 1)
   {
-    return 0;
+    return insert(pVar, pLow ^ 1, pHigh ^ 1) ^ 1;
   }
 
-  lCacheIndex = hash(mComplement, pRoot, pRoot, mBinCBitNr);
-  if(mBinCache[lCacheIndex].op == mComplement
-    && mBinCache[lCacheIndex].root1 == pRoot) 
+  const unsigned lHash = hash(pVar, pLow, pHigh);
+  if(isParallel())
   {
-    return mBinCache[lCacheIndex].result;
+    return insertShared(pVar, pLow, pHigh, lHash);
+  }
+  const unsigned lNode = findNode(pVar, pLow, pHigh, lHash, false);
+  if(lNode != 0)
+  {
+    return protect(lNode << 1);
   }
 
-  lResult = insert(mNodes[pRoot].var,
-                   complement_(mNodes[pRoot].low), 
-                   complement_(mNodes[pRoot].high));
-
-  mBinCache[lCacheIndex].result = lResult;
-  mBinCache[lCacheIndex].op = mComplement;
-  mBinCache[lCacheIndex].root1 = pRoot;
+  // Create new node.
+  if(mFree == 0)
+  {
+    reclaimInOp();
+  }
+  if(mFree == 0)
+  {
+    throw "Error: BDD package out of memory\n";
+  }
+
+  const unsigned lResult = mFree;
+  mFree = mNodes[lResult].low;
+  --mFreeNr;
+  ++mCreatedNr;
+  mNodes[lResult].var = pVar;
+  mNodes[lResult].low = pLow;
+  mNodes[lResult].high = pHigh;
+  hashInsert(lResult);
+
+  return protect(lResult << 1);
+}
+
+/// Like insert(), during parallel operations (pLow regular, pLow != pHigh).
+///   The lock of the home bucket serialises the insertions of equal nodes,
+///   lookups and insertions of other nodes do not wait.
+unsigned 
+bddBdd::insertShared(unsigned pVar, unsigned pLow, unsigned pHigh, 
+                     unsigned pHash) 
+{
+  int& lLock = mUniqueHash[pHash >> (32 - mUniqueHBitNr)].lock;
+  bddLock(lLock);
+  const unsigned lNode = findNode(pVar, pLow, pHigh, pHash, true);
+  if(lNode != 0)
+  {
+    bddUnlock(lLock);
+    return lNode << 1;
+  }
+
+  // Create new node.
+  bddLock(mFreeLock);
+  if(mFree == 0)
+  {
+    bddUnlock(mFreeLock);
+    bddUnlock(lLock);
+    throw "Error: BDD package out of memory\n";
+  }
+  const unsigned lResult = mFree;
+  mFree = mNodes[lResult].low;
+  --mFreeNr;
+  ++mCreatedNr;
+  bddUnlock(mFreeLock);
+
+  mNodes[lResult].var = pVar;
+  mNodes[lResult].low = pLow;
+  mNodes[lResult].high = pHigh;
+  hashInsert(lResult);
+  bddUnlock(lLock);
+
+  return lResult << 1;
+}
+
+/// Removes node pNode from mUniqueHash.
+///   The overflow flags remain set until the table is rebuilt by gc().
+void
+bddBdd::hashRemove(unsigned pNode)
+{
+  const unsigned lMask = (1u << mUniqueHBitNr) - 1;
+  unsigned lBucket = hash(mNodes[pNode].var, mNodes[pNode].low, 
+                          mNodes[pNode].high) >> (32 - mUniqueHBitNr);
+  for(;;)
+  {
+    bddUniqueBucket& lCurBucket = mUniqueHash[lBucket];
+    for(unsigned lSlot = 0; lSlot < lCurBucket.count; ++lSlot)
+    {
+      if(lCurBucket.nodes[lSlot] == pNode)
+      {
+        lCurBucket.remove(lSlot);
+        return;
+      }
+    }
+    // Otherwise the node is not in the hash table.
+    assert(lCurBucket.overflow);
+    lBucket = (lBucket + 1) & lMask;
+  }
+}
+
+/// Inserts node pNode into the first empty slot of mUniqueHash,
+///   from its home bucket on. Marks the full buckets on the way.
+/// In parallel operations, other threads may insert into the same buckets.
+void
+bddBdd::hashInsert(unsigned pNode)
+{
+  const unsigned lHash 
+    = hash(mNodes[pNode].var, mNodes[pNode].low, mNodes[pNode].high);
+  const unsigned lMask = (1u << mUniqueHBitNr) - 1;
+  unsigned lBucket = lHash >> (32 - mUniqueHBitNr);
+  const bool lShared = isParallel();
+  for(;;)
+  {
+    bddUniqueBucket& lCurBucket = mUniqueHash[lBucket];
+    if(lShared)
+    {
+      if(lCurBucket.addShared(pNode, getTag(lHash)))
+      {
+        return;
+      }
+      lCurBucket.setOverflowShared();
+    }
+    else if(lCurBucket.count < bddUniqueBucket::mSlotNr)
+    {
+      lCurBucket.add(pNode, getTag(lHash));
+      return;
+    }
+    else
+    {
+      lCurBucket.overflow = 1;
+    }
+    lBucket = (lBucket + 1) & lMask;
+  }
+}
+
+/// Check if there is any BDD node between the variable ids.
+/// Returns 'true' if any such node is found.
+bool 
+bddBdd::testVars(unsigned pVarIdFirst, unsigned pVarIdLast) const
+{
+  ++mCallNr[mSupport];
+  const unsigned lNode = getNode(getSupportNode_(mRoot, pVarIdFirst));
+  return lNode != 0  &&  mNodes[lNode].var <= pVarIdLast;
+}
+
+/// Returns the edge to a node of the BDD with root pRoot with the 
+///   smallest variable id >= pVarId, or 0 if there is no such node.
+/// The nodes below a node have greater variable ids, 
+///   thus only the nodes with variable ids < pVarId are traversed.
+/// The result is cached as edge, such that garbage collection and 
+///   compaction treat it like the results of the other operations.
+unsigned
+bddBdd::getSupportNode_(unsigned pRoot, unsigned pVarId)
+{
+  const unsigned lNode = getNode(pRoot);
+  if(lNode == 0  ||  mNodes[lNode].var >= pVarId)
+  {
+    return lNode << 1;
+  }
+  unsigned lResult;
+  if(mVarCache.lookup(mSupport, lNode << 1, pVarId, 0, lResult))
+  {
+    return lResult;
+  }
+  const unsigned lLow = getSupportNode_(mNodes[lNode].low, pVarId);
+  const unsigned lHigh = getSupportNode_(mNodes[lNode].high, pVarId);
+  if(lLow == 0  
+     ||  (lHigh != 0  &&  mNodes[lHigh >> 1].var < mNodes[lLow >> 1].var))
+  {
+    lResult = lHigh;
+  }
+  else
+  {
+    lResult = lLow;
+  }
+  mVarCache.insert(mSupport, lNode << 1, pVarId, 0, lResult);
+  return lResult;
+}
+
+/// Returns the fraction of all variable assignments which satisfy 
+/// the BDD with root pRoot, as mantissa * 2^pExponent.
+/// Both polarities of a node are cached separately (the cache is keyed 
+/// by edges), because computing 1 - x for the complement would lose 
+/// the precision for sparse relations.
+double 
+bddBdd::getDensity_(unsigned pRoot, int& pExponent)
+{
+  // Terminal case.
+  if(getNode(pRoot) == 0)
+  {
+    pExponent = 0;
+    return (pRoot == 0 ? 0.0 : 1.0);
+  }
+
+  // Result in cache?
+  bddStatEntry::Result lResult;
+  if(mStatCache.lookup(mDensity, pRoot, 0, 0, lResult))
+  {
+    pExponent = lResult.exponent;
+    return lResult.value;
+  }
+
+  // Halving is exact for doubles, thus the sum is as precise as 
+  //   counting the tuples directly. Each level halves the density,
+  //   thus the exponent is kept apart and the mantissa normalized.
+  int lLowExp;
+  int lHighExp;
+  const double lLow = getDensity_(getLow(pRoot), lLowExp);
+  const double lHigh = getDensity_(getHigh(pRoot), lHighExp);
+  int lExp = (lLow == 0.0) ? lHighExp
+           : (lHigh == 0.0) ? lLowExp
+           : max(lLowExp, lHighExp);
+  lResult.value 
+    = frexp(ldexp(lLow, lLowExp - lExp) + ldexp(lHigh, lHighExp - lExp), 
+            &lResult.exponent);
+  lResult.exponent += lExp - 1;
+  mStatCache.insert(mDensity, pRoot, 0, 0, lResult);
+
+  pExponent = lResult.exponent;
+  return lResult.value;
+}
+
+/// Returns the elements pVar ... pMaxVar of an arbitrary tuple of the BDD.
+unsigned 
+bddBdd::getTuple_(unsigned pRoot, unsigned pVar, unsigned pMaxVar)
+{
+  // Terminal case.
+  if(pVar > pMaxVar)
+  {
+    return 0;
+  }
+
+  // pVar <= pMaxVar.
+
+  // Reduced node?
+  if(pVar < getVar(pRoot))
+  {
+    return getTuple_(pRoot, pVar + 1, pMaxVar);
+  }
+
+  if(pVar > getVar(pRoot))
+  {
+    if (getLow(pRoot) != 0) {
+      return getTuple_(getLow(pRoot), pVar, pMaxVar);
+    } else { 
+      return getTuple_(getHigh(pRoot), pVar, pMaxVar);
+    } 
+  }
+
+  // pVar == getVar(pRoot).
+
+  if (getLow(pRoot) != 0) {
+    return getTuple_(getLow(pRoot), pVar + 1, pMaxVar);
+  } else { 
+    return getTuple_(getHigh(pRoot), pVar + 1, pMaxVar)
+      + (1 << (pMaxVar - pVar));
+  } 
+}
+
+/// Returns number of nodes of the BDD with root pRoot that are not 
+/// stamped with pEpoch yet, and stamps them.
+/// (Terminal nodes are not counted).
+unsigned 
+bddBdd::getNodeNr_(unsigned pRoot, unsigned short pEpoch) 
+{
+  unsigned lResult = 0;
+  vector<unsigned> lStack;
+  if(visit(getNode(pRoot), pEpoch))
+  {
+    lStack.push_back(getNode(pRoot));
+  }
+  while(!lStack.empty())
+  {
+    const bddNode& lNode = mNodes[lStack.back()];
+    lStack.pop_back();
+    ++lResult;
+    if(visit(getNode(lNode.low), pEpoch))
+    {
+      lStack.push_back(getNode(lNode.low));
+    }
+    if(visit(getNode(lNode.high), pEpoch))
+    {
+      lStack.push_back(getNode(lNode.high));
+    }
+  }
+  return lResult;
+}
+
+/// Computes the number of nodes per variable id.
+void 
+bddBdd::getNodesPerVarId_(unsigned pRoot, 
+                          map<unsigned, unsigned>& pBddNodesPerVar,
+                          unsigned short pEpoch)
+{
+  vector<unsigned> lStack;
+  if(visit(getNode(pRoot), pEpoch))
+  {
+    lStack.push_back(getNode(pRoot));
+  }
+  while(!lStack.empty())
+  {
+    const bddNode& lNode = mNodes[lStack.back()];
+    lStack.pop_back();
+    ++pBddNodesPerVar[lNode.var];
+    if(visit(getNode(lNode.low), pEpoch))
+    {
+      lStack.push_back(getNode(lNode.low));
+    }
+    if(visit(getNode(lNode.high), pEpoch))
+    {
+      lStack.push_back(getNode(lNode.high));
+    }
+  }
+}
+
+/// Creates output graph representation for BDD with root pRoot.
+/// Complemented edges are expanded, i.e., each polarity of a node
+///   is a separate graph node, with the edge as id.
+void 
+bddBdd::getGraph_(unsigned pRoot, 
+                  multimap<unsigned,bddGraphNode>& pGraph,
+                  set<unsigned>& pVisited)
+{
+  vector<unsigned> lStack;
+  lStack.push_back(pRoot);
+  while(!lStack.empty())
+  {
+    const unsigned lEdge = lStack.back();
+    lStack.pop_back();
+    if( getNode(lEdge) != 0  &&  pVisited.insert(lEdge).second )
+    {
+      bddGraphNode node;
+      node.id   = lEdge;
+      node.var  = getVar(lEdge);
+      node.low  = getLow(lEdge);
+      node.high = getHigh(lEdge);
+      pGraph.insert( pair<unsigned,bddGraphNode>(node.var, node) );
+
+      lStack.push_back(node.high);
+      lStack.push_back(node.low);
+    }
+  }
+}
+
+/// Prints BDD with root pRoot as reduced binary decision tree.
+void 
+bddBdd::print_(ostream& pS, unsigned pRoot)
+{
+  if(pRoot == 1) 
+  {
+    cout << 'T';
+  }
+  else 
+  {
+    if(pRoot == 0)
+    {
+      cout << 'F';
+    }
+    else 
+    {
+      cout << '(';
+      print_(pS, getLow(pRoot));
+      cout << ' ' << getVar(pRoot) << ' ';
+      print_(pS, getHigh(pRoot));
+      cout << ')';
+    }
+  }
+}
+
+/// Checks if pRoot2 represents a subset of pRoot1
+bool 
+bddBdd::setContains_(unsigned pRoot1, unsigned pRoot2) 
+{
+  unsigned lResult;
+
+  // Terminal cases.
+  if(pRoot1 == 1)
+  {
+    return true;
+  }
+  if(pRoot2 == 0)
+  {
+    return true;
+  }
+  if(pRoot1 == pRoot2)
+  {
+    return true;
+  }
+  if(pRoot1 == 0) // Assumes pRoot2 != 0.
+  {
+    return false;
+  }
+  if(pRoot2 == 1) // Assumes pRoot1 != 1.
+  {
+    return false;
+  }
+  if(pRoot1 == (pRoot2 ^ 1)) // Assumes pRoot2 != 0.
+  {
+    return false;
+  }
+  
+  // Result in Cache?
+  if(mApplyCache.lookup(mSetContains, pRoot1, pRoot2, 0, lResult))
+  {
+    return lResult;
+  }
+
+  // Compute result.
+  if(getVar(pRoot1) < getVar(pRoot2))
+  {
+    lResult = setContains_(getLow(pRoot1), pRoot2)
+      && setContains_(getHigh(pRoot1), pRoot2);
+  }
+  else 
+  {
+    if(getVar(pRoot1) == getVar(pRoot2))
+    {
+      lResult = setContains_(getLow(pRoot1), getLow(pRoot2))
+        && setContains_(getHigh(pRoot1), getHigh(pRoot2));
+    }
+    else 
+    {
+      lResult = setContains_(pRoot1, getLow(pRoot2))
+        && setContains_(pRoot1, getHigh(pRoot2));
+    }
+  }
+
+  // Write result into cache.
+  mApplyCache.insert(mSetContains, pRoot1, pRoot2, 0, lResult);
+
+  return lResult;
+}
+
+/// Dispatches the operations that mPool executes in parallel.
+unsigned
+bddBdd::apply_(unsigned pOp, 
+               unsigned pArg1, unsigned pArg2, unsigned pArg3, 
+               unsigned pFork)
+{
+  if(pOp == mAndExists)
+  {
+    return andExists_(pArg1, pArg2, pArg3, pFork);
+  }
+  assert(pOp == mIntersect);
+  return intersect_(pArg1, pArg2, pFork);
+}
+
+/// Executes a task of mPool, possibly in a worker thread.
+///   An exception (out of nodes) fails the task, and the thread 
+///   that joins the task rethrows it.
+void
+bddBdd::runTask(bddTask* pTask)
+{
+  try
+  {
+    pTask->result = apply_(pTask->op, 
+                           pTask->arg1, pTask->arg2, pTask->arg3, 
+                           pTask->fork);
+  }
+  catch(...)
+  {
+    pTask->failed = true;
+  }
+}
+
+/// Computes operation pOp for the low cofactors, and in parallel
+///   (as task for idle threads) for the high cofactors.
+/// The task is joined before the function returns, also by exception,
+///   because it lives on the stack.
+void
+bddBdd::forkSons_(unsigned pOp, 
+                  unsigned pLow1, unsigned pLow2, 
+                  unsigned pHigh1, unsigned pHigh2, 
+                  unsigned pArg3, unsigned pFork,
+                  unsigned& pLow, unsigned& pHigh)
+{
+  bddTask lTask;
+  lTask.op = pOp;
+  lTask.arg1 = pHigh1;
+  lTask.arg2 = pHigh2;
+  lTask.arg3 = pArg3;
+  lTask.fork = pFork - 1;
+  mPool.push(&lTask);
+  try
+  {
+    pLow = apply_(pOp, pLow1, pLow2, pArg3, pFork - 1);
+  }
+  catch(...)
+  {
+    mPool.join(&lTask, false);
+    throw;
+  }
+  mPool.join(&lTask, true);
+  if(lTask.failed)
+  {
+    throw "Error: BDD package out of memory\n";
+  }
+  pHigh = lTask.result;
+}
+
+/// Switches the caches, mUniqueHash and mPool to parallel operation 
+///   (only during the operation, to keep sequential code fast), 
+///   and computes operation pOp with mForkDepth levels of forking.
+unsigned
+bddBdd::parallel_(unsigned pOp, unsigned pArg1, unsigned pArg2, unsigned pArg3)
+{
+  if(mForkDepth == 0)
+  {
+    return apply_(pOp, pArg1, pArg2, pArg3, 0);
+  }
+  setParallel(true);
+  unsigned lResult;
+  try
+  {
+    lResult = apply_(pOp, pArg1, pArg2, pArg3, mForkDepth);
+  }
+  catch(...)
+  {
+    setParallel(false);
+    throw;
+  }
+  setParallel(false);
+  return lResult;
+}
+
+/// Switches to resp. from parallel operation.
+void
+bddBdd::setParallel(bool pParallel)
+{
+  __atomic_store_n(&mParallel, pParallel, __ATOMIC_RELEASE);
+  mApplyCache.setShared(pParallel, mPool);
+  mQuantCache.setShared(pParallel, mPool);
+  mAndExistsCache.setShared(pParallel, mPool);
+  mIteCache.setShared(pParallel, mPool);
+  mVarCache.setShared(pParallel, mPool);
+  mStatCache.setShared(pParallel, mPool);
+  if(pParallel)
+  {
+    const bddProbeCounts lZero = { 0, 0, 0 };
+    mThreadProbeCounts.assign(mPool.getThreadNr(), lZero);
+  }
+  else
+  {
+    for(unsigned lCnt = 0; lCnt < mThreadProbeCounts.size(); ++lCnt)
+    {
+      const bddProbeCounts& lCounts = mThreadProbeCounts[lCnt];
+      mProbeCounts.lookupNr += lCounts.lookupNr;
+      mProbeCounts.probeNr += lCounts.probeNr;
+      mProbeCounts.probeMax = max(mProbeCounts.probeMax, lCounts.probeMax);
+    }
+    mThreadProbeCounts.clear();
+  }
+  // Synchronises the memory with the workers.
+  mPool.setActive(pParallel);
+}
+
+/// Complement is a flip of the complement bit of the edge.
+unsigned 
+bddBdd::complement_(unsigned pRoot) 
+{
+  return pRoot ^ 1;
+}
+
+/// Union by De Morgan: A | B == !(!A & !B).
+///   Shares the cache entries with intersect_().
+unsigned 
+bddBdd::unite_(unsigned pRoot1, unsigned pRoot2, unsigned pFork) 
+{
+  return intersect_(pRoot1 ^ 1, pRoot2 ^ 1, pFork) ^ 1;
+}
+
+unsigned 
+bddBdd::intersect_(unsigned pRoot1, unsigned pRoot2, unsigned pFork) 
+{
+  if(pRoot1 == 0) 
+  {
+    return 0;
+  }
+  if(pRoot2 == 0) 
+  {
+    return 0;
+  }
+  if(pRoot1 == 1) 
+  {
+    return pRoot2;
+  }
+  if(pRoot2 == 1) 
+  {
+    return pRoot1;
+  }
+  if(pRoot1 == pRoot2)
+  {
+    return pRoot1;
+  }
+  if(pRoot1 == (pRoot2 ^ 1))
+  {
+    return 0;
+  }
+
+  // Load the nodes while the cache is searched.
+  BDD_PREFETCH(&mNodes[getNode(pRoot1)]);
+  BDD_PREFETCH(&mNodes[getNode(pRoot2)]);
+  normalize(pRoot1, pRoot2);
+  unsigned lResult;
+  if(mApplyCache.lookup(mIntersect, pRoot1, pRoot2, 0, lResult))
+  {
+    return protect(lResult);
+  }
+
+  if(pFork > 0)
+  {
+    // Cofactors with respect to the top variable.
+    unsigned lVar = getVar(pRoot1);
+    if(getVar(pRoot2) < lVar)
+    {
+      lVar = getVar(pRoot2);
+    }
+    unsigned lLow1  = pRoot1;
+    unsigned lHigh1 = pRoot1;
+    if(getVar(pRoot1) == lVar)
+    {
+      lLow1  = getLow(pRoot1);
+      lHigh1 = getHigh(pRoot1);
+    }
+    unsigned lLow2  = pRoot2;
+    unsigned lHigh2 = pRoot2;
+    if(getVar(pRoot2) == lVar)
+    {
+      lLow2  = getLow(pRoot2);
+      lHigh2 = getHigh(pRoot2);
+    }
+    unsigned lLow;
+    unsigned lHigh;
+    forkSons_(mIntersect, lLow1, lLow2, lHigh1, lHigh2, 0, pFork, 
+              lLow, lHigh);
+    lResult = insert(lVar, lLow, lHigh);
+  }
+  else if(getVar(pRoot1) < getVar(pRoot2)) 
+  {
+    lResult = insert(getVar(pRoot1),
+                     intersect_(getLow(pRoot1), pRoot2), 
+                     intersect_(getHigh(pRoot1), pRoot2));
+  }
+  else 
+  {
+    if(getVar(pRoot1) == getVar(pRoot2))
+    {
+      lResult = insert(getVar(pRoot1),
+                       intersect_(getLow(pRoot1), getLow(pRoot2)), 
+                       intersect_(getHigh(pRoot1), getHigh(pRoot2)));
+    }
+    else 
+    {
+      lResult = insert(getVar(pRoot2),
+                       intersect_(pRoot1, getLow(pRoot2)), 
+                       intersect_(pRoot1, getHigh(pRoot2)));
+    }
+  }
+
+  mApplyCache.insert(mIntersect, pRoot1, pRoot2, 0, lResult);
+
+  return lResult;
+}
+
+unsigned 
+bddBdd::exists_(unsigned pRoot, unsigned pVar)
+{
+  unsigned lResult;
+
+  if(getVar(pRoot) < pVar)
+  {
+    if(mVarCache.lookup(mExists, pRoot, pVar, 0, lResult))
+    {
+      return protect(lResult);
+    }
+
+    lResult = insert(getVar(pRoot),
+                     exists_(getLow(pRoot), pVar), 
+                     exists_(getHigh(pRoot), pVar));
+
+    mVarCache.insert(mExists, pRoot, pVar, 0, lResult);
+  }
+  else 
+  { 
+    if(getVar(pRoot) == pVar)
+    {
+      lResult = unite_(getLow(pRoot), getHigh(pRoot));
+    }
+    else
+    {
+      lResult = pRoot;
+    }
+  }
+
+  return lResult;
+}
+
+/// Existential quantification of all variables of the cube pCube.
+///   The cube is a conjunction of positive literals, i.e., its nodes 
+///   have the low edge 0, and the high edges form the list of variables.
+unsigned 
+bddBdd::existsCube_(unsigned pRoot, unsigned pCube)
+{
+  // Terminal case.
+  if(getNode(pRoot) == 0)
+  {
+    return pRoot;
+  }
+
+  // Skip the variables of the cube that do not occur below pRoot.
+  while(getVar(pCube) < getVar(pRoot))
+  {
+    pCube = getHigh(pCube);
+  }
+  if(pCube == 1)
+  {
+    // No variables left to quantify.
+    return pRoot;
+  }
+
+  unsigned lResult;
+  if(mQuantCache.lookup(mExistsCube, pRoot, pCube, 0, lResult))
+  {
+    return protect(lResult);
+  }
+
+  if(getVar(pCube) == getVar(pRoot))
+  {
+    // Quantified variable: Union of the cofactors.
+    //   The high cofactor is not needed if the low one is already the full set.
+    unsigned lCube = getHigh(pCube);
+    lResult = existsCube_(getLow(pRoot), lCube);
+    if(lResult != 1)
+    {
+      lResult = unite_(lResult, existsCube_(getHigh(pRoot), lCube));
+    }
+  }
+  else
+  {
+    lResult = insert(getVar(pRoot),
+                     existsCube_(getLow(pRoot), pCube),
+                     existsCube_(getHigh(pRoot), pCube));
+  }
+
+  mQuantCache.insert(mExistsCube, pRoot, pCube, 0, lResult);
+
+  return lResult;
+}
+
+/// Universal quantification by duality: FA(v, A) == !EX(v, !A).
+///   Shares the cache entries with existsCube_().
+unsigned 
+bddBdd::forallCube_(unsigned pRoot, unsigned pCube)
+{
+  return existsCube_(pRoot ^ 1, pCube) ^ 1;
+}
+
+/// Relational product: Existential quantification of the variables 
+///   of the cube pCube in the intersection of pRoot1 and pRoot2.
+unsigned 
+bddBdd::andExists_(unsigned pRoot1, unsigned pRoot2, unsigned pCube, 
+                   unsigned pFork)
+{
+  // Terminal cases.
+  if(pRoot1 == 0  ||  pRoot2 == 0  ||  pRoot1 == (pRoot2 ^ 1))
+  {
+    return 0;
+  }
+  // A & 1 == A & A == A: Plain quantification of A.
+  if(pRoot1 == 1  ||  pRoot1 == pRoot2)
+  {
+    return existsCube_(pRoot2, pCube);
+  }
+  if(pRoot2 == 1)
+  {
+    return existsCube_(pRoot1, pCube);
+  }
+
+  unsigned lVar = getVar(pRoot1);
+  if(getVar(pRoot2) < lVar)
+  {
+    lVar = getVar(pRoot2);
+  }
+  // Skip the variables of the cube that occur in neither argument.
+  while(getVar(pCube) < lVar)
+  {
+    pCube = getHigh(pCube);
+  }
+  if(pCube == 1)
+  {
+    // No variables left to quantify.
+    return intersect_(pRoot1, pRoot2, pFork);
+  }
+
+  normalize(pRoot1, pRoot2);
+  unsigned lResult;
+  if(mAndExistsCache.lookup(mAndExists, pRoot1, pRoot2, pCube, lResult))
+  {
+    return protect(lResult);
+  }
+
+  // Cofactors with respect to the top variable.
+  unsigned lLow1  = pRoot1;
+  unsigned lHigh1 = pRoot1;
+  if(getVar(pRoot1) == lVar)
+  {
+    lLow1  = getLow(pRoot1);
+    lHigh1 = getHigh(pRoot1);
+  }
+  unsigned lLow2  = pRoot2;
+  unsigned lHigh2 = pRoot2;
+  if(getVar(pRoot2) == lVar)
+  {
+    lLow2  = getLow(pRoot2);
+    lHigh2 = getHigh(pRoot2);
+  }
+
+  if(pFork > 0)
+  {
+    // Both cofactors in parallel, even if the high one is not needed.
+    const unsigned lCube = (getVar(pCube) == lVar) ? getHigh(pCube) : pCube;
+    unsigned lLow;
+    unsigned lHigh;
+    forkSons_(mAndExists, lLow1, lLow2, lHigh1, lHigh2, lCube, pFork, 
+              lLow, lHigh);
+    if(getVar(pCube) == lVar)
+    {
+      lResult = unite_(lLow, lHigh, pFork - 1);
+    }
+    else
+    {
+      lResult = insert(lVar, lLow, lHigh);
+    }
+  }
+  else if(getVar(pCube) == lVar)
+  {
+    // Quantified variable: Union of the cofactors.
+    //   The high cofactor is not needed if the low one is already the full set.
+    unsigned lCube = getHigh(pCube);
+    lResult = andExists_(lLow1, lLow2, lCube);
+    if(lResult != 1)
+    {
+      lResult = unite_(lResult, andExists_(lHigh1, lHigh2, lCube));
+    }
+  }
+  else
+  {
+    lResult = insert(lVar,
+                     andExists_(lLow1, lLow2, pCube),
+                     andExists_(lHigh1, lHigh2, pCube));
+  }
+
+  mAndExistsCache.insert(mAndExists, pRoot1, pRoot2, pCube, lResult);
+
+  return lResult;
+}
+
+/// Symmetric difference. The complement bits of the arguments 
+///   move to the result, because !A ^ B == A ^ !B == !(A ^ B).
+///   Thus the cache holds only regular arguments.
+unsigned 
+bddBdd::xor_(unsigned pRoot1, unsigned pRoot2)
+{
+  const unsigned lNeg = (pRoot1 ^ pRoot2) & 1;
+  pRoot1 &= ~1u;
+  pRoot2 &= ~1u;
+
+  // Terminal cases. The regular edge to the terminal is 0.
+  if(pRoot1 == 0)
+  {
+    return pRoot2 ^ lNeg;
+  }
+  if(pRoot2 == 0)
+  {
+    return pRoot1 ^ lNeg;
+  }
+  if(pRoot1 == pRoot2)
+  {
+    return lNeg;
+  }
+
+  normalize(pRoot1, pRoot2);
+  unsigned lResult;
+  if(mApplyCache.lookup(mXor, pRoot1, pRoot2, 0, lResult))
+  {
+    return protect(lResult) ^ lNeg;
+  }
+
+  // Cofactors with respect to the top variable.
+  unsigned lVar = getVar(pRoot1);
+  if(getVar(pRoot2) < lVar)
+  {
+    lVar = getVar(pRoot2);
+  }
+  unsigned lLow1  = pRoot1;
+  unsigned lHigh1 = pRoot1;
+  if(getVar(pRoot1) == lVar)
+  {
+    lLow1  = getLow(pRoot1);
+    lHigh1 = getHigh(pRoot1);
+  }
+  unsigned lLow2  = pRoot2;
+  unsigned lHigh2 = pRoot2;
+  if(getVar(pRoot2) == lVar)
+  {
+    lLow2  = getLow(pRoot2);
+    lHigh2 = getHigh(pRoot2);
+  }
+
+  lResult = insert(lVar, xor_(lLow1, lLow2), xor_(lHigh1, lHigh2));
 
-  return lResult;
+  mApplyCache.insert(mXor, pRoot1, pRoot2, 0, lResult);
+
+  return lResult ^ lNeg;
 }
 
+/// If-then-else: (pIf & pThen) | (!pIf & pElse).
+///   Cases that are binary operations use their kernels and caches.
 unsigned 
-bddBdd::unite_(unsigned pRoot1, unsigned pRoot2) 
+bddBdd::ite_(unsigned pIf, unsigned pThen, unsigned pElse)
 {
-  if(pRoot1 == 1) 
+  // Terminal cases.
+  if(pIf == 1)
   {
-    return 1;
+    return pThen;
   }
-  if(pRoot2 == 1) 
+  if(pIf == 0)
   {
-    return 1;
+    return pElse;
   }
-  if(pRoot1 == 0)
+  // Within the branches, the condition is a constant.
+  if(pThen == pIf)
   {
-    return pRoot2;
+    pThen = 1;
   }
-  if(pRoot2 == 0)
+  else if(pThen == (pIf ^ 1))
   {
-    return pRoot1;
+    pThen = 0;
   }
-  if(pRoot1 == pRoot2)
+  if(pElse == pIf)
   {
-    return pRoot1;
+    pElse = 0;
+  }
+  else if(pElse == (pIf ^ 1))
+  {
+    pElse = 1;
+  }
+  if(pThen == pElse)
+  {
+    return pThen;
   }
 
-  normalize(pRoot1, pRoot2);
+  // Binary operations.
+  if(pThen == 1)
+  {
+    return unite_(pIf, pElse);
+  }
+  if(pThen == 0)
+  {
+    return intersect_(pIf ^ 1, pElse);
+  }
+  if(pElse == 1)
+  {
+    return unite_(pIf ^ 1, pThen);
+  }
+  if(pElse == 0)
+  {
+    return intersect_(pIf, pThen);
+  }
+  if(pThen == (pElse ^ 1))
+  {
+    return xor_(pIf, pElse);
+  }
+
+  // Canonical form: Regular condition (exchange the branches otherwise),
+  //   and regular then-branch (negate the result otherwise).
+  if(pIf & 1)
+  {
+    pIf ^= 1;
+    const unsigned lTmp = pThen;
+    pThen = pElse;
+    pElse = lTmp;
+  }
+  const unsigned lNeg = pThen & 1;
+  pThen ^= lNeg;
+  pElse ^= lNeg;
+
   unsigned lResult;
-  unsigned lCacheIndex = hash(mUnite, pRoot1, pRoot2, mBinCBitNr);
-  if (mBinCache[lCacheIndex].op == mUnite
-    && mBinCache[lCacheIndex].root1 == pRoot1
-    && mBinCache[lCacheIndex].root2 == pRoot2) 
+  if(mIteCache.lookup(mIte, pIf, pThen, pElse, lResult))
   {
-    return mBinCache[lCacheIndex].result;
+    return protect(lResult) ^ lNeg;
   }
 
-  if(mNodes[pRoot1].var < mNodes[pRoot2].var)
+  // Cofactors with respect to the top variable.
+  unsigned lVar = getVar(pIf);
+  if(getVar(pThen) < lVar)
   {
-    lResult = insert(mNodes[pRoot1].var,
-                     unite_(mNodes[pRoot1].low, pRoot2), 
-                     unite_(mNodes[pRoot1].high, pRoot2));
+    lVar = getVar(pThen);
   }
-  else 
+  if(getVar(pElse) < lVar)
+  {
+    lVar = getVar(pElse);
+  }
+  const bool lIfTop   = (getVar(pIf)   == lVar);
+  const bool lThenTop = (getVar(pThen) == lVar);
+  const bool lElseTop = (getVar(pElse) == lVar);
+
+  lResult = insert(lVar,
+                   ite_(lIfTop   ? getLow(pIf)    : pIf,
+                        lThenTop ? getLow(pThen)  : pThen,
+                        lElseTop ? getLow(pElse)  : pElse),
+                   ite_(lIfTop   ? getHigh(pIf)   : pIf,
+                        lThenTop ? getHigh(pThen) : pThen,
+                        lElseTop ? getHigh(pElse) : pElse));
+
+  mIteCache.insert(mIte, pIf, pThen, pElse, lResult);
+
+  return lResult ^ lNeg;
+}
+
+/// Cofactor of pRoot for the literals of the cube pCube.
+unsigned 
+bddBdd::restrict_(unsigned pRoot, unsigned pCube)
+{
+  // Literals above pRoot do not matter.
+  while(getVar(pCube) < getVar(pRoot))
+  {
+    pCube = (getLow(pCube) == 0) ? getHigh(pCube) : getLow(pCube);
+  }
+  // Terminal cases.
+  if(pCube == 1  ||  getNode(pRoot) == 0)
+  {
+    return pRoot;
+  }
+
+  // Cofactors commute with complement: Compute for the regular edge.
+  if(pRoot & 1)
+  {
+    return restrict_(pRoot ^ 1, pCube) ^ 1;
+  }
+
+  // Lookup cache.
+  unsigned lResult;
+  if(mApplyCache.lookup(mRestrict, pRoot, pCube, 0, lResult))
   {
-    if(mNodes[pRoot1].var == mNodes[pRoot2].var)
+    return protect(lResult);
+  }
+
+  if(getVar(pRoot) == getVar(pCube))
+  {
+    // Select the son for the literal.
+    if(getLow(pCube) == 0)
     {
-      lResult = insert(mNodes[pRoot1].var,
-                       unite_(mNodes[pRoot1].low, mNodes[pRoot2].low), 
-                       unite_(mNodes[pRoot1].high, mNodes[pRoot2].high));
+      lResult = restrict_(getHigh(pRoot), getHigh(pCube));
     }
-    else 
+    else
     {
-      lResult = insert(mNodes[pRoot2].var,
-                       unite_(pRoot1, mNodes[pRoot2].low), 
-                       unite_(pRoot1, mNodes[pRoot2].high));
+      lResult = restrict_(getLow(pRoot), getLow(pCube));
     }
   }
+  else
+  {
+    lResult = insert(getVar(pRoot),
+                     restrict_(getLow(pRoot),  pCube),
+                     restrict_(getHigh(pRoot), pCube));
+  }
 
-  mBinCache[lCacheIndex].result = lResult;
-  mBinCache[lCacheIndex].op = mUnite;
-  mBinCache[lCacheIndex].root1 = pRoot1;
-  mBinCache[lCacheIndex].root2 = pRoot2;
+  mApplyCache.insert(mRestrict, pRoot, pCube, 0, lResult);
 
   return lResult;
 }
 
+/// Replace each variable id v < pVarMap.size() by pVarMap[v],
+///   i.e., substitute all renamed variables simultaneously.
+///   pVarMap need not preserve the variable order, nor be injective.
+/// pKey identifies the renaming pVarMap in the cache.
 unsigned 
-bddBdd::intersect_(unsigned pRoot1, unsigned pRoot2) 
+bddBdd::replaceVars_ (unsigned                pRoot, 
+                      const vector<unsigned>& pVarMap,
+                      unsigned                pKey) 
 {
-  if(pRoot1 == 0) 
+  if(getVar(pRoot) >= pVarMap.size())
   {
-    return 0;
+    // Terminal, or only variable ids after the renamed ones.
+    return pRoot;
   }
-  if(pRoot2 == 0) 
+
+  // Renaming commutes with complement: Compute for the regular edge.
+  if(pRoot & 1)
   {
-    return 0;
+    return replaceVars_(pRoot ^ 1, pVarMap, pKey) ^ 1;
   }
-  if(pRoot1 == 1) 
+
+  // Lookup cache.
+  unsigned lResult;
+  if(mVarCache.lookup(mReplaceVars, pRoot, pKey, 0, lResult))
   {
-    return pRoot2;
+    return protect(lResult);
   }
-  if(pRoot2 == 1) 
+
+  const unsigned lLow  = replaceVars_(getLow(pRoot),  pVarMap, pKey);
+  const unsigned lHigh = replaceVars_(getHigh(pRoot), pVarMap, pKey);
+  const unsigned lVar  = pVarMap[getVar(pRoot)];
+  if(lVar < getVar(lLow)  &&  lVar < getVar(lHigh))
   {
-    return pRoot1;
+    // Order preserved: Relabel node pRoot.
+    lResult = insert(lVar, lLow, lHigh);
   }
-  if(pRoot1 == pRoot2)
+  else
   {
-    return pRoot1;
+    // New variable is not on top of the renamed sons.
+    lResult = ite_(insert(lVar, 0, 1), lHigh, lLow);
   }
 
-  normalize(pRoot1, pRoot2);
-  unsigned lResult;
-  unsigned lCacheIndex = hash(mIntersect, pRoot1, pRoot2, mBinCBitNr);
-  if(mBinCache[lCacheIndex].op == mIntersect
-    && mBinCache[lCacheIndex].root1 == pRoot1
-    && mBinCache[lCacheIndex].root2 == pRoot2) 
+  // Write result into cache.
+  mVarCache.insert(mReplaceVars, pRoot, pKey, 0, lResult);
+
+  return lResult;
+}
+
+/// Increments the reference counter of the node of pEdge (during reordering).
+void
+bddBdd::ref(unsigned pEdge)
+{
+  if(getNode(pEdge) != 0)
   {
-    return mBinCache[lCacheIndex].result;
+    ++mRefCnts[getNode(pEdge)];
   }
+}
 
-  if(mNodes[pRoot1].var < mNodes[pRoot2].var) 
+/// Decrements the reference counter of the node of pEdge (during reordering).
+///   Dead nodes are freed immediately, because sifting produces 
+///   a lot of garbage and must not run out of free nodes.
+void
+bddBdd::unRef(unsigned pEdge)
+{
+  unsigned lNode = getNode(pEdge);
+  if(lNode == 0)
   {
-    lResult = insert(mNodes[pRoot1].var,
-                     intersect_(mNodes[pRoot1].low, pRoot2), 
-                     intersect_(mNodes[pRoot1].high, pRoot2));
+    return;
   }
-  else 
+  assert(mRefCnts[lNode] > 0);
+  if(--mRefCnts[lNode] == 0)
+  {
+    hashRemove(lNode);
+    unsigned lLow  = mNodes[lNode].low;
+    unsigned lHigh = mNodes[lNode].high;
+    freeNode(lNode);
+    --mLiveNr;
+    unRef(lLow);
+    unRef(lHigh);
+  }
+}
+
+/// Like insert(), but registers a new node for reordering.
+unsigned
+bddBdd::insertRef(unsigned pVar, unsigned pLow, unsigned pHigh)
+{
+  unsigned lFreeNr = mFreeNr;
+  unsigned lResult = insert(pVar, pLow, pHigh);
+  if(mFreeNr < lFreeNr)
+  {
+    // New node.
+    unsigned lNode = getNode(lResult);
+    mRefCnts[lNode] = 0;
+    ref(mNodes[lNode].low);
+    ref(mNodes[lNode].high);
+    mVarNodes[pVar].push_back(lNode);
+    ++mLiveNr;
+  }
+  return lResult;
+}
+
+/// Returns the live nodes with variable id pVar.
+///   Removes stale entries from the list, i.e., nodes that were freed
+///   (and possibly reused for another variable) or that occur twice.
+const vector<unsigned>&
+bddBdd::getVarNodes(unsigned pVar)
+{
+  vector<unsigned>& lNodes = mVarNodes[pVar];
+  const unsigned short lEpoch = newEpoch();
+  unsigned lNodeNr = 0;
+  for(unsigned lCnt = 0; lCnt < lNodes.size(); ++lCnt)
   {
-    if(mNodes[pRoot1].var == mNodes[pRoot2].var)
+    if(mRefCnts[lNodes[lCnt]] != 0  &&  mNodes[lNodes[lCnt]].var == pVar
+       &&  visit(lNodes[lCnt], lEpoch))
     {
-      lResult = insert(mNodes[pRoot1].var,
-                       intersect_(mNodes[pRoot1].low, mNodes[pRoot2].low), 
-                       intersect_(mNodes[pRoot1].high, mNodes[pRoot2].high));
+      lNodes[lNodeNr++] = lNodes[lCnt];
     }
-    else 
+  }
+  lNodes.resize(lNodeNr);
+  return lNodes;
+}
+
+/// Exchanges the variables pVar1 and pVar2 (pVar1 < pVar2) in place.
+/// The nodes of pVar2 get the variable pVar1, and vice versa.
+///   A node of pVar1 that depends on pVar2 is rebuilt with the new sons
+///   (pVar2: f00, f10) and (pVar2: f01, f11), 
+///   where fij is the cofactor for pVar1 == i and pVar2 == j.
+///   All other nodes keep their sons.
+bool
+bddBdd::swapVars(unsigned pVar1, unsigned pVar2)
+{
+  const vector<unsigned> lNodes1 = getVarNodes(pVar1);
+  const vector<unsigned> lNodes2 = getVarNodes(pVar2);
+
+  // At most two new nodes per node of pVar1.
+  if(mFreeNr < 2 * lNodes1.size())
+  {
+    const unsigned lOldMaxNodeNr = mMaxNodeNr;
+    if(!grow())
+    {
+      return false;
+    }
+    unsigned* lRefCnts = (unsigned*) realloc(mRefCnts, 
+      (size_t) mMaxNodeNr * sizeof(unsigned));
+    if(!lRefCnts)
+    {
+      cerr << "Error: BDD package out of memory." << endl;
+      exit(EXIT_FAILURE);
+    }
+    mRefCnts = lRefCnts;
+    // The new nodes are free, thus not referenced.
+    memset(mRefCnts + lOldMaxNodeNr, 0, 
+           (size_t) (mMaxNodeNr - lOldMaxNodeNr) * sizeof(unsigned));
+    // Links the new nodes into the free list and rebuilds the hash table.
+    //   No dead nodes exist during reordering, thus gc() keeps all others.
+    gc();
+    if(mFreeNr < 2 * lNodes1.size())
     {
-      lResult = insert(mNodes[pRoot2].var,
-                       intersect_(pRoot1, mNodes[pRoot2].low), 
-                       intersect_(pRoot1, mNodes[pRoot2].high));
+      return false;
     }
   }
 
-  mBinCache[lCacheIndex].result = lResult;
-  mBinCache[lCacheIndex].op = mIntersect;
-  mBinCache[lCacheIndex].root1 = pRoot1;
-  mBinCache[lCacheIndex].root2 = pRoot2;
+  // Cofactors of the dependent nodes of pVar1, before the relabeling.
+  vector<unsigned> lDepNodes;
+  vector<unsigned> lCofactors;
+  vector<unsigned> lIndepNodes;
+  for(unsigned lCnt = 0; lCnt < lNodes1.size(); ++lCnt)
+  {
+    unsigned lLow  = mNodes[lNodes1[lCnt]].low;
+    unsigned lHigh = mNodes[lNodes1[lCnt]].high;
+    if(getVar(lLow) != pVar2  &&  getVar(lHigh) != pVar2)
+    {
+      lIndepNodes.push_back(lNodes1[lCnt]);
+      continue;
+    }
+    lDepNodes.push_back(lNodes1[lCnt]);
+    if(getVar(lLow) == pVar2)
+    {
+      lCofactors.push_back(getLow(lLow));
+      lCofactors.push_back(getHigh(lLow));
+    }
+    else
+    {
+      lCofactors.push_back(lLow);
+      lCofactors.push_back(lLow);
+    }
+    if(getVar(lHigh) == pVar2)
+    {
+      lCofactors.push_back(getLow(lHigh));
+      lCofactors.push_back(getHigh(lHigh));
+    }
+    else
+    {
+      lCofactors.push_back(lHigh);
+      lCofactors.push_back(lHigh);
+    }
+  }
 
-  return lResult;
+  // The hash keys of all nodes of both variables change.
+  for(unsigned lCnt = 0; lCnt < lNodes1.size(); ++lCnt)
+  {
+    hashRemove(lNodes1[lCnt]);
+  }
+  for(unsigned lCnt = 0; lCnt < lNodes2.size(); ++lCnt)
+  {
+    hashRemove(lNodes2[lCnt]);
+  }
+
+  // Nodes of pVar2 move up.
+  mVarNodes[pVar1] = lNodes2;
+  mVarNodes[pVar2].clear();
+  for(unsigned lCnt = 0; lCnt < lNodes2.size(); ++lCnt)
+  {
+    mNodes[lNodes2[lCnt]].var = pVar1;
+    hashInsert(lNodes2[lCnt]);
+  }
+
+  // Nodes of pVar1 that do not depend on pVar2 move down.
+  for(unsigned lCnt = 0; lCnt < lIndepNodes.size(); ++lCnt)
+  {
+    mNodes[lIndepNodes[lCnt]].var = pVar2;
+    hashInsert(lIndepNodes[lCnt]);
+    mVarNodes[pVar2].push_back(lIndepNodes[lCnt]);
+  }
+
+  // Nodes of pVar1 that depend on pVar2 are rebuilt in place.
+  for(unsigned lCnt = 0; lCnt < lDepNodes.size(); ++lCnt)
+  {
+    const unsigned lNode = lDepNodes[lCnt];
+    // The low cofactor f00 is regular, thus the new low son is regular.
+    unsigned lLow  = insertRef(pVar2, lCofactors[4*lCnt],   lCofactors[4*lCnt+2]);
+    ref(lLow);
+    unsigned lHigh = insertRef(pVar2, lCofactors[4*lCnt+1], lCofactors[4*lCnt+3]);
+    ref(lHigh);
+
+    unsigned lOldLow  = mNodes[lNode].low;
+    unsigned lOldHigh = mNodes[lNode].high;
+    mNodes[lNode].var  = pVar1;
+    mNodes[lNode].low  = lLow;
+    mNodes[lNode].high = lHigh;
+    hashInsert(lNode);
+    mVarNodes[pVar1].push_back(lNode);
+
+    // After the new sons are referenced, the old ones may die.
+    unRef(lOldLow);
+    unRef(lOldHigh);
+  }
+  return true;
 }
 
-unsigned 
-bddBdd::exists_(unsigned pRoot, unsigned pVar)
+/// Exchanges two blocks of variables by swapping adjacent variables:
+///   The variables of the first block move down one after the other,
+///   beginning with the last one.
+bool
+bddBdd::swapBlocks(unsigned pVarId1, unsigned pVarId2, unsigned pBlockSize)
 {
-  unsigned lCacheIndex;
-  unsigned lResult;
+  // The variable ids in the current order.
+  vector<unsigned> lVars;
+  for(unsigned lCnt = 0; lCnt < pBlockSize; ++lCnt)
+  {
+    lVars.push_back(pVarId1 + lCnt);
+  }
+  for(unsigned lCnt = 0; lCnt < pBlockSize; ++lCnt)
+  {
+    lVars.push_back(pVarId2 + lCnt);
+  }
 
-  if(mNodes[pRoot].var < pVar)
+  // Positions (in lVars) of the swaps done so far.
+  vector<unsigned> lSwaps;
+  for(unsigned lBit = pBlockSize; lBit-- > 0; )
   {
-    lCacheIndex = hash(mExists, pRoot, pVar, mBinCBitNr);
-    if(mBinCache[lCacheIndex].op == mExists
-       && mBinCache[lCacheIndex].root1 == pRoot
-       && mBinCache[lCacheIndex].root2 == pVar) 
+    for(unsigned lPos = lBit; lPos < lBit + pBlockSize; ++lPos)
     {
-      return mBinCache[lCacheIndex].result;
+      if(!swapVars(lVars[lPos], lVars[lPos + 1]))
+      {
+        // Undo, such that the blocks stay intact.
+        //   Undoing a swap restores the previous nodes, 
+        //   thus it fails only if the memory is exhausted anyway.
+        while(!lSwaps.empty())
+        {
+          if(!swapVars(lVars[lSwaps.back()], lVars[lSwaps.back() + 1]))
+          {
+            cerr << "Error: BDD package out of memory." << endl;
+            exit(EXIT_FAILURE);
+          }
+          lSwaps.pop_back();
+        }
+        return false;
+      }
+      lSwaps.push_back(lPos);
     }
+  }
+  return true;
+}
 
-    lResult = insert(mNodes[pRoot].var,
-                     exists_(mNodes[pRoot].low, pVar), 
-                     exists_(mNodes[pRoot].high, pVar));
+/// Appends the nodes of pRoot that are not stamped with pEpoch yet
+///   to pTriples (children first, the low son before the high son), 
+///   and assigns their indices in pIndices.
+void
+bddBdd::writeNodes_(unsigned pRoot, 
+                    unsigned short pEpoch,
+                    vector<unsigned>& pIndices, 
+                    vector<unsigned>& pTriples)
+{
+  // Entries (node << 1) for nodes to visit, 
+  //   and (node << 1) | 1 for nodes to write after their sons.
+  vector<unsigned> lStack;
+  lStack.push_back(getNode(pRoot) << 1);
+  while(!lStack.empty())
+  {
+    const unsigned lEntry = lStack.back();
+    lStack.pop_back();
+    const unsigned lNode = lEntry >> 1;
+    const unsigned lLow  = mNodes[lNode].low;
+    const unsigned lHigh = mNodes[lNode].high;
+    if(lEntry & 1)
+    {
+      pTriples.push_back(mNodes[lNode].var);
+      pTriples.push_back((pIndices[getNode(lLow)]  << 1) | (lLow  & 1));
+      pTriples.push_back((pIndices[getNode(lHigh)] << 1) | (lHigh & 1));
+      pIndices[lNode] = pTriples.size() / 3;
+    }
+    else if(visit(lNode, pEpoch))
+    {
+      lStack.push_back(lEntry | 1);
+      lStack.push_back(getNode(lHigh) << 1);
+      lStack.push_back(getNode(lLow) << 1);
+    }
+  }
+}
 
-    mBinCache[lCacheIndex].result = lResult;
-    mBinCache[lCacheIndex].op = mExists;
-    mBinCache[lCacheIndex].root1 = pRoot;
-    mBinCache[lCacheIndex].root2 = pVar;
+/// Writes the nodes and the roots of pBdds to pOut.
+void
+bddBdd::writeNodes(ostream& pOut, const vector<bddBdd>& pBdds)
+{
+  // Index in the file per node, 0 if not yet written.
+  vector<unsigned> lIndices(mMaxNodeNr, 0);
+  vector<unsigned> lTriples;
+  vector<unsigned> lRoots;
+  const unsigned short lEpoch = newEpoch();
+  for(unsigned lCnt = 0; lCnt < pBdds.size(); ++lCnt)
+  {
+    const unsigned lRoot = pBdds[lCnt].mRoot;
+    writeNodes_(lRoot, lEpoch, lIndices, lTriples);
+    lRoots.push_back((lIndices[getNode(lRoot)] << 1) | (lRoot & 1));
   }
-  else 
-  { 
-    if(mNodes[pRoot].var == pVar)
+
+  unsigned lNr = lTriples.size() / 3;
+  pOut.write((const char*) &lNr, sizeof(lNr));
+  if(!lTriples.empty())
+  {
+    pOut.write((const char*) &lTriples[0], lTriples.size() * sizeof(unsigned));
+  }
+  lNr = lRoots.size();
+  pOut.write((const char*) &lNr, sizeof(lNr));
+  if(!lRoots.empty())
+  {
+    pOut.write((const char*) &lRoots[0], lRoots.size() * sizeof(unsigned));
+  }
+}
+
+/// Creates the BDDs written by writeNodes() from pData.
+bool
+bddBdd::readNodes(const char* pData, size_t pSize, vector<bddBdd>& pBdds)
+{
+  // The data need not be aligned: Copy each number.
+  unsigned lNodeNr;
+  if(pSize < sizeof(unsigned))
+  {
+    return false;
+  }
+  memcpy(&lNodeNr, pData, sizeof(unsigned));
+  pData += sizeof(unsigned);
+  pSize -= sizeof(unsigned);
+  if(pSize / (3 * sizeof(unsigned)) < lNodeNr)
+  {
+    return false;
+  }
+
+  // Provide free nodes for all nodes in advance, because a garbage 
+  //   collection would free the nodes that are not yet referenced.
+  gc();
+  while(mFreeNr < lNodeNr)
+  {
+    if(!grow())
     {
-      lResult = unite_(mNodes[pRoot].low, mNodes[pRoot].high);
+      return false;
     }
-    else
+    gc();
+  }
+
+  // Edge in the BDD package per index in the file.
+  vector<unsigned> lEdges(1, 0);
+  lEdges.reserve(lNodeNr + 1);
+  for(unsigned lCnt = 1; lCnt <= lNodeNr; ++lCnt)
+  {
+    unsigned lTriple[3];
+    memcpy(lTriple, pData, sizeof(lTriple));
+    pData += sizeof(lTriple);
+    const unsigned lVar = lTriple[0];
+    // Children first, and in variable order.
+    if(   (lTriple[1] >> 1) >= lCnt  
+       || (lTriple[2] >> 1) >= lCnt
+       || lVar >= mTerminalVar)
     {
-      lResult = pRoot;
+      return false;
+    }
+    const unsigned lLow  = lEdges[lTriple[1] >> 1] ^ (lTriple[1] & 1);
+    const unsigned lHigh = lEdges[lTriple[2] >> 1] ^ (lTriple[2] & 1);
+    if(lVar >= getVar(lLow)  ||  lVar >= getVar(lHigh))
+    {
+      return false;
     }
+    lEdges.push_back(insert(lVar, lLow, lHigh));
   }
+  pSize -= (size_t) lNodeNr * 3 * sizeof(unsigned);
 
-  return lResult;
+  unsigned lRootNr;
+  if(pSize < sizeof(unsigned))
+  {
+    return false;
+  }
+  memcpy(&lRootNr, pData, sizeof(unsigned));
+  pData += sizeof(unsigned);
+  pSize -= sizeof(unsigned);
+  if(pSize != (size_t) lRootNr * sizeof(unsigned))
+  {
+    return false;
+  }
+  for(unsigned lCnt = 0; lCnt < lRootNr; ++lCnt)
+  {
+    unsigned lRoot;
+    memcpy(&lRoot, pData, sizeof(unsigned));
+    pData += sizeof(unsigned);
+    if((lRoot >> 1) > lNodeNr)
+    {
+      return false;
+    }
+    pBdds.push_back(bddBdd(lEdges[lRoot >> 1] ^ (lRoot & 1)));
+  }
+  return true;
 }
 
-/// Rename variable ids of all nodes from pFirst to pLast
-///   by adding pOffset to the variable ids.
-unsigned 
-bddBdd::renameVars_ (unsigned pRoot, 
-                     unsigned pFirst, 
-                     unsigned pLast, 
-                     int      pOffset) 
+/// Dynamic variable reordering by group sifting:
+///   Each block (the largest first) is moved through all places, 
+///   and is then put at the place with the smallest number of nodes.
+///   The search in one direction stops if the number of nodes 
+///   grows by more than 20 percent of the best number.
+vector<unsigned>
+bddBdd::reorderBlocks(unsigned pBlockSize, const vector<unsigned>& pBlocks)
 {
-  if(pRoot == 0 || pRoot == 1)
+  const bddObserved lObserved(mObserver, "reorder");
+  vector<unsigned> lResult(pBlocks);
+  mReorderDue = false;
+
+  // Afterwards, exactly the nodes in mUniqueHash are live.
+  gc();
+
+  // Number of nodes per block.
+  map<unsigned, unsigned> lBlockNodeNrs;
+  for(unsigned lCnt = 0; lCnt < (1u << mUniqueHBitNr); ++lCnt)
   {
-    return pRoot;
+    for(unsigned lSlot = 0; lSlot < mUniqueHash[lCnt].count; ++lSlot)
+    {
+      ++lBlockNodeNrs[mNodes[mUniqueHash[lCnt].nodes[lSlot]].var / pBlockSize];
+    }
+  }
+  // Only blocks with nodes are moved, and all of them must be movable.
+  map<unsigned, unsigned> lBlockIndex;
+  for(unsigned lCnt = 0; lCnt < pBlocks.size(); ++lCnt)
+  {
+    lBlockIndex[pBlocks[lCnt]] = lCnt;
+  }
+  vector<unsigned> lSlots;
+  for(map<unsigned, unsigned>::const_iterator lIt = lBlockNodeNrs.begin();
+      lIt != lBlockNodeNrs.end();
+      ++lIt)
+  {
+    if(lBlockIndex.find(lIt->first) == lBlockIndex.end())
+    {
+      return lResult;
+    }
+    lSlots.push_back(lIt->first);
+  }
+  if(lSlots.size() < 2)
+  {
+    return lResult;
   }
+  ++mReorderNr;
 
-  if(mNodes[pRoot].var > pLast)
+  // Reference counters and node lists.
+  mRefCnts = (unsigned*) calloc(mMaxNodeNr, sizeof(unsigned));
+  if(!mRefCnts)
   {
-    // Process variable ids after pLast.
-    return pRoot;
+    return lResult;
+  }
+  mVarNodes.assign((lSlots.back() + 1) * pBlockSize, vector<unsigned>());
+  mLiveNr = 0;
+  for(unsigned lCnt = 1; lCnt < mMaxNodeNr; ++lCnt)
+  {
+    if(mExtRefCnts[lCnt] != 0)
+    {
+      ++mRefCnts[lCnt];
+    }
+  }
+  for(unsigned lCnt = 0; lCnt < (1u << mUniqueHBitNr); ++lCnt)
+  {
+    for(unsigned lSlot = 0; lSlot < mUniqueHash[lCnt].count; ++lSlot)
+    {
+      const unsigned lNode = mUniqueHash[lCnt].nodes[lSlot];
+      ref(mNodes[lNode].low);
+      ref(mNodes[lNode].high);
+      mVarNodes[mNodes[lNode].var].push_back(lNode);
+      ++mLiveNr;
+    }
   }
 
-  // The variable (mRenameCnt) is set by renameVars(), 
-  //   such that its value is unique in each execution of renameVars().
-  // Lookup cache.
-  unsigned lCacheIndex = hash(mRenameVars, pRoot, mRenameCnt, mBinCBitNr);
-  if(mBinCache[lCacheIndex].op == mRenameVars
-    && mBinCache[lCacheIndex].root1 == pRoot
-    && mBinCache[lCacheIndex].root2 == mRenameCnt) 
+  // lArrangement[i] is the block at place lSlots[i].
+  vector<unsigned> lArrangement(lSlots);
+  multimap<unsigned, unsigned> lBlocksBySize;
+  for(map<unsigned, unsigned>::const_iterator lIt = lBlockNodeNrs.begin();
+      lIt != lBlockNodeNrs.end();
+      ++lIt)
   {
-    return mBinCache[lCacheIndex].result;
+    lBlocksBySize.insert(pair<unsigned, unsigned>(lIt->second, lIt->first));
   }
 
-  unsigned lResult;
-  if(mNodes[pRoot].var < pFirst)
+  // Sift the blocks, the largest first.
+  //   Stop completely if the memory does not suffice for a block exchange.
+  bool lOk = true;
+  for(multimap<unsigned, unsigned>::reverse_iterator lIt = lBlocksBySize.rbegin();
+      lIt != lBlocksBySize.rend()  &&  lOk;
+      ++lIt)
   {
-    // Process variable ids in front of pFirst.
-    lResult = insert(mNodes[pRoot].var,
-                     renameVars_(mNodes[pRoot].low,  pFirst, pLast, pOffset),
-                     renameVars_(mNodes[pRoot].high, pFirst, pLast, pOffset));
+    unsigned lSlot = 0;
+    while(lArrangement[lSlot] != lIt->second)
+    {
+      ++lSlot;
+    }
+    unsigned lBestNr   = mLiveNr;
+    unsigned lBestSlot = lSlot;
+
+    // First towards the nearer end, then towards the other end.
+    const bool lUpFirst = (lSlot < lSlots.size() - 1 - lSlot);
+    for(unsigned lPhase = 0; lPhase < 2  &&  lOk; ++lPhase)
+    {
+      const bool lUp = (lPhase == 0) ? lUpFirst : !lUpFirst;
+      while(lUp ? lSlot > 0 : lSlot + 1 < lSlots.size())
+      {
+        const unsigned lUpper = lUp ? lSlot - 1 : lSlot;
+        lOk = swapBlocks(lSlots[lUpper] * pBlockSize, 
+                         lSlots[lUpper + 1] * pBlockSize, 
+                         pBlockSize);
+        if(!lOk)
+        {
+          break;
+        }
+        swap(lArrangement[lUpper], lArrangement[lUpper + 1]);
+        lSlot = lUp ? lSlot - 1 : lSlot + 1;
+        if(mLiveNr < lBestNr)
+        {
+          lBestNr   = mLiveNr;
+          lBestSlot = lSlot;
+        }
+        else if(mLiveNr > lBestNr + lBestNr / 5)
+        {
+          break;
+        }
+      }
+    }
+
+    // Back to the best place.
+    while(lOk  &&  lSlot != lBestSlot)
+    {
+      const unsigned lUpper = (lSlot > lBestSlot) ? lSlot - 1 : lSlot;
+      lOk = swapBlocks(lSlots[lUpper] * pBlockSize, 
+                       lSlots[lUpper + 1] * pBlockSize, 
+                       pBlockSize);
+      if(lOk)
+      {
+        swap(lArrangement[lUpper], lArrangement[lUpper + 1]);
+        lSlot = (lSlot > lBestSlot) ? lSlot - 1 : lSlot + 1;
+      }
+    }
   }
-  else
+
+  // Next reordering not before the number of live nodes doubled.
+  if(mReorderThreshold != 0  &&  mLiveNr <= UINT_MAX / 2  
+     &&  mReorderThreshold < 2 * mLiveNr)
   {
-    // Rename node pRoot.
-    lResult = insert(mNodes[pRoot].var + pOffset,
-                     renameVars_(mNodes[pRoot].low, pFirst, pLast, pOffset),
-                     renameVars_(mNodes[pRoot].high, pFirst, pLast, pOffset));
+    mReorderThreshold = 2 * mLiveNr;
   }
-  
 
-  // Write result into cache.
-  mBinCache[lCacheIndex].result = lResult;
-  mBinCache[lCacheIndex].op = mRenameVars;
-  mBinCache[lCacheIndex].root1 = pRoot;
-  mBinCache[lCacheIndex].root2 = mRenameCnt;
+  free(mRefCnts);
+  mRefCnts = 0;
+  vector< vector<unsigned> >().swap(mVarNodes);
+  // The caches contain results for the old variable ids,
+  //   and nodes that were freed and reused during reordering.
+  mApplyCache.clear();
+  mQuantCache.clear();
+  mAndExistsCache.clear();
+  mIteCache.clear();
+  mVarCache.clear();
+  mStatCache.clear();
+  gc();
+  // Swapping builds young nodes, also as sons of old nodes.
+  vector<unsigned> lStack;
+  for(unsigned lCnt = 1; lCnt < mMaxNodeNr; ++lCnt)
+  {
+    if(mNodes[lCnt].old)
+    {
+      promote(mNodes[lCnt].low, lStack);
+      promote(mNodes[lCnt].high, lStack);
+    }
+  }
 
+  for(unsigned lCnt = 0; lCnt < lSlots.size(); ++lCnt)
+  {
+    lResult[lBlockIndex[lSlots[lCnt]]] = lArrangement[lCnt];
+  }
   return lResult;
 }
 
@@ -737,28 +2595,50 @@ bddBdd::renameVars_ (unsigned pRoot,
 /// function of the package is used.
 /// Parameters: Values for the m... variables.
 ///   number of elements of mNodes == pNodes,
-///   number of elements of mUniqueHash == 2^pUniqueHBitNr,
-///   number of elements of mBinCache == 2^pBinCBitNr.
-///   number of elements of mStatCache == 2^pStatCBitNr.
+///   number of buckets of mUniqueHash == 2^(pUniqueHBitNr-2),
+///     or more if the nodes do not fit in,
+///   number of entries of mApplyCache, mQuantCache, mAndExistsCache,
+///     mIteCache and mVarCache == 2^pBinCBitNr each,
+///   number of entries of mStatCache == 2^pStatCBitNr.
+/// These are initial sizes, the tables grow on demand 
+///   up to pNodeNrLimit nodes (0 for no limit).
+/// Both node numbers are clamped to mNodeNrMax - 1.
 void 
 bddBdd::init (unsigned pMaxNodeNr, 
               unsigned pUniqueHBitNr, 
               unsigned pBinCBitNr, 
-              unsigned pStatCBitNr) {
+              unsigned pStatCBitNr,
+              unsigned pNodeNrLimit) {
 
   // Allocate memory.
-  mMaxNodeNr = pMaxNodeNr+2;
-  mNodes = new bddNode[mMaxNodeNr];
-
-  mUniqueHBitNr = pUniqueHBitNr;
-  mUniqueHash = new unsigned[1u << mUniqueHBitNr];
-
-  mBinCBitNr = pBinCBitNr;
-  mBinCache = new bddBinEntry[1u << mBinCBitNr];
-  mStatCBitNr = pStatCBitNr;
-  mStatCache = new bddStatEntry[1u << mStatCBitNr];
-
-  if(!mNodes || !mUniqueHash || !mBinCache  || !mStatCache) 
+  //   Plain C allocation, because the tables are resized by realloc().
+  //   Not more than mNodeNrMax nodes, as in grow().
+  mMaxNodeNr = min(pMaxNodeNr, (unsigned) mNodeNrMax - 1) + 1;
+  mNodeNrLimit = min(pNodeNrLimit, (unsigned) mNodeNrMax - 1);
+  mNodes = (bddNode*) malloc((size_t) mMaxNodeNr * sizeof(bddNode));
+  mExtRefCnts = (unsigned*) malloc((size_t) mMaxNodeNr * sizeof(unsigned));
+  mStamps = (unsigned short*) calloc(mMaxNodeNr, sizeof(unsigned short));
+  mEpoch = 0;
+
+  // The unique table must hold all nodes, with some room for probing.
+  const unsigned lUniqueHBitNr 
+    = getUniqueHBitNr(min(max(pUniqueHBitNr, 3u) - 2, 
+                          (unsigned) mUniqueHBitMax),
+                      mMaxNodeNr);
+  bool lUniqueHashOk = allocUniqueHash(lUniqueHBitNr);
+
+  // Two entries per set. The edges among the arguments and results
+  //   (bit 3: result) are checked by garbage collection.
+  //   Set inclusion stores its result as 0 or 1, like terminal edges.
+  bool lCachesOk 
+    =  mApplyCache.init(pBinCBitNr - 1, 1 | 2 | 8)
+    && mQuantCache.init(pBinCBitNr - 2, 1 | 2 | 8)
+    && mAndExistsCache.init(pBinCBitNr - 2, 1 | 2 | 4 | 8)
+    && mIteCache.init(pBinCBitNr - 2, 1 | 2 | 4 | 8)
+    && mVarCache.init(pBinCBitNr - 2, 1 | 8)
+    && mStatCache.init(pStatCBitNr - 1, 1);
+
+  if(!mNodes || !mExtRefCnts || !mStamps || !lUniqueHashOk || !lCachesOk) 
   {
     cerr << "Error: "
          << "Not enough memory for initialization of BDD package." << endl;
@@ -767,33 +2647,75 @@ bddBdd::init (unsigned pMaxNodeNr,
 
   // Initialise arrays.
   memset(mNodes, 0, mMaxNodeNr * sizeof(bddNode));
-  memset(mUniqueHash, 0, (1u << mUniqueHBitNr) * sizeof(unsigned));
-  memset(mBinCache, 0, (1u << mBinCBitNr) * sizeof(bddBinEntry));
-  memset(mStatCache, 0, (1u << mStatCBitNr) * sizeof(bddStatEntry));
+  memset(mExtRefCnts, 0, mMaxNodeNr * sizeof(unsigned));
 
-  // Initialise terminal nodes.
+  // Initialise terminal node.
   //mNodes[0].var = (unsigned)-1;
-  mNodes[0].var = (UINT_MAX >> 1);
+  mNodes[0].var = mTerminalVar;
   mNodes[0].mark = 1;
-  //mNodes[1].var = (unsigned)-1;
-  mNodes[1].var = (UINT_MAX >> 1);
-  mNodes[1].mark = 1;
+  mNodes[0].old = 1;
 
   // Initialise mFree list of unused nodes.
-  mFree = 2;
-  for(unsigned lCnt = 2; lCnt < mMaxNodeNr-1; lCnt++)
+  mFree = 0;
+  mFreeNr = 0;
+  mGcLiveNr = 0;
+  mOldNr = 0;
+  for(unsigned lCnt = mMaxNodeNr-1; lCnt >= 1; --lCnt)
+  {
+    freeNode(lCnt);
+  }
+}
+
+/// Frees memory used by the static data structures.
+void 
+bddBdd::done () {
+  free(mNodes);
+  free(mExtRefCnts);
+  free(mStamps);
+  mStamps = 0;
+  free(mUniqueHashMem);
+  mUniqueHashMem = 0;
+  mUniqueHash = 0;
+  mApplyCache.done();
+  mQuantCache.done();
+  mAndExistsCache.done();
+  mIteCache.done();
+  mVarCache.done();
+  mStatCache.done();
+  mPool.stop();
+  mForkDepth = 0;
+}
+
+/// Sets the replacement policy of all caches.
+void
+bddBdd::setCachePolicy(bddCachePolicy pPolicy)
+{
+  mApplyCache.setPolicy(pPolicy);
+  mQuantCache.setPolicy(pPolicy);
+  mAndExistsCache.setPolicy(pPolicy);
+  mIteCache.setPolicy(pPolicy);
+  mVarCache.setPolicy(pPolicy);
+  mStatCache.setPolicy(pPolicy);
+}
+
+/// Starts pThreadNr - 1 worker threads (the calling thread takes part).
+///   Each parallel operation forks log2(pThreadNr) + 6 levels
+///   of recursion, i.e., about 64 tasks per thread for load balancing.
+bool
+bddBdd::setThreadNr(unsigned pThreadNr)
+{
+  mPool.stop();
+  mForkDepth = 0;
+  if(pThreadNr <= 1)
   {
-    mNodes[lCnt].low = lCnt+1;
+    return true;
   }
-}
-
-/// Frees memory used by the static data structures.
-void 
-bddBdd::done () {
-  delete mNodes;
-  delete mUniqueHash;
-  delete mBinCache;
-  delete mStatCache;
+  if(!mPool.start(pThreadNr, &runTask))
+  {
+    return false;
+  }
+  mForkDepth = log2floor(pThreadNr) + 6;
+  return true;
 }
 
 /// Returns overall number of live nodes (Terminal nodes are not counted).
@@ -803,76 +2725,192 @@ bddBdd::getReachNodeNr()
   unsigned lResult;
 
   lResult = 0;
-  for(multiset<unsigned>::iterator lIt = mExtRefs.begin();
-      lIt != mExtRefs.end(); 
-      ++lIt)
-  {
-    lResult += getNodeNr_(*lIt);
-  }
-
-  for(multiset<unsigned>::iterator lIt = mExtRefs.begin();
-      lIt != mExtRefs.end(); 
-      ++lIt)
+  // One epoch for all roots: shared nodes are counted once.
+  const unsigned short lEpoch = newEpoch();
+  for(unsigned lCnt = 1; lCnt < mMaxNodeNr; ++lCnt)
   {
-    unMark(*lIt);
+    if(mExtRefCnts[lCnt] != 0)
+    {
+      lResult += getNodeNr_(lCnt << 1, lEpoch);
+    }
   }
 
   return lResult;
 }
 
-/// Returns number of external (user) references in mExtrefs.
+/// Returns number of external (user) references.
 unsigned 
 bddBdd::getExtRefNr()
 {
-  return mExtRefs.size();
+  return mExtRefNr;
 }
 
-/// Prints list lengths in mUniqueHash.
+/// Prints the numbers of nodes per bucket of mUniqueHash.
 void 
 bddBdd::analyseUniqueHash() 
 {
-  vector<unsigned> lListLenCnts;
-  unsigned lListLen;
-  unsigned lUniqueElem;
+  vector<unsigned> lBucketCnts(bddUniqueBucket::mSlotNr + 1);
+  unsigned lOverflowNr = 0;
 
   for(unsigned lCnt = 0; lCnt < (1u << mUniqueHBitNr); lCnt++) 
   {
-    lListLen = 0;
-    lUniqueElem = mUniqueHash[lCnt];
-    while(lUniqueElem) 
-    {
-      lUniqueElem = mNodes[lUniqueElem].next;
-      ++lListLen;
-    }
-    ++lListLenCnts[lListLen];
+    ++lBucketCnts[mUniqueHash[lCnt].count];
+    lOverflowNr += mUniqueHash[lCnt].overflow;
   }
 
-  cout << "Size of uniqueHash: " << (1u << mUniqueHBitNr) << '\n';
-  cout << "n | number of lists of length n in uniqueHash:\n";
-  for(unsigned lCnt = 0; lCnt < lListLenCnts.size(); lCnt++)
-    cout << lCnt << ' ' << lListLenCnts[lCnt] << '\n';
+  cout << "Size of uniqueHash: " << (1u << mUniqueHBitNr) << " buckets\n";
+  cout << "Overflowed buckets: " << lOverflowNr << '\n';
+  cout << "n | number of buckets with n nodes in uniqueHash:\n";
+  for(unsigned lCnt = 0; lCnt < lBucketCnts.size(); lCnt++)
+    cout << lCnt << ' ' << lBucketCnts[lCnt] << '\n';
 }
 
-/// Creates BDD that assign the value pValue to the variable pVarId.
-bddBdd::bddBdd(unsigned pVarId, bool pValue) 
+/// Returns the overall number of lookups of all caches.
+unsigned long
+bddBdd::getCacheLookupNr()
 {
-  try 
+  unsigned long lResult = 0;
+  for(unsigned lOp = 1; lOp < mCacheOpNr; ++lOp)
   {
-    mRoot = bddBdd::bddBdd_(pVarId, pValue);
+    lResult += mApplyCache.getLookupNr(lOp) + mQuantCache.getLookupNr(lOp)
+      + mAndExistsCache.getLookupNr(lOp) + mIteCache.getLookupNr(lOp)
+      + mVarCache.getLookupNr(lOp) + mStatCache.getLookupNr(lOp);
   }
-  catch(...) 
+  return lResult;
+}
+
+/// Returns the overall number of hits of all caches.
+unsigned long
+bddBdd::getCacheHitNr()
+{
+  unsigned long lResult = 0;
+  for(unsigned lOp = 1; lOp < mCacheOpNr; ++lOp)
   {
-    bddBdd::gc();
-    try
+    lResult += mApplyCache.getHitNr(lOp) + mQuantCache.getHitNr(lOp)
+      + mAndExistsCache.getHitNr(lOp) + mIteCache.getHitNr(lOp)
+      + mVarCache.getHitNr(lOp) + mStatCache.getHitNr(lOp);
+  }
+  return lResult;
+}
+
+/// Returns the maximum number of used nodes since resetPeakNodeNr().
+unsigned
+bddBdd::getPeakNodeNr()
+{
+  return max(mPeakMarkNr, mMaxNodeNr - 1 - mFreeNr);
+}
+
+/// Restarts the measurement of getPeakNodeNr() with at least pNodeNr nodes.
+void
+bddBdd::resetPeakNodeNr(unsigned pNodeNr)
+{
+  mPeakMarkNr = max(pNodeNr, mMaxNodeNr - 1 - mFreeNr);
+}
+
+/// Writes the statistics as JSON object.
+void
+bddBdd::printStats(ostream& pS)
+{
+  // Names of the operation identifiers, as in the enumeration.
+  static const char* const lOpNames[mOpNr] = { 0,
+    "intersect", "setContains", "xor", "restrict",
+    "existsCube", "andExists", "ite", "exists", "replaceVars", "support",
+    "density", "nodeCount",
+    "unite", "forall", "equivalence", "implication", "difference" };
+  // The operations without own cache entries, and the operations 
+  //   whose entries they use.
+  static const unsigned lCacheOps[mOpNr - mCacheOpNr] = { 
+    mIntersect, mExistsCube, mXor, mIntersect, mIntersect };
+
+  pS << "{\n  \"operations\": {";
+  for(unsigned lOp = 1; lOp < mOpNr; ++lOp)
+  {
+    pS << (lOp == 1 ? "\n" : ",\n")
+       << "    \"" << lOpNames[lOp] << "\": { "
+       << "\"calls\": " << mCallNr[lOp] << ", ";
+    if(lOp >= mCacheOpNr)
     {
-      mRoot = bddBdd::bddBdd_(pVarId, pValue);
+      pS << "\"cacheOf\": \"" << lOpNames[lCacheOps[lOp - mCacheOpNr]] 
+         << "\" }";
+      continue;
     }
-    catch(...)
+    // Each operation uses the cache of its family.
+    unsigned long lLookupNr;
+    unsigned long lHitNr;
+    if(lOp < mExistsCube)
     {
-      cerr << "Error: BDD package out of memory." << endl;
-      exit(EXIT_FAILURE);
+      lLookupNr = mApplyCache.getLookupNr(lOp);
+      lHitNr = mApplyCache.getHitNr(lOp);
     }
-  }
+    else if(lOp == mExistsCube)
+    {
+      lLookupNr = mQuantCache.getLookupNr(lOp);
+      lHitNr = mQuantCache.getHitNr(lOp);
+    }
+    else if(lOp == mAndExists)
+    {
+      lLookupNr = mAndExistsCache.getLookupNr(lOp);
+      lHitNr = mAndExistsCache.getHitNr(lOp);
+    }
+    else if(lOp == mIte)
+    {
+      lLookupNr = mIteCache.getLookupNr(lOp);
+      lHitNr = mIteCache.getHitNr(lOp);
+    }
+    else if(lOp < mDensity)
+    {
+      lLookupNr = mVarCache.getLookupNr(lOp);
+      lHitNr = mVarCache.getHitNr(lOp);
+    }
+    else
+    {
+      lLookupNr = mStatCache.getLookupNr(lOp);
+      lHitNr = mStatCache.getHitNr(lOp);
+    }
+    pS << "\"cacheLookups\": " << lLookupNr << ", "
+       << "\"cacheHits\": " << lHitNr << ", "
+       << "\"cacheMisses\": " << lLookupNr - lHitNr << " }";
+  }
+  pS << "\n  },\n";
+
+  pS << "  \"uniqueTable\": { "
+     << "\"buckets\": " << (1u << mUniqueHBitNr) << ", "
+     << "\"lookups\": " << mProbeCounts.lookupNr << ", "
+     << "\"probes\": " << mProbeCounts.probeNr << ", "
+     << "\"averageProbes\": " 
+     << (mProbeCounts.lookupNr == 0 ? 0.0 
+         : (double) mProbeCounts.probeNr / mProbeCounts.lookupNr) 
+     << ", "
+     << "\"maxProbes\": " << mProbeCounts.probeMax << ", "
+     << "\"resizes\": " << mUniqueResizeNr << " },\n";
+
+  pS << "  \"gc\": { "
+     << "\"major\": " << mGcNr << ", "
+     << "\"minor\": " << mGcMinorNr << ", "
+     << "\"seconds\": " << mGcTime << ", "
+     << "\"reclaimedNodes\": " << mReclaimedNr << ", "
+     << "\"inOperation\": " << mResumeNr << " },\n";
+
+  const unsigned lUsedNr = mMaxNodeNr - 1 - mFreeNr;
+  pS << "  \"nodes\": { "
+     << "\"size\": " << mMaxNodeNr - 1 << ", "
+     << "\"limit\": " << mNodeNrLimit << ", "
+     << "\"used\": " << lUsedNr << ", "
+     << "\"peakLive\": " << mPeakLiveNr << ", "
+     << "\"peakUsed\": " << max(mPeakUsedNr, lUsedNr) << ", "
+     << "\"created\": " << mCreatedNr << ", "
+     << "\"grows\": " << mGrowNr << ", "
+     << "\"reorders\": " << mReorderNr << ", "
+     << "\"compactions\": " << mCompactNr << ", "
+     << "\"compactionsSkipped\": " << mCompactSkipNr << " }\n";
+  pS << "}" << endl;
+}
+
+/// Creates BDD that assign the value pValue to the variable pVarId.
+bddBdd::bddBdd(unsigned pVarId, bool pValue) 
+{
+  unsigned (*lMk)(unsigned, bool) = &bddBdd_;
+  mRoot = retryOnOutOfNodes(bddBind(lMk, pVarId, pValue), &reclaim);
   incRef();
 }
 
@@ -894,23 +2932,8 @@ bddBdd::bddBdd_(unsigned pVarId, bool pValue)
 ///   to 'pBitNr' variables beginning at position 'pVarId'.
 bddBdd::bddBdd(unsigned pVarId, unsigned pBitNr, unsigned pValue)
 {
-  try 
-  {
-    mRoot = bddBdd::bddBdd_(pVarId, pBitNr, pValue);
-  }
-  catch(...) 
-  {
-    bddBdd::gc();
-    try
-    {
-      mRoot = bddBdd::bddBdd_(pVarId, pBitNr, pValue);
-    }
-    catch(...)
-    {
-      cerr << "Error: BDD package out of memory." << endl;
-      exit(EXIT_FAILURE);
-    }
-  }
+  unsigned (*lMk)(unsigned, unsigned, unsigned) = &bddBdd_;
+  mRoot = retryOnOutOfNodes(bddBind(lMk, pVarId, pBitNr, pValue), &reclaim);
   incRef();
 }
 
@@ -942,23 +2965,8 @@ bddBdd::bddBdd_(unsigned pVarId, unsigned pBitNr, unsigned pValue)
 /// Creates BDD for pVarId1 == pVarId2.
 bddBdd::bddBdd(unsigned pVarId1, unsigned pVarId2)
 {
-  try 
-  {
-    mRoot = bddBdd::bddBdd_(pVarId1, pVarId2);
-  }
-  catch(...) 
-  {
-    bddBdd::gc();
-    try
-    {
-      mRoot = bddBdd::bddBdd_(pVarId1, pVarId2);
-    }
-    catch(...)
-    {
-      cerr << "Error: BDD package out of memory." << endl;
-      exit(EXIT_FAILURE);
-    }
-  }
+  unsigned (*lMk)(unsigned, unsigned) = &bddBdd_;
+  mRoot = retryOnOutOfNodes(bddBind(lMk, pVarId1, pVarId2), &reclaim);
   incRef();
 }
   
@@ -996,25 +3004,9 @@ bddBdd::mkLessEqual(unsigned pVarId, unsigned pBitNr, unsigned pValue)
   // pValue < 2^pBitNr.
   assert(pValue < (unsigned)(1<<pBitNr));
 
-  unsigned lRoot;
-  try 
-  {
-    lRoot = bddBdd::mkLessEqual_(pVarId, pBitNr, pValue);
-  }
-  catch(...) 
-  {
-    bddBdd::gc();
-    try
-    {
-      lRoot = bddBdd::mkLessEqual_(pVarId, pBitNr, pValue);
-    }
-    catch(...)
-    {
-      cerr << "Error: BDD package out of memory." << endl;
-      exit(EXIT_FAILURE);
-    }
-  }
-  return bddBdd(lRoot);
+  return bddBdd(retryOnOutOfNodes(bddBind(&mkLessEqual_, 
+                                          pVarId, pBitNr, pValue),
+                                  &reclaim));
 }
 
 /// Creates BDD for 'x <= pValue' 
@@ -1042,31 +3034,62 @@ bddBdd::mkLessEqual_(unsigned pVarId, unsigned pBitNr, unsigned pValue)
   return result;
 }
 
+/// Creates BDD for the conjunction of the variables 'pVarIds' (a cube).
+bddBdd
+bddBdd::mkCube(const set<unsigned>& pVarIds)
+{
+  return bddBdd(retryOnOutOfNodes(bddBind(&mkCube_, pVarIds), &reclaim));
+}
+
+/// Creates BDD for the conjunction of the variables 'pVarIds' (a cube).
+unsigned 
+bddBdd::mkCube_(const set<unsigned>& pVarIds)
+{
+  unsigned result = 1;
+
+  // Bottom-up, i.e., beginning with the greatest variable id.
+  for (set<unsigned>::const_reverse_iterator lIt = pVarIds.rbegin(); 
+       lIt != pVarIds.rend();
+       ++lIt)
+  {
+    result = insert(*lIt, 0, result);
+  }
+  return result;
+}
+
 /// Returns number of nodes (Terminal nodes are not counted).
+/// The result is cached for the node of the root (both polarities),
+///   such that repeated calls for a live BDD take constant time,
+///   also after garbage collections.
 unsigned 
 bddBdd::getNodeNr() const
 {
-  unsigned lResult = getNodeNr_(mRoot);
-  unMark(mRoot);  
+  ++mCallNr[mNodeCount];
+  if(getNode(mRoot) == 0)
+  {
+    return 0;
+  }
+  const unsigned lKey = getNode(mRoot) << 1;
+  bddStatEntry::Result lCached;
+  if(mStatCache.lookup(mNodeCount, lKey, 0, 0, lCached))
+  {
+    return (unsigned) lCached.value;
+  }
+  unsigned lResult = getNodeNr_(mRoot, newEpoch());
+  lCached.value = lResult;
+  lCached.exponent = 0;
+  mStatCache.insert(mNodeCount, lKey, 0, 0, lCached);
   return lResult;
 }
 
-/// Returns number of free nodes.
+/// Returns number of free nodes, without garbage collection.
 unsigned 
 bddBdd::getFreeNodeNr() const
 {
-  // Includes garbage collection to get real values.
-  bddBdd::gc();
-
-  unsigned result = 0;
-  unsigned lFreePos = mFree;
-
-  while( lFreePos != 0 )
-  {
-    ++result;
-    lFreePos = mNodes[lFreePos].low;
-  }
-  return result;
+  // Old nodes are live, unless a major collection is due.
+  const unsigned lLiveNr = max(mGcLiveNr, mOldNr);
+  const unsigned lUsedNr = getUsedNodeNr();
+  return mFreeNr + (lUsedNr > lLiveNr ? lUsedNr - lLiveNr : 0);
 }
 
 
@@ -1074,25 +3097,8 @@ bddBdd::getFreeNodeNr() const
 void 
 bddBdd::complement() 
 {
-  unsigned lResult;
-  try 
-  {
-    lResult = bddBdd::complement_(mRoot);
-  }
-  catch(...) 
-  {
-    // Out of free nodes in nodes array. Collect Garbage and try again.
-    bddBdd::gc();
-    try
-    {
-      lResult = bddBdd::complement_(mRoot);
-    }
-    catch(...)
-    {
-      cerr << "Error: BDD package out of memory." << endl;
-      exit(EXIT_FAILURE);
-    }
-  }
+  // No new nodes needed, thus no garbage collection.
+  unsigned lResult = bddBdd::complement_(mRoot);
   decRef();
   mRoot = lResult;
   incRef();
@@ -1103,23 +3109,12 @@ void
 bddBdd::unite(const bddBdd& pBdd) 
 {
   unsigned lResult;
-  try 
-  {
-    lResult = bddBdd::unite_(mRoot, pBdd.mRoot);
-  }
-  catch(...) 
-  {
-    bddBdd::gc();
-    try
-    {
-      lResult = bddBdd::unite_(mRoot, pBdd.mRoot);
-    }
-    catch(...)
-    {
-      cerr << "Error: BDD package out of memory." << endl;
-      exit(EXIT_FAILURE);
-    }
-  }
+  ++mCallNr[mUnite];
+  gcIfDue();
+  // Union by De Morgan, like unite_().
+  lResult = retryOnOutOfNodes(bddBind(&parallel_, (unsigned) mIntersect,
+                                      mRoot ^ 1, pBdd.mRoot ^ 1, 0),
+                              &reclaim) ^ 1;
   decRef();
   mRoot = lResult;
   incRef();
@@ -1130,23 +3125,11 @@ void
 bddBdd::intersect(const bddBdd& pBdd) 
 {
   unsigned lResult;
-  try 
-  {
-    lResult = bddBdd::intersect_(mRoot, pBdd.mRoot);
-  }
-  catch(...) 
-  {
-    bddBdd::gc();
-    try
-    {
-      lResult = bddBdd::intersect_(mRoot, pBdd.mRoot);
-    }
-    catch(...)
-    {
-      cerr << "Error: BDD package out of memory." << endl;
-      exit(EXIT_FAILURE);
-    }
-  }
+  ++mCallNr[mIntersect];
+  gcIfDue();
+  lResult = retryOnOutOfNodes(bddBind(&parallel_, (unsigned) mIntersect,
+                                      mRoot, pBdd.mRoot, 0),
+                              &reclaim);
   decRef();
   mRoot = lResult;
   incRef();
@@ -1157,61 +3140,277 @@ void
 bddBdd::exists(unsigned pVar) 
 {
   unsigned lResult;
-  try 
-  {
-    lResult = bddBdd::exists_(mRoot, pVar);
-  }
-  catch(...) 
-  {
-    bddBdd::gc();
-    try
-    {
-      lResult = bddBdd::exists_(mRoot, pVar);
-    }
-    catch(...)
-    {
-      cerr << "Error: BDD package out of memory." << endl;
-      exit(EXIT_FAILURE);
-    }
-  }
+  ++mCallNr[mExists];
+  gcIfDue();
+  lResult = retryOnOutOfNodes(bddBind(&exists_, mRoot, pVar), &reclaim);
+  decRef();
+  mRoot = lResult;
+  incRef();
+}
+
+/// Existential quantification of all variables of the cube pCube.
+void 
+bddBdd::exists(const bddBdd& pCube) 
+{
+  unsigned lResult;
+  ++mCallNr[mExistsCube];
+  gcIfDue();
+  lResult = retryOnOutOfNodes(bddBind(&existsCube_, mRoot, pCube.mRoot),
+                              &reclaim);
+  decRef();
+  mRoot = lResult;
+  incRef();
+}
+
+/// Universal quantification of all variables of the cube pCube.
+void 
+bddBdd::forall(const bddBdd& pCube) 
+{
+  unsigned lResult;
+  ++mCallNr[mForall];
+  gcIfDue();
+  lResult = retryOnOutOfNodes(bddBind(&forallCube_, mRoot, pCube.mRoot),
+                              &reclaim);
+  decRef();
+  mRoot = lResult;
+  incRef();
+}
+
+/// Relational product: Intersects with pBdd and quantifies existentially 
+///   the variables of the cube pCube.
+void 
+bddBdd::andExists(const bddBdd& pBdd, const bddBdd& pCube) 
+{
+  unsigned lResult;
+  ++mCallNr[mAndExists];
+  gcIfDue();
+  lResult = retryOnOutOfNodes(bddBind(&parallel_, (unsigned) mAndExists,
+                                      mRoot, pBdd.mRoot, pCube.mRoot),
+                              &reclaim);
+  decRef();
+  mRoot = lResult;
+  incRef();
+}
+
+/// If-then-else: pThen where *this holds, and pElse elsewhere.
+void 
+bddBdd::ifThenElse(const bddBdd& pThen, const bddBdd& pElse) 
+{
+  unsigned lResult;
+  ++mCallNr[mIte];
+  gcIfDue();
+  lResult = retryOnOutOfNodes(bddBind(&ite_, mRoot, pThen.mRoot, pElse.mRoot),
+                              &reclaim);
+  decRef();
+  mRoot = lResult;
+  incRef();
+}
+
+/// Cofactor for the literals of pCube.
+void 
+bddBdd::restrict(const bddBdd& pCube) 
+{
+  unsigned lResult;
+  ++mCallNr[mRestrict];
+  gcIfDue();
+  lResult = retryOnOutOfNodes(bddBind(&restrict_, mRoot, pCube.mRoot),
+                              &reclaim);
+  decRef();
+  mRoot = lResult;
+  incRef();
+}
+
+/// Symmetric difference with pBdd.
+void 
+bddBdd::exclusiveOr(const bddBdd& pBdd) 
+{
+  unsigned lResult;
+  ++mCallNr[mXor];
+  gcIfDue();
+  lResult = retryOnOutOfNodes(bddBind(&xor_, mRoot, pBdd.mRoot), &reclaim);
+  decRef();
+  mRoot = lResult;
+  incRef();
+}
+
+/// Equivalence with pBdd: Complemented symmetric difference.
+void 
+bddBdd::equivalence(const bddBdd& pBdd) 
+{
+  unsigned lResult;
+  ++mCallNr[mEquivalence];
+  gcIfDue();
+  lResult = retryOnOutOfNodes(bddBind(&xor_, mRoot, pBdd.mRoot), &reclaim) ^ 1;
+  decRef();
+  mRoot = lResult;
+  incRef();
+}
+
+/// Implication: A -> B == !(A & !B).
+void 
+bddBdd::implication(const bddBdd& pBdd) 
+{
+  unsigned lResult;
+  ++mCallNr[mImplication];
+  gcIfDue();
+  lResult = retryOnOutOfNodes(bddBind(&parallel_, (unsigned) mIntersect,
+                                      mRoot, pBdd.mRoot ^ 1, 0),
+                              &reclaim) ^ 1;
+  decRef();
+  mRoot = lResult;
+  incRef();
+}
+
+/// Difference: A & !B.
+void 
+bddBdd::difference(const bddBdd& pBdd) 
+{
+  unsigned lResult;
+  ++mCallNr[mDifference];
+  gcIfDue();
+  lResult = retryOnOutOfNodes(bddBind(&parallel_, (unsigned) mIntersect,
+                                      mRoot, pBdd.mRoot ^ 1, 0),
+                              &reclaim);
   decRef();
   mRoot = lResult;
   incRef();
 }
 
-/// Rename variable ids of all nodes from pFirst to pLast
-///   by adding pOffset to the variable ids.
+/// Replace each variable id v < pVarMap.size() by pVarMap[v]
+///   simultaneously (see replaceVars_()).
 void 
-bddBdd::renameVars(unsigned pFirst, unsigned pLast, int pOffset)
+bddBdd::replaceVars(const vector<unsigned>& pVarMap)
 {
+  // Same renamings share their cache entries.
+  map<vector<unsigned>, unsigned>::const_iterator lIt
+    = mReplaceKeys.find(pVarMap);
+  if(lIt == mReplaceKeys.end())
+  {
+    lIt = mReplaceKeys.insert(make_pair(pVarMap, (unsigned) mReplaceKeys.size())).first;
+  }
+
   unsigned lResult;
-  try 
+  ++mCallNr[mReplaceVars];
+  gcIfDue();
+  lResult = retryOnOutOfNodes(bddBind(&replaceVars_, mRoot, pVarMap,
+                                      lIt->second),
+                              &reclaim);
+  decRef();
+  mRoot = lResult;
+  incRef();
+}
+
+/// Starts the enumeration with the first tuple of pBdd.
+bddTupleCursor::bddTupleCursor(const bddBdd& pBdd,
+                               const vector<unsigned>& pBlocks,
+                               unsigned pBitNr,
+                               unsigned pMaxValue)
+  : mBdd(pBdd),
+    mBitNr(pBitNr),
+    mMaxValue(pMaxValue),
+    mTuple(pBlocks.size(), 0),
+    mValid(false)
+{
+  for(unsigned lBlock = 0; lBlock < pBlocks.size(); ++lBlock)
+  {
+    assert(lBlock == 0  ||  pBlocks[lBlock - 1] + pBitNr <= pBlocks[lBlock]);
+    for(unsigned lBit = 0; lBit < pBitNr; ++lBit)
+    {
+      mVars.push_back(pBlocks[lBlock] + lBit);
+    }
+  }
+  mEdges.resize(mVars.size() + 1);
+  mBits.resize(mVars.size());
+  mPrefixes.resize(mVars.size() + 1);
+  if(mBdd.mRoot != 0)
   {
-    lResult = bddBdd::renameVars_(mRoot, pFirst, pLast, pOffset);
+    mEdges[0] = mBdd.mRoot;
+    mValid = advance(0, 0);
   }
-  catch(...) 
+}
+
+/// Extends the path from depth pDepth to the next complete tuple.
+bool
+bddTupleCursor::advance(unsigned pDepth, unsigned pBit)
+{
+  const unsigned lDepthNr = mVars.size();
+  for(;;)
   {
-    bddBdd::gc();
-    try
+    if(pDepth == lDepthNr)
     {
-      lResult = bddBdd::renameVars_(mRoot, pFirst, pLast, pOffset);
+      return true;
     }
-    catch(...)
+
+    // Position of the bit in its element, 0 for the most significant.
+    const unsigned lPos = pDepth % mBitNr;
+    const unsigned lPrefix = (lPos == 0) ? 0 : mPrefixes[pDepth];
+    const unsigned lEdge = mEdges[pDepth];
+    bool lFound = false;
+    for(; pBit <= 1; ++pBit)
     {
-      cerr << "Error: BDD package out of memory." << endl;
-      exit(EXIT_FAILURE);
+      // Skip values greater than mMaxValue.
+      if(lPrefix * 2 + pBit > (mMaxValue >> (mBitNr - 1 - lPos)))
+      {
+        break;
+      }
+      // Cofactor, or the edge itself for a don't care.
+      unsigned lSon = lEdge;
+      if(bddBdd::getVar(lEdge) == mVars[pDepth])
+      {
+        lSon = pBit ? bddBdd::getHigh(lEdge) : bddBdd::getLow(lEdge);
+      }
+      if(lSon != 0)
+      {
+        mBits[pDepth] = pBit;
+        mEdges[pDepth + 1] = lSon;
+        mPrefixes[pDepth + 1] = lPrefix * 2 + pBit;
+        if(lPos == mBitNr - 1)
+        {
+          mTuple[pDepth / mBitNr] = lPrefix * 2 + pBit;
+        }
+        lFound = true;
+        break;
+      }
     }
-  }
-  decRef();
-  mRoot = lResult;
-  incRef();
 
-  // Create a fresh, unique cache entry operand for the next call. 
-  if (mRenameCnt < UINT_MAX) {
-    ++mRenameCnt;
-  } else {
-    mRenameCnt = 0;
-    bddBdd::gc();
+    if(lFound)
+    {
+      ++pDepth;
+      pBit = 0;
+    }
+    else
+    {
+      // Backtrack to the last decision for 0.
+      do
+      {
+        if(pDepth == 0)
+        {
+          return false;
+        }
+        --pDepth;
+      }
+      while(mBits[pDepth] == 1);
+      pBit = 1;
+    }
   }
 }
 
+/// Advances to the next tuple.
+void
+bddTupleCursor::next()
+{
+  assert(mValid);
+  // Backtrack to the last decision for 0.
+  unsigned lDepth = mVars.size();
+  do
+  {
+    if(lDepth == 0)
+    {
+      mValid = false;
+      return;
+    }
+    --lDepth;
+  }
+  while(mBits[lDepth] == 1);
+  mValid = advance(lDepth, 1);
+}
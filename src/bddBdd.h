@@ -32,49 +32,244 @@
 #define _bddBdd_h
 
 #include "relObject.h"
+#include "bddCache.h"
+#include "bddPool.h"
 
 #include <vector>
 #include <set>
 #include <map>
 #include <cassert>
+#include <cmath>
+#include <climits>
+#include <ctime>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /// BDD node
+///
+/// Sons are referenced by edges, not by plain node indices:
+///   An edge is (index << 1) | c, where (index) is the position of the
+///   son in the node array and (c) is the complement bit.
+///   A complemented edge denotes the negation of the function of the son.
+///   For canonicity, the low edge of a stored node is never complemented.
 struct bddNode 
 {
   /// To mark the node in garbage collection and node count
   unsigned mark:1;
+  /// Node of the old generation (see promoteAll()).
+  ///   The sons of an old node are old, too.
+  unsigned old:1;
   /// Variable id. The ids of variables are multiples of 1, starting with 0!  
-  unsigned var:31; 
-  /// Index of low son. Also used for linking unused nodes in the node array.
+  unsigned var:30; 
+  /// Edge to low son (never complemented). 
+  /// Also used for linking unused nodes in the node array.
   unsigned low;    
-  /// Index of high son.
+  /// Edge to high son.
   unsigned high;
-  /// Next node in mUniqueHash-list (0 for end of list).
-  unsigned next;
 };
 
-/// Cache entry for binary operations
-struct bddBinEntry 
-{  
-  /// Identifier of the operation
-  unsigned op;     
-  /// First argument of the operation
-  unsigned root1;
-  /// Second argument of the operation
-  unsigned root2;
-  /// Result of the operation
-  unsigned result;
+/// Bucket of the unique table, one cache line (64 bytes).
+///   Holds the indices of up to mSlotNr nodes and 16-bit tags 
+///   of their hash values, such that a lookup reads only the nodes 
+///   with a matching tag. The nodes occupy the first count slots.
+///   A full bucket passes further nodes to the next bucket 
+///   (open addressing with linear probing).
+struct bddUniqueBucket
+{
+  enum { mSlotNr = 8 };
+  /// Node indices.
+  unsigned nodes[mSlotNr];
+  /// Hash tags of the nodes, 0 for an empty slot.
+  ///   16-byte aligned, for comparing all tags with one SSE2 instruction.
+  unsigned short tags[mSlotNr];
+  /// Number of used slots.
+  unsigned count;
+  /// 1 if an insertion passed this bucket because it was full,
+  ///   i.e., a lookup must continue with the next bucket.
+  unsigned overflow;
+  /// Spin lock in parallel operations (see bddBdd::insert()).
+  int lock;
+  /// Fills the cache line.
+  unsigned pad;
+
+  /// Returns the set of slots (bit s for slot s) with the tag pTag.
+  unsigned 
+  match(unsigned short pTag) const
+  {
+#ifdef __SSE2__
+    const __m128i lEqual = _mm_cmpeq_epi16(
+      _mm_load_si128((const __m128i*) tags), _mm_set1_epi16((short) pTag));
+    return (unsigned) 
+      _mm_movemask_epi8(_mm_packs_epi16(lEqual, _mm_setzero_si128()));
+#else
+    unsigned lResult = 0;
+    for(unsigned lCnt = 0; lCnt < mSlotNr; ++lCnt)
+    {
+      lResult |= (unsigned) (tags[lCnt] == pTag) << lCnt;
+    }
+    return lResult;
+#endif
+  }
+
+  /// Like match(), but for concurrent insertions (see addShared()):
+  ///   The nodes of the matching slots are visible.
+  unsigned
+  matchShared(unsigned short pTag) const
+  {
+    unsigned lResult = 0;
+    for(unsigned lCnt = 0; lCnt < mSlotNr; ++lCnt)
+    {
+      lResult |= (unsigned) 
+        (__atomic_load_n(&tags[lCnt], __ATOMIC_ACQUIRE) == pTag) << lCnt;
+    }
+    return lResult;
+  }
+
+  /// Returns resp. sets overflow, for concurrent insertions.
+  bool
+  isOverflowShared() const
+  { return __atomic_load_n(&overflow, __ATOMIC_RELAXED) != 0; }
+  void
+  setOverflowShared()
+  { __atomic_store_n(&overflow, 1u, __ATOMIC_RELAXED); }
+
+  /// Appends node pNode with tag pTag (count < mSlotNr).
+  void
+  add(unsigned pNode, unsigned short pTag)
+  {
+    nodes[count] = pNode;
+    tags[count] = pTag;
+    ++count;
+  }
+
+  /// Like add(), but for concurrent insertions: Claims a slot atomically,
+  ///   and publishes the node with the tag, such that a concurrent lookup 
+  ///   that matches the tag (see matchShared()) finds the node.
+  /// Returns false if the bucket is full.
+  bool
+  addShared(unsigned pNode, unsigned short pTag)
+  {
+    unsigned lCount = __atomic_load_n(&count, __ATOMIC_RELAXED);
+    while(lCount < mSlotNr)
+    {
+      const unsigned lOldCount 
+        = __sync_val_compare_and_swap(&count, lCount, lCount + 1);
+      if(lOldCount == lCount)
+      {
+        nodes[lCount] = pNode;
+        __atomic_store_n(&tags[lCount], pTag, __ATOMIC_RELEASE);
+        return true;
+      }
+      lCount = lOldCount;
+    }
+    return false;
+  }
+
+  /// Removes the node in slot pSlot. The last node fills the gap.
+  void
+  remove(unsigned pSlot)
+  {
+    --count;
+    nodes[pSlot] = nodes[count];
+    tags[pSlot] = tags[count];
+    tags[count] = 0;
+  }
+};
+
+/// Statistics of the searches in the unique table.
+struct bddProbeCounts
+{
+  /// Number of searches, overall number of buckets visited
+  ///   by these searches, and maximum number of buckets of a search.
+  unsigned long lookupNr;
+  unsigned long probeNr;
+  unsigned probeMax;
 };
 
-/// Cache entry for counting tuples.
-struct bddStatEntry 
+/// Prefetches the cache line at address pAddr, if the compiler supports it.
+#ifdef __GNUC__
+#define BDD_PREFETCH(pAddr) __builtin_prefetch(pAddr)
+#else
+#define BDD_PREFETCH(pAddr)
+#endif
+
+/// Returns pOp(), an operation of a decision diagram package that
+///   creates nodes and throws an exception if the node array is full.
+///   Then calls pReclaim with the number of the failed try
+///   (see bddBdd::reclaim()) and calls pOp() again.
+template<class Op>
+unsigned
+retryOnOutOfNodes(const Op& pOp, void (*pReclaim)(unsigned))
+{
+  for(unsigned lTry = 0; ; ++lTry)
+  {
+    try
+    {
+      return pOp();
+    }
+    catch(...)
+    {
+      // Out of free nodes in nodes array.
+      //   Collect garbage or grow the node array, and try again.
+      pReclaim(lTry);
+    }
+  }
+}
+
+/// Function with bound arguments, as operation for retryOnOutOfNodes().
+///   Created by bddBind().
+template<class F, class A1>
+struct bddCall1
+{
+  F mF;  A1 mA1;
+  unsigned
+  operator()() const
+  { return mF(mA1); }
+};
+template<class F, class A1, class A2>
+struct bddCall2
 {
-  /// Argument of the operation
-  unsigned root;
-  /// Result of the operation
-  double result;  
+  F mF;  A1 mA1;  A2 mA2;
+  unsigned
+  operator()() const
+  { return mF(mA1, mA2); }
+};
+template<class F, class A1, class A2, class A3>
+struct bddCall3
+{
+  F mF;  A1 mA1;  A2 mA2;  A3 mA3;
+  unsigned
+  operator()() const
+  { return mF(mA1, mA2, mA3); }
+};
+template<class F, class A1, class A2, class A3, class A4>
+struct bddCall4
+{
+  F mF;  A1 mA1;  A2 mA2;  A3 mA3;  A4 mA4;
+  unsigned
+  operator()() const
+  { return mF(mA1, mA2, mA3, mA4); }
 };
 
+template<class F, class A1>
+bddCall1<F, A1>
+bddBind(F pF, const A1& pA1)
+{ bddCall1<F, A1> lCall = { pF, pA1 };  return lCall; }
+template<class F, class A1, class A2>
+bddCall2<F, A1, A2>
+bddBind(F pF, const A1& pA1, const A2& pA2)
+{ bddCall2<F, A1, A2> lCall = { pF, pA1, pA2 };  return lCall; }
+template<class F, class A1, class A2, class A3>
+bddCall3<F, A1, A2, A3>
+bddBind(F pF, const A1& pA1, const A2& pA2, const A3& pA3)
+{ bddCall3<F, A1, A2, A3> lCall = { pF, pA1, pA2, pA3 };  return lCall; }
+template<class F, class A1, class A2, class A3, class A4>
+bddCall4<F, A1, A2, A3, A4>
+bddBind(F pF, const A1& pA1, const A2& pA2, const A3& pA3, const A4& pA4)
+{ bddCall4<F, A1, A2, A3, A4> lCall = { pF, pA1, pA2, pA3, pA4 };
+  return lCall; }
+
 /// Node for BDD output graph representation.
 /// Only for output via getGraph().
 struct bddGraphNode
@@ -85,110 +280,493 @@ struct bddGraphNode
   unsigned high;
 };
 
+/// Observer of the BDD resp. ZDD package (see bddBdd::setObserver()
+///   and bddZdd::setObserver()): Called with the name of an event 
+///   ("gc", "gcMinor", "grow", "reorder"), and true at its beginning 
+///   resp. false at its end.
+typedef void (*bddObserver)(const char* pEvent, bool pBegin);
+
+/// Notifies the observer (if any) of the beginning of an event, 
+///   and of its end when the scope is left.
+class bddObserved
+{
+private:
+  bddObserver mObserver;
+  const char* mEvent;
+
+public:
+  bddObserved(bddObserver pObserver, const char* pEvent)
+    : mObserver(pObserver),
+      mEvent(pEvent)
+  {
+    if(mObserver)
+    {
+      mObserver(mEvent, true);
+    }
+  }
+
+  ~bddObserved()
+  {
+    if(mObserver)
+    {
+      mObserver(mEvent, false);
+    }
+  }
+};
+
 /// One Binary Decision Diagram
 /// and static data structures of the whole Shared BDD package
 class bddBdd : private relObject
 {
+  friend class bddTupleCursor;
+  friend class bddZdd;
+
 private: // Constants.
 
-  /// Identifiers of the operations in the cache (mBinCache).
-  enum { mComplement = 1, mRenameVars, mExists,
-         mUnite, mIntersect, mSetContains };
+  /// Variable id of the terminal node, greater than all other ids.
+  enum { mTerminalVar = (1u << 30) - 1 };
+
+  /// Maximum number of elements of mNodes. Edges need one bit 
+  ///   of an unsigned for the complement bit.
+  enum { mNodeNrMax = (UINT_MAX >> 1) + 1 };
+
+  /// Distance (in nodes) of prefetching in the sweep of gc().
+  enum { mSweepAhead = 16 };
+
+  /// Minimum number of live nodes for compaction (see isCompactDue()).
+  ///   Smaller node arrays fit into the processor caches anyway.
+  enum { mCompactMinNr = 1 << 16 };
+  /// Edges to sons farther away than mCompactNearNr nodes (one page
+  ///   of 4 KB) count as scattered (see isCompactDue()).
+  enum { mCompactNearNr = 4096 / sizeof(bddNode) };
+  /// Maximum number of bits of the unique table. The hash values 
+  ///   have 32 bits, and 2^30 buckets hold more than all edges.
+  enum { mUniqueHBitMax = 30 };
+
+  /// Identifiers of the operations in the caches.
+  ///   Union is computed as complemented intersection (De Morgan), 
+  ///   so both share the cache entries of mIntersect.
+  ///   Likewise, universal quantification shares the entries of mExistsCube,
+  ///   implication and difference those of mIntersect, 
+  ///   and equivalence those of mXor.
+  enum { mIntersect = 1, mSetContains,   // mApplyCache
+         mXor, mRestrict,                // mApplyCache
+         mExistsCube,                    // mQuantCache
+         mAndExists,                     // mAndExistsCache
+         mIte,                           // mIteCache
+         mExists, mReplaceVars, mSupport, // mVarCache
+         mDensity, mNodeCount,           // mStatCache
+         mUnite, mForall,                // Only counted (see above).
+         mEquivalence, mImplication, mDifference };
+  /// Bound of the operation identifiers in the caches.
+  enum { mCacheOpNr = mNodeCount + 1 };
+  /// Bound of the operation identifiers (for the statistics).
+  enum { mOpNr = mDifference + 1 };
 
 private: // Static attributes.
 
   /// Node Array.
-  /// mNodes[0] is the 0-terminal, mNodes[1] is the 1-terminal.
-  /// Both are always marked (mark == 1) and have the variable id -1.
+  /// mNodes[0] is the only terminal node. It is always marked (mark == 1) 
+  /// and has the variable id -1. 
+  /// The regular edge 0 to the terminal is the constant 0 (empty set), 
+  /// the complemented edge 1 to the terminal is the constant 1 (full set).
   static bddNode* mNodes;
-  /// Number of elements of mNodes.
+  /// Number of elements of mNodes. Grows on demand (see grow()).
   static unsigned mMaxNodeNr;
+  /// Maximum number of nodes (terminal not counted) that mNodes may 
+  /// grow to. 0 means no limit.
+  static unsigned mNodeNrLimit;
   /// Index of the first unused node in mNodes. 
   /// Unused nodes are linked using their low-element.
   static unsigned mFree;
+  /// Number of unused nodes in the list mFree.
+  static unsigned mFreeNr;
+  /// Number of live nodes after the last garbage collection (at most,
+  ///   because minor garbage collections keep all old nodes).
+  ///   All newer nodes are probably dead, i.e., intermediate results.
+  static unsigned mGcLiveNr;
+  /// Number of nodes of the old generation (see promote()).
+  static unsigned mOldNr;
 
-  /// Indices of externally (i.e. by the package user) reference nodes.
-  /// Updated by constructors and destructors. Does not contain terminals.
+  /// Numbers of external (i.e. by the package user) references, 
+  ///   one counter per element of mNodes (parallel array).
+  /// Updated by constructors and destructors. Terminals are not counted.
   /// Used in garbage collections to recognise live nodes.
-  static multiset<unsigned> mExtRefs;
+  /// A counter that reaches UINT_MAX saturates, i.e., the node stays live.
+  static unsigned* mExtRefCnts;
+  /// Overall number of external references.
+  static unsigned mExtRefNr;
 
   /// Hash table of all used nodes.
   /// Used by insert to ensure that mNodes contains no two equal nodes.
-  /// mUniqueHash[i] contains the index of first node of a list of all nodes 
-  /// with hash value i. Lists are linked by the next-element of the nodes.
-  static unsigned* mUniqueHash;
-  /// Number of elements of mUniqueHash == 2^mUniqueHBitNr == 1<<mUniqueHBitNr.
+  /// A node with hash value h is stored in bucket h >> (32-mUniqueHBitNr),
+  ///   or in one of the following buckets if that one overflows.
+  ///   Aligned to cache lines within the memory block mUniqueHashMem.
+  static bddUniqueBucket* mUniqueHash;
+  static void* mUniqueHashMem;
+  /// Number of buckets of mUniqueHash == 2^mUniqueHBitNr == 1<<mUniqueHBitNr.
   static unsigned mUniqueHBitNr;
-  /// Cache for the results of binary operations.
-  static bddBinEntry* mBinCache;
-  /// Number of elements of mBinCache == 2^mBinCBitNr.
-  static unsigned mBinCBitNr;
-  /// Cache for the results of getTupleNr().
-  static bddStatEntry* mStatCache;
-  /// Number of elements of mStatCache == 2^mStatCBitNr.
-  static unsigned mStatCBitNr;
-
-  /// Fresh, unique cache entry operand for the next call of renameVar(). 
-  ///   Whenever renameVar() is called, it changes the value of mRenameCnt.
-  static unsigned mRenameCnt; // = 0;
+  /// Caches for the results of the operations, one per family 
+  ///   (see the identifiers of the operations).
+  /// Garbage collection drops only the entries that refer to dead nodes.
+  /// Cache for intersection/union, set inclusion, XOR and cofactors.
+  static bddCache<bddBinEntry> mApplyCache;
+  /// Cache for quantification of cubes.
+  static bddCache<bddBinEntry> mQuantCache;
+  /// Cache for the relational product.
+  static bddCache<bddTerEntry> mAndExistsCache;
+  /// Cache for if-then-else.
+  static bddCache<bddTerEntry> mIteCache;
+  /// Cache for operations with variable ids as arguments: 
+  ///   Quantification of single variables, renaming, and the support
+  ///   nodes of testVars().
+  static bddCache<bddBinEntry> mVarCache;
+  /// Cache for the results of getTupleNr() and getNodeNr().
+  static bddCache<bddStatEntry> mStatCache;
+
+  /// Cache argument for replaceVars_() per renaming (variable map),
+  ///   such that the cache entries of a renaming are reused by later calls.
+  static map<vector<unsigned>, unsigned> mReplaceKeys;
+
+  /// Pool of threads for parallel operations (see setThreadNr()).
+  static bddTaskPool mPool;
+  /// Depth of forking of parallel operations, 0 if sequential.
+  static unsigned mForkDepth;
+  /// True during parallel operations: The threads synchronise 
+  ///   their accesses to mUniqueHash, mFree and the caches.
+  static bool mParallel;
+  /// Spin lock of the list mFree in parallel operations.
+  static volatile int mFreeLock;
+
+  /// Number of live nodes that makes reordering due (0 for never).
+  static unsigned mReorderThreshold;
+  /// Set by the garbage collections in operations (reclaim(), 
+  ///   reclaimInOp(), gcIfDue()) if the number of live nodes 
+  ///   exceeds mReorderThreshold.
+  static bool mReorderDue;
+  /// Only during reordering: Numbers of references per element of mNodes,
+  ///   i.e., external references plus edges from live nodes.
+  ///   Nodes are freed as soon as their counter drops to 0.
+  static unsigned* mRefCnts;
+  /// Only during reordering: Nodes per variable id.
+  ///   The lists may contain stale entries (see getVarNodes()).
+  static vector< vector<unsigned> > mVarNodes;
+  /// Only during reordering: Number of live nodes.
+  static unsigned mLiveNr;
+
+  /// Set by the garbage collections if the used nodes are scattered 
+  ///   (see isCompactDue()).
+  static bool mCompactDue;
+  /// Scattered edges per live node after the last compaction.
+  static double mCompactFarRatio;
+  /// Only during compaction: New index per element of mNodes
+  ///   (see forwardEdge()).
+  static unsigned* mForward;
+
+  /// Visited markers of the traversals (e.g., getNodeNr()), one per 
+  ///   element of mNodes (parallel array): Each traversal takes a new 
+  ///   epoch (see newEpoch()) and stamps the visited nodes with it,
+  ///   such that no pass is needed to reset the markers.
+  ///   The stamps are reset only when the epochs wrap around.
+  ///   Only the main thread traverses, parallel operations do not.
+  static unsigned short* mStamps;
+  /// Epoch of the last traversal (never 0, the initial stamp, and never
+  ///   mOpEpoch).
+  static unsigned short mEpoch;
+  /// Stamp of the intermediate results of the current operation 
+  ///   (see protect()), an epoch of mStamps.
+  static unsigned short mOpEpoch;
+  /// Set during a garbage collection in the middle of an operation
+  ///   (see reclaimInOp()).
+  static bool mGcInOp;
+
+  /// Statistics for printStats().
+  /// Number of calls of the public operations, per operation identifier.
+  static unsigned long mCallNr[mOpNr];
+  /// Searches in mUniqueHash.
+  static bddProbeCounts mProbeCounts;
+  /// In parallel operations: The same per thread of mPool,
+  ///   added to mProbeCounts by setParallel(false).
+  static vector<bddProbeCounts> mThreadProbeCounts;
+  /// Numbers of major and minor garbage collections, and their 
+  ///   processor time in seconds.
+  static unsigned long mGcNr;
+  static unsigned long mGcMinorNr;
+  static double mGcTime;
+  /// Overall number of nodes freed by garbage collections.
+  static unsigned long mReclaimedNr;
+  /// Maximum number of live nodes after, resp. used nodes before
+  ///   a garbage collection.
+  static unsigned mPeakLiveNr;
+  static unsigned mPeakUsedNr;
+  /// Maximum number of used nodes since resetPeakNodeNr().
+  static unsigned mPeakMarkNr;
+  /// Overall number of nodes created by insert().
+  static unsigned long mCreatedNr;
+
+  /// Observer of garbage collections, growth and reordering (0 for none).
+  static bddObserver mObserver;
+  /// Numbers of growths of the node array, of resizes of mUniqueHash,
+  ///   and of variable reorderings.
+  static unsigned long mGrowNr;
+  static unsigned long mUniqueResizeNr;
+  static unsigned long mReorderNr;
+  static unsigned long mCompactNr;
+  /// Number of compactions skipped because memory was exhausted.
+  static unsigned long mCompactSkipNr;
+  /// Number of operations that continued after reclaimInOp().
+  static unsigned long mResumeNr;
 
 private: // Private static methods.
 
-  /// Hash/cache functions with 1 and 3 arguments.
-  /// Possible return values: 0..(1<<hashBitNr)-1.
-  static inline unsigned 
-  hash(unsigned p1, unsigned pHashBitNr);
+  /// Index (in mNodes) of the node that the edge pEdge points to.
+  static unsigned 
+  getNode(unsigned pEdge)
+  { return pEdge >> 1; }
+  /// Variable id of the node that the edge pEdge points to.
+  static unsigned 
+  getVar(unsigned pEdge)
+  { return mNodes[pEdge >> 1].var; }
+  /// Low cofactor of the function represented by the edge pEdge.
+  static unsigned 
+  getLow(unsigned pEdge)
+  { return mNodes[pEdge >> 1].low ^ (pEdge & 1); }
+  /// High cofactor of the function represented by the edge pEdge.
+  static unsigned 
+  getHigh(unsigned pEdge)
+  { return mNodes[pEdge >> 1].high ^ (pEdge & 1); }
+
+  /// Hash function for mUniqueHash (32 bits).
   static inline unsigned 
-  hash(unsigned p1, unsigned p2, unsigned p3, unsigned pHashBitNr);
+  hash(unsigned p1, unsigned p2, unsigned p3);
+  /// Returns the tag of hash value pHash in the buckets of mUniqueHash.
+  ///   Never 0, which denotes empty slots.
+  static unsigned short
+  getTag(unsigned pHash)
+  { unsigned short lTag = (unsigned short) (pHash ^ (pHash >> 16));
+    return (lTag != 0) ? lTag : 1; }
+  /// Returns the number of bits (at least pMinBitNr) of a unique table
+  ///   that holds pNodeNr nodes with some room for probing.
+  static unsigned
+  getUniqueHBitNr(unsigned pMinBitNr, unsigned pNodeNr);
+  /// Allocates an empty unique table with 2^pBitNr buckets.
+  ///   Returns false if memory is exhausted.
+  static bool
+  allocUniqueHash(unsigned pBitNr);
   /// Ensures that p1 <= p2.
   static inline void 
   normalize(unsigned& p1, unsigned& p2);
 
   /// Marks (mark=1) all nodes of the BDD with the root pRoot.
+  ///   pStack is the (empty) explicit stack of the traversal.
+  static void 
+  mark(unsigned pRoot, vector<unsigned>& pStack);
+  /// Returns true if the node of pEdge is marked.
+  static bool
+  isMarked(unsigned pEdge)
+  { return mNodes[pEdge >> 1].mark; }
+  /// Marks (mark=1) all young nodes of the BDD with the root pRoot.
   static void 
-  mark(unsigned pRoot);
-  /// Unmarks (mark=0) all nodes of the BDD with the root pRoot.
-  /// Terminal always remain marked.
+  markYoung(unsigned pRoot, vector<unsigned>& pStack);
+  /// Returns true if the node of pEdge is marked or old.
+  static bool
+  isMarkedOrOld(unsigned pEdge)
+  { return mNodes[pEdge >> 1].mark  ||  mNodes[pEdge >> 1].old; }
+  /// Moves all young nodes of the BDD with the root pRoot 
+  ///   into the old generation.
+  ///   pStack is the (empty) explicit stack of the traversal.
   static void 
-  unMark(unsigned pRoot);
+  promote(unsigned pRoot, vector<unsigned>& pStack);
+  /// Inserts node pNode into the list of unused nodes.
+  static void
+  freeNode(unsigned pNode);
+  /// Only during compaction: Returns the edge to the new place 
+  ///   of the node of pEdge.
+  static unsigned
+  forwardEdge(unsigned pEdge)
+  { return (mForward[pEdge >> 1] << 1) | (pEdge & 1); }
+  /// Only during compaction: Appends the nodes below the externally 
+  ///   referenced node pNode that have no new index yet to pOrder, 
+  ///   breadth-first, and assigns them the next free slots from pSlot on
+  ///   (skipping the externally referenced nodes) as new indices.
+  static void
+  placeBreadthFirst(unsigned pNode, 
+                    vector<unsigned>& pOrder, 
+                    unsigned& pSlot);
+  /// Returns a new stamp for a traversal (see mStamps).
+  static unsigned short
+  newEpoch();
+  /// Stamps the node pNode (not the terminal) with pEpoch.
+  ///   Returns false if it was already stamped, i.e., visited.
+  static bool
+  visit(unsigned pNode, unsigned short pEpoch)
+  {
+    if(pNode == 0  ||  mStamps[pNode] == pEpoch)
+    {
+      return false;
+    }
+    mStamps[pNode] = pEpoch;
+    return true;
+  }
+  /// Protects the node of pEdge, an intermediate result of the current 
+  ///   operation (created by insert() or found in the unique table or 
+  ///   a cache), from garbage collection by reclaimInOp(). Returns pEdge.
+  static unsigned
+  protect(unsigned pEdge)
+  {
+    if(!isParallel())
+    {
+      mStamps[pEdge >> 1] = mOpEpoch;
+    }
+    return pEdge;
+  }
+  /// Returns true if node pNode is protected during reclaimInOp().
+  static bool
+  isProtected(unsigned pNode)
+  { return mGcInOp  &&  mStamps[pNode] == mOpEpoch; }
+  /// Ends the protection of the intermediate results after a garbage 
+  ///   collection between operations.
+  static void
+  unprotectIfSafe();
 
   /// Garbage collection: All dead nodes (i.e. all nodes which are not reachable
-  /// from a node in mExtRefs) are freed (i.e. inserted into unused-list mFree).
+  /// from an externally referenced node or, during reclaimInOp(), 
+  /// from a protected node) are freed (i.e. inserted into unused-list mFree).
   /// Terminal nodes are never freed.
   static void 
   gc();
 
-  /// Returns the mNodes-index of the node with the passed var-, low- and
-  /// high-values. If such node does not exists, it is inserted into
+  /// Minor garbage collection: Only the young nodes are marked,
+  ///   old nodes are assumed to be live.
+  static void 
+  gcMinor();
+
+  /// Updates the statistics after a garbage collection that started 
+  ///   at processor time pStart with pUsedNr used nodes.
+  static void
+  countGc(clock_t pStart, unsigned pUsedNr);
+
+  /// Frees all unmarked nodes (except old nodes if pKeepOld), 
+  ///   unmarks the others, and rebuilds mUniqueHash.
+  /// Returns the number of scattered edges between used nodes
+  ///   (see mCompactNearNr).
+  static unsigned
+  sweep(bool pKeepOld);
+  /// Sets mCompactDue after a garbage collection 
+  ///   that found pFarNr scattered edges.
+  static void
+  checkScatter(unsigned pFarNr);
+
+  /// Proactive garbage collection before an operation:
+  ///   Runs gcMinor() if few nodes are free and many nodes are 
+  ///   probably dead (see mGcLiveNr), and makes reordering due 
+  ///   as reclaim(). Starts the protection of the
+  ///   intermediate results of the operation (see protect()).
+  static void
+  gcIfDue();
+
+  /// Grows the node array, the hash table, and the caches.
+  /// Returns false if the limit is reached or memory is exhausted.
+  static bool
+  grow();
+
+  /// Provides free nodes when insert() runs out of nodes in the middle
+  /// of an operation: Garbage collection that keeps the intermediate 
+  /// results of the operation, and growth of the tables if garbage 
+  /// collection does not free enough nodes. The operation continues.
+  static void
+  reclaimInOp();
+
+  /// Provides free nodes after insert() failed in the pTry-th try 
+  /// of an operation: Garbage collection, and growth of the tables
+  /// if garbage collection does not free enough nodes.
+  static void
+  reclaim(unsigned pTry);
+
+  /// Adds a search in mUniqueHash that visited pProbeNr buckets 
+  ///   to the statistics pCounts.
+  static inline void
+  countProbes(unsigned pProbeNr, bddProbeCounts& pCounts);
+
+  /// Removes node pNode from resp. inserts it into mUniqueHash.
+  ///   hashInsert() does not check whether an equal node exists.
+  static void
+  hashRemove(unsigned pNode);
+  static void
+  hashInsert(unsigned pNode);
+
+  /// Reference counting during reordering (see mRefCnts).
+  /// unRef() frees the node if it is not referenced any more.
+  static void
+  ref(unsigned pEdge);
+  static void
+  unRef(unsigned pEdge);
+  /// Like insert(), but registers a new node for reordering.
+  static unsigned
+  insertRef(unsigned pVar, unsigned pLow, unsigned pHigh);
+  /// Returns the live nodes with variable id pVar, without stale entries.
+  static const vector<unsigned>&
+  getVarNodes(unsigned pVar);
+  /// Exchanges the variables pVar1 and pVar2 (pVar1 < pVar2) in place,
+  ///   i.e., all edges keep their functions.
+  /// There must be no node with a variable id between pVar1 and pVar2.
+  /// Returns false (without any change) if there are not enough free nodes.
+  static bool
+  swapVars(unsigned pVar1, unsigned pVar2);
+  /// Exchanges the two blocks of pBlockSize variables beginning at 
+  ///   pVarId1 and pVarId2 (pVarId1 < pVarId2), keeping the order 
+  ///   within the blocks. There must be no node between the blocks.
+  /// Returns false (without any change) if there are not enough free nodes.
+  static bool
+  swapBlocks(unsigned pVarId1, unsigned pVarId2, unsigned pBlockSize);
+
+  /// Returns the edge to the node with the passed var-, low- and
+  /// high-edges. If such node does not exists, it is inserted into
   /// mNodes and mUniqueHash. If there are no free nodes left, throws exception.
+  /// If pLow is complemented, the node for the negated sons is used 
+  /// and the complemented edge is returned.
   static unsigned 
   insert(unsigned pVar, unsigned pLow, unsigned pHigh);
+  /// Like insert(), but for parallel operations. pHash is the hash value.
+  static unsigned 
+  insertShared(unsigned pVar, unsigned pLow, unsigned pHigh, unsigned pHash);
+  /// Returns the index of the node with the passed var-, low- and 
+  ///   high-edges and the hash value pHash, or 0 if there is no such node.
+  ///   pShared is true in parallel operations (see matchShared()).
+  static inline unsigned
+  findNode(unsigned pVar, unsigned pLow, unsigned pHigh, unsigned pHash,
+           bool pShared);
 
-  /// Check if there is any BDD node between the variables.
-  bool
-  testVars_(unsigned pRoot, 
-            unsigned pVarIdFirst, 
-            unsigned pVarIdLast);
-  /// Returns number of represented tuples of the BDD with root pRoot.
-  /// The BDD must not contain nodes with other variable ids.
-  /// pVar is the first and pMaxVar is the maximum id of a variable.
+  /// Returns the edge to a node of the BDD with root pRoot with the 
+  ///   smallest variable id >= pVarId, or 0 if there is no such node.
+  static unsigned
+  getSupportNode_(unsigned pRoot, unsigned pVarId);
+  /// Returns the fraction of all variable assignments which satisfy 
+  /// the BDD with root pRoot, as mantissa * 2^pExponent. The fraction 
+  /// does not depend on the number of variables, thus the cache entries 
+  /// can be used for all variable ranges.
   static double 
-  getTupleNr_(unsigned pRoot, unsigned pVar, unsigned pMaxVar);
+  getDensity_(unsigned pRoot, int& pExponent);
   /// Returns the elements pVar ... pMaxVar of an arbitrary tuple of the BDD.
   static unsigned 
   getTuple_(unsigned pRoot, unsigned pVar, unsigned pMaxVar);
-  /// Returns number of nodes of the BDD with root pRoot.
-  /// (Terminal nodes are not counted). Side effect: counted nodes are marked.
+  /// Returns number of nodes of the BDD with root pRoot that are not 
+  /// stamped with pEpoch yet, and stamps them.
+  /// (Terminal nodes are not counted).
   static unsigned 
-  getNodeNr_(unsigned pRoot);
+  getNodeNr_(unsigned pRoot, unsigned short pEpoch);
   /// Computes the number of nodes per variable id.
   static void
   getNodesPerVarId_(unsigned pRoot, 
-                    map<unsigned, unsigned>& pBddNodesPerVar);
+                    map<unsigned, unsigned>& pBddNodesPerVar,
+                    unsigned short pEpoch);
   /// Creates output graph representation for BDD with root pRoot.
+  /// Complemented edges are expanded, i.e., the graph is a plain BDD 
+  /// with the terminals 0 and 1, and the ids of the nodes are edges.
   static void
   getGraph_(unsigned pRoot, 
-            multimap<unsigned,bddGraphNode>& pGraph);
+            multimap<unsigned,bddGraphNode>& pGraph,
+            set<unsigned>& pVisited);
   /// Prints BDD with root pRoot as reduced binary decision tree.
   static void 
   print_(ostream& pS, unsigned pRoot);
@@ -197,21 +775,71 @@ private: // Private static methods.
   static bool 
   setContains_(unsigned pRoot1, unsigned pRoot2);
 
+  /// Computes operation pOp (mIntersect or mAndExists) 
+  ///   with pFork levels of forking.
+  static unsigned
+  apply_(unsigned pOp, unsigned pArg1, unsigned pArg2, unsigned pArg3, 
+         unsigned pFork);
+  /// Executes pTask of mPool. Catches all exceptions (pTask->failed).
+  static void
+  runTask(bddTask* pTask);
+  /// Computes operation pOp for (pLow1, pLow2, pArg3) and, 
+  ///   possibly by another thread, for (pHigh1, pHigh2, pArg3) 
+  ///   with pFork - 1 levels of forking. Returns the results in pLow, pHigh.
+  ///   Throws an exception if one of the computations failed.
+  static void
+  forkSons_(unsigned pOp, 
+            unsigned pLow1, unsigned pLow2, 
+            unsigned pHigh1, unsigned pHigh2, 
+            unsigned pArg3, unsigned pFork,
+            unsigned& pLow, unsigned& pHigh);
+  /// Computes operation pOp (mIntersect or mAndExists) for the arguments
+  ///   with all threads of mPool, or sequentially if there is no pool.
+  ///   Exceptions leave the parallel mode, too.
+  static unsigned
+  parallel_(unsigned pOp, unsigned pArg1, unsigned pArg2, unsigned pArg3);
+  /// Switches to resp. from parallel operations (see mParallel).
+  static void
+  setParallel(bool pParallel);
+  /// Returns mParallel. The workers read it, too.
+  static bool
+  isParallel()
+  { return __atomic_load_n(&mParallel, __ATOMIC_ACQUIRE); }
+
   /// Like the equally named non-static functions, 
   /// except that the static versions do not catch exceptions.
+  /// The recursions for the sons run in parallel (see mPool) 
+  ///   up to the depth pFork.
   static unsigned 
   complement_(unsigned pRoot);
   static unsigned 
-  unite_(unsigned pRoot1, unsigned pRoot2);
+  unite_(unsigned pRoot1, unsigned pRoot2, unsigned pFork = 0);
   static unsigned 
-  intersect_(unsigned pRoot1, unsigned pRoot2);
+  intersect_(unsigned pRoot1, unsigned pRoot2, unsigned pFork = 0);
   static unsigned 
   exists_(unsigned pRoot, unsigned pVar);
   static unsigned 
-  renameVars_(unsigned pRoot, 
-              unsigned pFirst, 
-              unsigned pLast, 
-              int      pOffset);
+  existsCube_(unsigned pRoot, unsigned pCube);
+  static unsigned 
+  forallCube_(unsigned pRoot, unsigned pCube);
+  static unsigned 
+  andExists_(unsigned pRoot1, unsigned pRoot2, unsigned pCube, 
+             unsigned pFork = 0);
+  static unsigned 
+  xor_(unsigned pRoot1, unsigned pRoot2);
+  static unsigned 
+  ite_(unsigned pIf, unsigned pThen, unsigned pElse);
+  static void
+  writeNodes_(unsigned pRoot, 
+              unsigned short pEpoch,
+              vector<unsigned>& pIndices, 
+              vector<unsigned>& pTriples);
+  static unsigned 
+  restrict_(unsigned pRoot, unsigned pCube);
+  static unsigned 
+  replaceVars_(unsigned                pRoot, 
+               const vector<unsigned>& pVarMap,
+               unsigned                pKey);
 
 public: // Public static methods.
 
@@ -219,27 +847,154 @@ public: // Public static methods.
   /// function of the package is used.
   /// Parameters: Values for the m... variables.
   ///   number of elements of mNodes == pNodes,
-  ///   number of elements of mUniqueHash == 2^pUniqueHBitNr,
-  ///   number of elements of mBinCache == 2^pBinCBitNr.
-  ///   number of elements of mStatCache == 2^pStatCBitNr.
+  ///   number of buckets of mUniqueHash == 2^(pUniqueHBitNr-2),
+  ///     or more if the nodes do not fit in,
+  ///   number of entries of mApplyCache, mQuantCache, mAndExistsCache,
+  ///     mIteCache and mVarCache == 2^pBinCBitNr each,
+  ///   number of entries of mStatCache == 2^pStatCBitNr.
+  /// These are initial sizes. The tables grow on demand,
+  ///   up to pNodeNrLimit nodes (0 for no limit).
   static void
   init(unsigned pMaxNodeNr, 
-    unsigned pUniqueHBitNr, unsigned pBinCBitNr, unsigned pStatCBitNr);
+    unsigned pUniqueHBitNr, unsigned pBinCBitNr, unsigned pStatCBitNr,
+    unsigned pNodeNrLimit = 0);
   /// Frees memory used by the static data structures.
   /// To be called after use of the BDD package.
   static void done ();
 
+  /// Sets the replacement policy of all caches.
+  static void
+  setCachePolicy(bddCachePolicy pPolicy);
+
+  /// Computes intersection, union and the relational product 
+  ///   with pThreadNr threads (1 for sequential computation).
+  /// Returns false if the threads cannot be created.
+  static bool
+  setThreadNr(unsigned pThreadNr);
+
   /// Returns overall number of live nodes (Terminal nodes are not counted).
   static unsigned 
   getReachNodeNr();
-  /// Returns number of external (user) references in mExtrefs.
+  /// Returns number of external (user) references.
   static unsigned 
   getExtRefNr();
 
-  /// Prints list lengths in mUniqueHash.
+  /// Prints the numbers of nodes per bucket of mUniqueHash.
   static void 
   analyseUniqueHash ();
 
+  /// Writes the statistics of the package (calls and cache hits
+  ///   per operation, unique table, garbage collections, growth)
+  ///   as JSON object to pS. Must be called before done().
+  static void
+  printStats(ostream& pS);
+
+  /// Returns the number of nodes created since init().
+  static unsigned long
+  getCreatedNodeNr()
+  { return mCreatedNr; }
+  /// Returns the maximum number of used (live or dead) nodes 
+  ///   since the last call of resetPeakNodeNr(). 
+  ///   Between garbage collections, the number of used nodes only grows,
+  ///   thus it is checked before each collection and by this call.
+  static unsigned
+  getPeakNodeNr();
+  /// Restarts the measurement of getPeakNodeNr(), with the current 
+  ///   number of used nodes, or pNodeNr if this is larger.
+  static void
+  resetPeakNodeNr(unsigned pNodeNr = 0);
+
+  /// Returns the number of used (live or dead) nodes without 
+  ///   garbage collection, resp. the number of live nodes after 
+  ///   the last garbage collection (see mGcLiveNr).
+  static unsigned
+  getUsedNodeNr()
+  { return mMaxNodeNr - 1 - mFreeNr; }
+  static unsigned
+  getGcLiveNodeNr()
+  { return mGcLiveNr; }
+  /// Returns the number of unused nodes (see mFree), without 
+  ///   garbage collection.
+  static unsigned
+  getUnusedNodeNr()
+  { return mFreeNr; }
+  /// Returns the overall numbers of lookups resp. hits of all caches.
+  static unsigned long
+  getCacheLookupNr();
+  static unsigned long
+  getCacheHitNr();
+
+  /// Sets the observer of garbage collections, growth and reordering
+  ///   (0 for none), e.g. for tracing.
+  static void
+  setObserver(bddObserver pObserver)
+  { mObserver = pObserver; }
+
+  /// Moves all live nodes into the old generation, which minor garbage
+  ///   collections do not scan. For long-lived BDDs, e.g., input data.
+  /// Old nodes are freed only by major garbage collections.
+  static void
+  promoteAll();
+
+  /// Writes the nodes of the BDDs pBdds (shared, each node once) 
+  ///   and their roots to pOut, in binary form (host byte order):
+  ///   The number of nodes n, n triples (var, low, high), children before
+  ///   parents, the number of roots and the roots. Edges are 
+  ///   (i << 1) | complement, where i is the index (from 1) of the node
+  ///   in the file, and 0 the terminal.
+  static void
+  writeNodes(ostream& pOut, const vector<bddBdd>& pBdds);
+  /// Creates the BDDs written by writeNodes() from the pSize bytes 
+  ///   at pData (e.g. a memory-mapped file), and appends them to pBdds.
+  ///   The variable ids are not changed (see replaceVars()).
+  /// Returns false if the data are corrupt or there is not enough memory.
+  static bool
+  readNodes(const char* pData, size_t pSize, vector<bddBdd>& pBdds);
+
+  /// Dynamic variable reordering by group sifting.
+  /// The variables are partitioned into blocks of pBlockSize variables,
+  ///   block b consists of the variable ids b*pBlockSize ... (b+1)*pBlockSize-1.
+  ///   Blocks are moved as a whole, the order within a block does not change.
+  /// pBlocks are the block numbers (ascending) that may be exchanged.
+  ///   If there are live nodes outside these blocks, nothing is changed.
+  /// All BDDs keep their roots, only the variable ids change.
+  /// Returns for each element of pBlocks the (old) block 
+  ///   that is now at its place.
+  static vector<unsigned>
+  reorderBlocks(unsigned pBlockSize, const vector<unsigned>& pBlocks);
+
+  /// Reordering is done automatically if (pNodeNr) nodes 
+  ///   are live at a garbage collection (0 for never).
+  ///   The threshold is doubled if reordering does not reduce
+  ///   the number of nodes below the half.
+  static void
+  setReorderThreshold(unsigned pNodeNr)
+  { mReorderThreshold = pNodeNr; }
+  /// Returns true if the threshold for reordering was passed.
+  ///   The package user calls reorderBlocks() when it is safe.
+  static bool
+  isReorderDue()
+  { return mReorderDue; }
+
+  /// Compacting garbage collection: Collects the garbage, and moves the
+  ///   used nodes to the beginning of mNodes, breadth-first from each root,
+  ///   such that the nodes of a BDD are close together in memory.
+  ///   The externally referenced nodes (the roots) stay in place,
+  ///   the cache entries are rewritten.
+  /// Not allowed while a bddTupleCursor exists (its path refers to nodes).
+  ///   Does nothing if memory is exhausted (counted in the statistics).
+  static void
+  compact();
+  /// Returns true if a garbage collection found the used nodes 
+  ///   scattered: More than half of the edges between them lead 
+  ///   farther than mCompactNearNr nodes, twice as many per live node
+  ///   as after the last compaction, and at least mCompactMinNr nodes 
+  ///   are live.
+  ///   The package user calls compact() when it is safe.
+  static bool
+  isCompactDue()
+  { return mCompactDue; }
+
 private: // Attributes.
 
   /// Index (in mNodes) of the Root node of the BDD.
@@ -247,24 +1002,25 @@ private: // Attributes.
 
 private: // Private methods.
 
-  /// Removes mRoot from mExtRefs (if mRoot is no terminal).
+  /// Decrements the reference counter of mRoot (if mRoot is no terminal).
   inline void decRef() 
   {
-    if(mRoot != 0 && mRoot != 1)
+    if(getNode(mRoot) != 0  &&  mExtRefCnts[getNode(mRoot)] != UINT_MAX)
     {
-      multiset<unsigned>::iterator lDelete = mExtRefs.find(mRoot);
       // Otherwise error in external BDD references.
-      assert(lDelete != mExtRefs.end());
-      mExtRefs.erase(lDelete);
+      assert(mExtRefCnts[getNode(mRoot)] > 0);
+      --mExtRefCnts[getNode(mRoot)];
+      --mExtRefNr;
     }
   }
 
-  /// Inserts mRoot into mExtRefs (if mRoot is no terminal).
+  /// Increments the reference counter of mRoot (if mRoot is no terminal).
   inline void incRef() 
   {
-    if(mRoot != 0 && mRoot != 1)
+    if(getNode(mRoot) != 0  &&  mExtRefCnts[getNode(mRoot)] != UINT_MAX)
     {
-      mExtRefs.insert(mRoot);
+      ++mExtRefCnts[getNode(mRoot)];
+      ++mExtRefNr;
     }
   }
 
@@ -317,24 +1073,35 @@ public: // Constructors and destructor.
   static unsigned 
   mkLessEqual_(unsigned pVarId, unsigned pBitNr, unsigned pValue);
 
+  /// Non-standard named constructor.
+  /// Creates BDD for the conjunction of the variables 'pVarIds' (a cube).
+  /// Cubes are used as sets of variables for quantification.
+  static bddBdd
+  mkCube (const set<unsigned>& pVarIds);
+  static unsigned 
+  mkCube_(const set<unsigned>& pVarIds);
+
 public: // Accessors.
 
   /// Check if there is any BDD node within the given range of var positions.
   /// Returns 'true' if any such node is found.
+  /// Repeated checks of the same root are lookups in its cached support.
   bool
-  testVars(unsigned pVarIdFirst, unsigned pVarIdLast)
-  {
-    bool lResult = testVars_(mRoot, pVarIdFirst, pVarIdLast);
-    unMark(mRoot);
-    return lResult;
-  }
+  testVars(unsigned pVarIdFirst, unsigned pVarIdLast) const;
 
   /// Returns number of represented tuples.
   /// The BDD must not contain nodes with other variables.
   /// pMinVar is the minimum and pMaxVar is the maximum id of a variable.
   double
   getTupleNr(unsigned pMinVar, unsigned pMaxVar) const
-  { return getTupleNr_(mRoot, pMinVar, pMaxVar); }
+  { 
+    // Forbid nodes with variable id less than 'pMinVar'.
+    assert(getVar(mRoot) >= pMinVar);
+    ++mCallNr[mDensity];
+    int lExp;
+    const double lDensity = getDensity_(mRoot, lExp);
+    return ldexp(lDensity, lExp + (int) (pMaxVar - pMinVar + 1)); 
+  }
 
   /// Returns the elements pMinVar ... pMaxVar of an arbitrary tuple of the BDD.
   unsigned
@@ -348,12 +1115,13 @@ public: // Accessors.
   unsigned 
   getNodeNr() const;
 
-  /// Returns number of free nodes.
-  ///   Includes garbage collection to get real values.
+  /// Returns number of free nodes, without garbage collection:
+  ///   The unused nodes, and the young nodes created since the last 
+  ///   garbage collection, which are probably dead (see mGcLiveNr).
   unsigned
   getFreeNodeNr() const;
 
-  /// Returns maximal number of nodes in BDD package.
+  /// Returns current size of the node array of the BDD package.
   unsigned
   getMaxNodeNr() const
   { return mMaxNodeNr; }
@@ -362,15 +1130,14 @@ public: // Accessors.
   map<unsigned, unsigned>
   getNodesPerVarId() const
   { map<unsigned, unsigned> lBddNodesPerVar;
-    getNodesPerVarId_(mRoot, lBddNodesPerVar);
-    unMark(mRoot);
+    getNodesPerVarId_(mRoot, lBddNodesPerVar, newEpoch());
     return lBddNodesPerVar;  }
 
   /// Creates output graph representation for BDD.
   void
   getGraph(multimap<unsigned,bddGraphNode>& pGraph) const 
-  { getGraph_(mRoot, pGraph);
-    unMark(mRoot);  }
+  { set<unsigned> lVisited;
+    getGraph_(mRoot, pGraph, lVisited);  }
 
   /// Prints BDD as reduced binary decision tree.
   void 
@@ -388,7 +1155,10 @@ public: // Service methods.
   /// Check if pBdd represents a subset of *this.
   bool 
   setContains(const bddBdd& pBdd) const
-  { return setContains_(mRoot, pBdd.mRoot); }
+  { 
+    ++mCallNr[mSetContains];
+    return setContains_(mRoot, pBdd.mRoot); 
+  }
 
   /// Check if the represented set is empty.
   bool 
@@ -396,14 +1166,17 @@ public: // Service methods.
   { return mRoot == 0; }
 
 
-  /// All of the following operations catch exceptions thrown by insert(),
-  ///   call a garbage collection gc(), and call the operation again.
-  /// If the second try does not work too, the program is aborted.
-
-  /// Computes complement.
+  /// Computes complement. Constant time, flips the complement bit of mRoot.
   void 
   complement();
 
+  /// When the node array is full, the following operations continue 
+  ///   after garbage collection and growth of the tables (reclaimInOp()).
+  ///   If this fails (e.g., during parallel operations), they catch the 
+  ///   exception thrown by insert(), call reclaim() for garbage collection
+  ///   and growth of the tables, and call the operation again.
+  /// If the tables cannot grow any more, the program is aborted.
+
   /// Unites with pBdd.
   void 
   unite(const bddBdd& pBdd);
@@ -416,12 +1189,120 @@ public: // Service methods.
   void 
   exists(unsigned pVar);
 
-  /// Rename variable ids of all nodes from pFirst to pLast
-  ///   by adding pOffset to the variable ids.
-  /// Precondition: pLast - pFirst has to be the same for all calls of this method,
-  ///   because the cache entries contain only pFirst and pOffset.
+  /// Existential quantification of all variables of the cube pCube 
+  ///   (see mkCube()) in one pass.
+  void 
+  exists(const bddBdd& pCube);
+
+  /// Universal quantification of all variables of the cube pCube 
+  ///   in one pass.
+  void 
+  forall(const bddBdd& pCube);
+
+  /// Relational product: Intersects with pBdd and quantifies existentially 
+  ///   the variables of the cube pCube (see mkCube()).
+  /// Computed in one pass, i.e., the intersection is never built.
+  void 
+  andExists(const bddBdd& pBdd, const bddBdd& pCube);
+
+  /// If-then-else: Becomes pThen where *this holds, and pElse elsewhere.
+  void 
+  ifThenElse(const bddBdd& pThen, const bddBdd& pElse);
+
+  /// Becomes the symmetric difference (XOR) with pBdd.
+  void 
+  exclusiveOr(const bddBdd& pBdd);
+
+  /// Becomes the equivalence (XNOR) with pBdd, i.e., the complement 
+  ///   of the symmetric difference. Shares the cache with exclusiveOr().
   void 
-  renameVars(unsigned pFirst, unsigned pLast, int pOffset);
+  equivalence(const bddBdd& pBdd);
+
+  /// Becomes the implication *this -> pBdd, i.e., !(*this & !pBdd).
+  ///   Shares the cache with intersect().
+  void 
+  implication(const bddBdd& pBdd);
+
+  /// Removes the elements of pBdd, i.e., becomes *this & !pBdd.
+  ///   Shares the cache with intersect().
+  void 
+  difference(const bddBdd& pBdd);
+
+  /// Becomes the cofactor for the literals of pCube, i.e., the BDD
+  ///   below the assignment pCube, without the variables of pCube.
+  ///   pCube must be a conjunction of literals (e.g. bddBdd(pVarId, 
+  ///   pBitNr, pValue)). Same as intersect(pCube) followed by exists()
+  ///   over the variables of pCube, but in one pass that visits only 
+  ///   the nodes above the variables of pCube and the selected sub-BDD.
+  void 
+  restrict(const bddBdd& pCube);
+
+  /// Replaces each variable id v < pVarMap.size() by pVarMap[v],
+  ///   all at once. Any map is allowed: If the variable order changes,
+  ///   the BDD is rebuilt, and variables mapped to the same id
+  ///   are identified (e.g., R(x,y) becomes R(x,x)).
+  void 
+  replaceVars(const vector<unsigned>& pVarMap);
+};
+
+/// Cursor over the tuples of a BDD in lexicographic order, i.e., over 
+///   its satisfying assignments, read as tuples of unsigned values.
+/// Element i of a tuple consists of the pBitNr variables beginning 
+///   at pBlocks[i] (ascending, first variable is the most significant bit).
+///   The BDD must not contain other variables.
+///   Variables without nodes (don't cares) are expanded to both values,
+///   but values greater than pMaxValue are skipped.
+/// The cursor holds a reference to the BDD, so garbage collections
+///   during the enumeration are safe, reordering is not.
+class bddTupleCursor
+{
+private: // Attributes.
+
+  /// The enumerated BDD.
+  bddBdd mBdd;
+  /// Enumerated variable ids, i.e. the blocks, in ascending order.
+  vector<unsigned> mVars;
+  unsigned mBitNr;
+  unsigned mMaxValue;
+  /// Current path: mEdges[d] is the edge before the decision for mVars[d],
+  ///   mBits[d] the decision, mPrefixes[d+1] the value of the bits 
+  ///   of the current element up to mVars[d].
+  vector<unsigned> mEdges;
+  vector<unsigned> mBits;
+  vector<unsigned> mPrefixes;
+  /// Current tuple.
+  vector<unsigned> mTuple;
+  /// False after the last tuple.
+  bool mValid;
+
+private: // Private methods.
+
+  /// Extends the path from depth pDepth to the next complete tuple,
+  ///   trying bit values from pBit on at pDepth, and backtracking if needed.
+  /// Returns false if there is no further tuple.
+  bool
+  advance(unsigned pDepth, unsigned pBit);
+
+public: // Public methods.
+
+  bddTupleCursor(const bddBdd& pBdd,
+                 const vector<unsigned>& pBlocks,
+                 unsigned pBitNr,
+                 unsigned pMaxValue);
+
+  /// Returns false after the last tuple.
+  bool
+  isValid() const
+  { return mValid; }
+
+  /// Returns the current tuple (one value per block).
+  const vector<unsigned>&
+  getTuple() const
+  { return mTuple; }
+
+  /// Advances to the next tuple.
+  void
+  next();
 };
 
 #endif
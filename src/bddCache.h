@@ -0,0 +1,508 @@
+/*
+ * CrocoPat is a tool for relational programming.
+ * This file is part of CrocoPat. 
+ *
+ * Copyright (C) 2002-2008  Dirk Beyer
+ *
+ * CrocoPat is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * CrocoPat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with CrocoPat; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Please find the GNU Lesser General Public License in file
+ * License_LGPL.txt or at http://www.gnu.org/licenses/lgpl.txt
+ *
+ * Author:
+ * Dirk Beyer (firstname.lastname@sfu.ca)
+ * Simon Fraser University
+ *
+ * With contributions of: Andreas Noack, Michael Vogel
+ */
+
+#ifndef _bddCache_h
+#define _bddCache_h
+
+#include "bddPool.h"
+
+#include <cstdlib>
+#include <cstring>
+
+/// Replacement policies of the operation caches.
+///   LRU:  A hit in the second way of a set moves the entry to the first way.
+///   FIFO: Hits do not change a set, 
+///         a new entry always evicts the older entry of its set.
+typedef enum {LRU, FIFO} bddCachePolicy;
+
+/// Cache entry for binary operations.
+///   Unused entries have op == 0.
+struct bddBinEntry
+{
+  typedef unsigned Result;
+
+  /// Identifier of the operation
+  unsigned op;
+  /// Arguments of the operation
+  unsigned arg1;
+  unsigned arg2;
+  /// Result of the operation
+  Result result;
+
+  bool
+  matches(unsigned pOp, unsigned pArg1, unsigned pArg2, unsigned) const
+  { return op == pOp  &&  arg1 == pArg1  &&  arg2 == pArg2; }
+  void
+  set(unsigned pOp, unsigned pArg1, unsigned pArg2, unsigned, Result pResult)
+  { op = pOp;  arg1 = pArg1;  arg2 = pArg2;  result = pResult; }
+  unsigned
+  getArg2() const
+  { return arg2; }
+  unsigned
+  getArg3() const
+  { return 0; }
+  unsigned
+  getResultEdge() const
+  { return result; }
+  void
+  setResultEdge(unsigned pEdge)
+  { result = pEdge; }
+};
+
+/// Cache entry for ternary operations.
+struct bddTerEntry
+{
+  typedef unsigned Result;
+
+  /// Identifier of the operation
+  unsigned op;
+  /// Arguments of the operation
+  unsigned arg1;
+  unsigned arg2;
+  unsigned arg3;
+  /// Result of the operation
+  Result result;
+
+  bool
+  matches(unsigned pOp, unsigned pArg1, unsigned pArg2, unsigned pArg3) const
+  { return op == pOp  &&  arg1 == pArg1  &&  arg2 == pArg2  &&  arg3 == pArg3; }
+  void
+  set(unsigned pOp, unsigned pArg1, unsigned pArg2, unsigned pArg3, 
+      Result pResult)
+  { op = pOp;  arg1 = pArg1;  arg2 = pArg2;  arg3 = pArg3;  result = pResult; }
+  unsigned
+  getArg2() const
+  { return arg2; }
+  unsigned
+  getArg3() const
+  { return arg3; }
+  unsigned
+  getResultEdge() const
+  { return result; }
+  void
+  setResultEdge(unsigned pEdge)
+  { result = pEdge; }
+};
+
+/// Cache entry for counting tuples.
+struct bddStatEntry
+{
+  /// Number value * 2^exponent. The separate exponent keeps the densities
+  ///   of relations with more than about 1000 bits from underflowing to 0.
+  struct Result
+  {
+    double value;
+    int exponent;
+  };
+
+  /// Identifier of the operation
+  unsigned op;
+  /// Argument of the operation
+  unsigned arg1;
+  /// Result of the operation
+  Result result;
+
+  bool
+  matches(unsigned pOp, unsigned pArg1, unsigned, unsigned) const
+  { return op == pOp  &&  arg1 == pArg1; }
+  void
+  set(unsigned pOp, unsigned pArg1, unsigned, unsigned, Result pResult)
+  { op = pOp;  arg1 = pArg1;  result = pResult; }
+  unsigned
+  getArg2() const
+  { return 0; }
+  unsigned
+  getArg3() const
+  { return 0; }
+  unsigned
+  getResultEdge() const
+  { return 0; }
+  void
+  setResultEdge(unsigned)
+  {}
+};
+
+/// Cache for the results of one family of BDD operations.
+/// Entry is one of the cache entry types above.
+/// The cache is two-way set-associative: Each set consists of two entries,
+///   the first of which is the more recent one (see bddCachePolicy).
+/// The entries survive garbage collections. Instead of clearing the cache,
+///   sweep() drops exactly the entries that refer to dead nodes.
+/// Plain C allocation like the other tables of the BDD package:
+///   init() allocates, done() frees.
+/// In shared mode (see setShared()), several threads may look up and 
+///   insert concurrently. Then each access locks the set, 
+///   using one of mLockNr spin locks.
+template <class Entry>
+class bddCache
+{
+private: // Constants.
+
+  /// Number of locks for the sets in shared mode (a power of 2).
+  enum { mLockNr = 256 };
+  /// Bound of the operation codes for the statistics.
+  enum { mOpNr = 16 };
+
+private: // Attributes.
+
+  /// Entries, (2 << mSetBitNr) elements. Set i consists of 
+  ///   the elements 2*i and 2*i+1.
+  Entry* mEntries;
+  /// Number of sets == 2^mSetBitNr.
+  unsigned mSetBitNr;
+  /// Arguments that are BDD edges: Bit 0 for arg1, bit 1 for arg2, 
+  ///   bit 2 for arg3, bit 3 for the result (only for unsigned results).
+  ///   Only these are checked by sweep().
+  unsigned mEdgeMask;
+  /// Replacement policy.
+  bddCachePolicy mPolicy;
+  /// True if the cache is shared by several threads.
+  bool mShared;
+  /// Locks of the sets in shared mode, set i uses mLocks[i % mLockNr].
+  volatile int mLocks[mLockNr];
+  /// Statistics: Number of lookups resp. hits per operation code.
+  unsigned long mLookupNr[mOpNr];
+  unsigned long mHitNr[mOpNr];
+  /// In shared mode: The same per thread of mPool,
+  ///   added to mLookupNr resp. mHitNr by setShared(false).
+  struct Counts
+  {
+    unsigned long lookupNr[mOpNr];
+    unsigned long hitNr[mOpNr];
+  };
+  vector<Counts> mThreadCounts;
+  /// In shared mode: The threads that access the cache.
+  const bddTaskPool* mPool;
+
+private: // Private methods.
+
+  /// Returns the index of the first entry of the set for the arguments.
+  unsigned
+  getSet(unsigned pOp, unsigned pArg1, unsigned pArg2, unsigned pArg3) const
+  {
+    // Same mixing as the hash function of the unique table.
+    unsigned lShift1 = mSetBitNr >> 1;
+    unsigned lShift2 = mSetBitNr >> 2;
+    pArg1 += pOp;
+    pArg2 ^= 0x55555555;
+    return ((pArg1 + (pArg2 << lShift1) + (pArg2 >> lShift1)
+             + (pArg3 << lShift2) + (pArg3 >> lShift2))
+            & ((1u << mSetBitNr) - 1)) << 1;
+  }
+
+  /// Writes an entry into its set, the older entry of the set is evicted.
+  void
+  put(const Entry& pEntry)
+  {
+    if(mShared)
+    {
+      putShared(pEntry);
+      return;
+    }
+    Entry* lSet = mEntries 
+      + getSet(pEntry.op, pEntry.arg1, pEntry.getArg2(), pEntry.getArg3());
+    lSet[1] = lSet[0];
+    lSet[0] = pEntry;
+  }
+
+  /// Like put(), in shared mode: Writes the set under its lock.
+  ///   Not inlined, such that the sequential put() remains small.
+  BDD_NOINLINE void
+  putShared(const Entry& pEntry)
+  {
+    const unsigned lSet 
+      = getSet(pEntry.op, pEntry.arg1, pEntry.getArg2(), pEntry.getArg3());
+    lock(lSet);
+    mEntries[lSet + 1] = mEntries[lSet];
+    mEntries[lSet] = pEntry;
+    unlock(lSet);
+  }
+
+  /// Locks resp. unlocks the set with the first entry pSet in shared mode.
+  void
+  lock(unsigned pSet)
+  { bddLock(mLocks[(pSet >> 1) & (mLockNr - 1)]); }
+  void
+  unlock(unsigned pSet)
+  { bddUnlock(mLocks[(pSet >> 1) & (mLockNr - 1)]); }
+
+  /// Like lookup(), in shared mode: Accesses the set under its lock.
+  BDD_NOINLINE bool
+  lookupShared(unsigned pOp, unsigned pArg1, unsigned pArg2, unsigned pArg3, 
+               typename Entry::Result& pResult)
+  {
+    const unsigned lSet = getSet(pOp, pArg1, pArg2, pArg3);
+    bool lResult = false;
+    Counts& lCounts = mThreadCounts[mPool->getIndex()];
+    ++lCounts.lookupNr[pOp & (mOpNr - 1)];
+    lock(lSet);
+    if(mEntries[lSet].matches(pOp, pArg1, pArg2, pArg3))
+    {
+      pResult = mEntries[lSet].result;
+      lResult = true;
+    }
+    else if(mEntries[lSet + 1].matches(pOp, pArg1, pArg2, pArg3))
+    {
+      pResult = mEntries[lSet + 1].result;
+      if(mPolicy == LRU)
+      {
+        Entry lEntry = mEntries[lSet + 1];
+        mEntries[lSet + 1] = mEntries[lSet];
+        mEntries[lSet] = lEntry;
+      }
+      lResult = true;
+    }
+    unlock(lSet);
+    if(lResult)
+    {
+      ++lCounts.hitNr[pOp & (mOpNr - 1)];
+    }
+    return lResult;
+  }
+
+public: // Public methods.
+
+  /// Allocates 2^pSetBitNr sets. pEdgeMask as for mEdgeMask.
+  /// Returns false if memory is exhausted.
+  bool
+  init(unsigned pSetBitNr, unsigned pEdgeMask)
+  {
+    mSetBitNr = pSetBitNr;
+    mEdgeMask = pEdgeMask;
+    mPolicy = LRU;
+    mShared = false;
+    mPool = 0;
+    memset((void*) mLocks, 0, sizeof(mLocks));
+    memset(mLookupNr, 0, sizeof(mLookupNr));
+    memset(mHitNr, 0, sizeof(mHitNr));
+    mEntries = (Entry*) calloc((size_t) 2 << mSetBitNr, sizeof(Entry));
+    return mEntries != 0;
+  }
+
+  /// Frees the entries.
+  void
+  done()
+  {
+    free(mEntries);
+    mEntries = 0;
+  }
+
+  /// Sets the replacement policy.
+  void
+  setPolicy(bddCachePolicy pPolicy)
+  { mPolicy = pPolicy; }
+
+  /// Switches to resp. from shared mode (for the threads of pPool), 
+  ///   while no thread accesses the cache.
+  void
+  setShared(bool pShared, const bddTaskPool& pPool)
+  {
+    mShared = pShared;
+    if(pShared)
+    {
+      mPool = &pPool;
+      mThreadCounts.assign(pPool.getThreadNr(), Counts());
+      return;
+    }
+    for(unsigned lCnt = 0; lCnt < mThreadCounts.size(); ++lCnt)
+    {
+      for(unsigned lOp = 0; lOp < mOpNr; ++lOp)
+      {
+        mLookupNr[lOp] += mThreadCounts[lCnt].lookupNr[lOp];
+        mHitNr[lOp] += mThreadCounts[lCnt].hitNr[lOp];
+      }
+    }
+    mThreadCounts.clear();
+  }
+
+  /// Returns the number of lookups resp. hits for operation pOp.
+  unsigned long
+  getLookupNr(unsigned pOp) const
+  { return mLookupNr[pOp & (mOpNr - 1)]; }
+  unsigned long
+  getHitNr(unsigned pOp) const
+  { return mHitNr[pOp & (mOpNr - 1)]; }
+
+  /// Drops all entries.
+  void
+  clear()
+  { memset(mEntries, 0, ((size_t) 2 << mSetBitNr) * sizeof(Entry)); }
+
+  /// Multiplies the number of sets by 2^pBitDelta, and rehashes the entries.
+  /// The cache keeps its size if memory is exhausted.
+  void
+  grow(unsigned pBitDelta)
+  {
+    if(pBitDelta == 0  ||  mSetBitNr + pBitDelta >= 31)
+    {
+      return;
+    }
+    Entry* lOldEntries = mEntries;
+    const unsigned lOldEntryNr = 2u << mSetBitNr;
+    Entry* lNewEntries = (Entry*) 
+      calloc((size_t) 2 << (mSetBitNr + pBitDelta), sizeof(Entry));
+    if(!lNewEntries)
+    {
+      return;
+    }
+    mEntries = lNewEntries;
+    mSetBitNr += pBitDelta;
+    // Older entries first, such that the more recent entries 
+    //   remain the first ones of their new sets.
+    for(unsigned lWay = 2; lWay-- > 0; )
+    {
+      for(unsigned lCnt = lWay; lCnt < lOldEntryNr; lCnt += 2)
+      {
+        if(lOldEntries[lCnt].op != 0)
+        {
+          put(lOldEntries[lCnt]);
+        }
+      }
+    }
+    free(lOldEntries);
+  }
+
+  /// Drops all entries with an edge (see mEdgeMask) 
+  ///   for which pIsLive returns false.
+  void
+  sweep(bool (*pIsLive)(unsigned pEdge))
+  {
+    const unsigned lEntryNr = 2u << mSetBitNr;
+    for(unsigned lCnt = 0; lCnt < lEntryNr; ++lCnt)
+    {
+      Entry& lEntry = mEntries[lCnt];
+      if(lEntry.op != 0
+         && (   ((mEdgeMask & 1) && !pIsLive(lEntry.arg1))
+             || ((mEdgeMask & 2) && !pIsLive(lEntry.getArg2()))
+             || ((mEdgeMask & 4) && !pIsLive(lEntry.getArg3()))
+             || ((mEdgeMask & 8) && !pIsLive(lEntry.getResultEdge()))))
+      {
+        memset(&lEntry, 0, sizeof(Entry));
+      }
+    }
+    // A set whose first entry is dropped continues with its second one.
+    for(unsigned lCnt = 0; lCnt < lEntryNr; lCnt += 2)
+    {
+      if(mEntries[lCnt].op == 0  &&  mEntries[lCnt + 1].op != 0)
+      {
+        mEntries[lCnt] = mEntries[lCnt + 1];
+        memset(&mEntries[lCnt + 1], 0, sizeof(Entry));
+      }
+    }
+  }
+
+  /// Replaces each edge of the entries (see mEdgeMask) by pForward(edge),
+  ///   after the nodes were moved (see bddBdd::compact()), and rehashes
+  ///   the entries. Drops all entries if memory is exhausted.
+  void
+  relocate(unsigned (*pForward)(unsigned pEdge))
+  {
+    Entry* lOldEntries = mEntries;
+    const unsigned lEntryNr = 2u << mSetBitNr;
+    mEntries = (Entry*) calloc((size_t) lEntryNr, sizeof(Entry));
+    if(!mEntries)
+    {
+      mEntries = lOldEntries;
+      clear();
+      return;
+    }
+    // Older entries first, as in grow().
+    for(unsigned lWay = 2; lWay-- > 0; )
+    {
+      for(unsigned lCnt = lWay; lCnt < lEntryNr; lCnt += 2)
+      {
+        const Entry& lEntry = lOldEntries[lCnt];
+        if(lEntry.op != 0)
+        {
+          Entry lNewEntry;
+          lNewEntry.set(lEntry.op, 
+                        (mEdgeMask & 1) ? pForward(lEntry.arg1) 
+                                        : lEntry.arg1,
+                        (mEdgeMask & 2) ? pForward(lEntry.getArg2()) 
+                                        : lEntry.getArg2(),
+                        (mEdgeMask & 4) ? pForward(lEntry.getArg3()) 
+                                        : lEntry.getArg3(),
+                        lEntry.result);
+          if(mEdgeMask & 8)
+          {
+            lNewEntry.setResultEdge(pForward(lEntry.getResultEdge()));
+          }
+          put(lNewEntry);
+        }
+      }
+    }
+    free(lOldEntries);
+  }
+
+  /// Looks up the result of operation pOp (> 0) for the arguments.
+  /// Returns false if the cache does not contain the result.
+  bool
+  lookup(unsigned pOp, unsigned pArg1, unsigned pArg2, unsigned pArg3, 
+         typename Entry::Result& pResult)
+  {
+    if(mShared)
+    {
+      return lookupShared(pOp, pArg1, pArg2, pArg3, pResult);
+    }
+    Entry* lSet = mEntries + getSet(pOp, pArg1, pArg2, pArg3);
+    ++mLookupNr[pOp & (mOpNr - 1)];
+    if(lSet[0].matches(pOp, pArg1, pArg2, pArg3))
+    {
+      pResult = lSet[0].result;
+      ++mHitNr[pOp & (mOpNr - 1)];
+      return true;
+    }
+    if(lSet[1].matches(pOp, pArg1, pArg2, pArg3))
+    {
+      pResult = lSet[1].result;
+      ++mHitNr[pOp & (mOpNr - 1)];
+      if(mPolicy == LRU)
+      {
+        Entry lEntry = lSet[1];
+        lSet[1] = lSet[0];
+        lSet[0] = lEntry;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  /// Inserts the result of operation pOp (> 0) for the arguments.
+  void
+  insert(unsigned pOp, unsigned pArg1, unsigned pArg2, unsigned pArg3, 
+         typename Entry::Result pResult)
+  {
+    Entry lEntry;
+    lEntry.set(pOp, pArg1, pArg2, pArg3, pResult);
+    put(lEntry);
+  }
+};
+
+#endif
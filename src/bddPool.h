@@ -0,0 +1,394 @@
+/*
+ * CrocoPat is a tool for relational programming.
+ * This file is part of CrocoPat.
+ *
+ * Copyright (C) 2002-2008  Dirk Beyer
+ *
+ * CrocoPat is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * CrocoPat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with CrocoPat; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Please find the GNU Lesser General Public License in file
+ * License_LGPL.txt or at http://www.gnu.org/licenses/lgpl.txt
+ *
+ * Author:
+ * Dirk Beyer (firstname.lastname@sfu.ca)
+ * Simon Fraser University
+ *
+ * With contributions of: Andreas Noack, Michael Vogel
+ */
+
+#ifndef _bddPool_h
+#define _bddPool_h
+
+#include <pthread.h>
+#include <sched.h>
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+/// Keeps the compiler from inlining a function, if it supports this.
+///   For code of parallel operations that would bloat sequential code.
+#ifdef __GNUC__
+#define BDD_NOINLINE __attribute__((noinline))
+#else
+#define BDD_NOINLINE
+#endif
+
+/// Spin lock for the short critical sections of parallel BDD operations
+///   (an int, 0 if unlocked). Yields the processor while the lock is taken,
+///   because there may be more threads than processors.
+inline void
+bddLock(volatile int& pLock)
+{
+  while(__sync_lock_test_and_set(&pLock, 1))
+  {
+    while(__atomic_load_n(&pLock, __ATOMIC_RELAXED))
+    {
+      sched_yield();
+    }
+  }
+}
+
+/// Releases a lock taken by bddLock().
+inline void
+bddUnlock(volatile int& pLock)
+{
+  __sync_lock_release(&pLock);
+}
+
+/// Subcomputation of a parallel BDD operation,
+///   i.e., a recursive call that another thread may execute.
+/// Tasks live on the stack of the thread that forks them,
+///   which must join them (see bddTaskPool::join()) before it returns.
+struct bddTask
+{
+  enum { mQueued, mRunning, mDone };
+
+  /// Identifier of the operation, and its arguments.
+  unsigned op;
+  unsigned arg1;
+  unsigned arg2;
+  unsigned arg3;
+  /// Remaining depth of forking for the subcomputation.
+  unsigned fork;
+  /// Result of the operation.
+  unsigned result;
+  /// True if the operation threw an exception (e.g. out of nodes).
+  bool failed;
+  /// One of mQueued, mRunning, mDone. Accessed only by getState()
+  ///   and setState(), which hand over the other fields between threads.
+  int state;
+
+  /// Returns the state. The fields written before setState() are visible.
+  int
+  getState() const
+  { return __atomic_load_n(&state, __ATOMIC_ACQUIRE); }
+
+  /// Sets the state to pState, after all preceding writes.
+  void
+  setState(int pState)
+  { __atomic_store_n(&state, pState, __ATOMIC_RELEASE); }
+};
+
+/// Work-stealing pool of threads for parallel BDD operations.
+/// Each thread has a queue of forked tasks. A thread pushes and joins
+///   its tasks in LIFO order at the back of its queue, idle threads
+///   steal the oldest (i.e., largest) tasks from the front of other queues.
+/// The thread that calls start() takes part as thread 0,
+///   the workers are active only between setActive(true) and
+///   setActive(false), and sleep otherwise.
+class bddTaskPool
+{
+private: // Types.
+
+  /// Queue of forked tasks of one thread.
+  struct Queue
+  {
+    pthread_mutex_t mutex;
+    deque<bddTask*> tasks;
+    /// Number of tasks, written under the mutex. Thieves read it 
+    ///   without the mutex as a hint, to skip empty queues
+    ///   (see getSize()).
+    unsigned size;
+
+    /// Returns size, without the mutex.
+    unsigned
+    getSize() const
+    { return __atomic_load_n(&size, __ATOMIC_RELAXED); }
+
+    /// Sets size to the number of tasks, under the mutex.
+    void
+    updateSize()
+    { __atomic_store_n(&size, (unsigned) tasks.size(), __ATOMIC_RELAXED); }
+  };
+
+  /// Argument of a worker thread.
+  struct Worker
+  {
+    bddTaskPool* pool;
+    unsigned index;
+  };
+
+private: // Attributes.
+
+  /// Queues of all threads, element 0 belongs to the calling thread.
+  vector<Queue*> mQueues;
+  /// Worker threads (thread 1 ... mQueues.size()-1).
+  vector<pthread_t> mThreads;
+  vector<Worker*> mWorkers;
+  /// Thread-specific index of the thread (not set, i.e. 0, for thread 0).
+  pthread_key_t mIndexKey;
+  /// Executes a task, must not throw exceptions.
+  void (*mRun)(bddTask* pTask);
+  /// Workers sleep on mWakeUp while mActive is false.
+  ///   Both flags are written under mMutex, and read without it
+  ///   by isActive() resp. isStopped().
+  pthread_mutex_t mMutex;
+  pthread_cond_t mWakeUp;
+  bool mActive;
+  bool mStop;
+
+private: // Private methods.
+
+  /// Return mActive resp. mStop. The memory written by the thread 
+  ///   that set the flag is visible.
+  bool
+  isActive() const
+  { return __atomic_load_n(&mActive, __ATOMIC_ACQUIRE); }
+  bool
+  isStopped() const
+  { return __atomic_load_n(&mStop, __ATOMIC_ACQUIRE); }
+
+  /// Executes task pTask, which is no longer in a queue.
+  void
+  run(bddTask* pTask)
+  {
+    mRun(pTask);
+    pTask->setState(bddTask::mDone);
+  }
+
+  /// Steals the oldest task of another queue than pIndex, and executes it.
+  /// Returns false if all other queues are empty.
+  bool
+  steal(unsigned pIndex)
+  {
+    const unsigned lQueueNr = mQueues.size();
+    for(unsigned lCnt = 1; lCnt < lQueueNr; ++lCnt)
+    {
+      Queue& lQueue = *mQueues[(pIndex + lCnt) % lQueueNr];
+      if(lQueue.getSize() == 0)
+      {
+        continue;
+      }
+      bddTask* lTask = 0;
+      pthread_mutex_lock(&lQueue.mutex);
+      if(!lQueue.tasks.empty())
+      {
+        lTask = lQueue.tasks.front();
+        lQueue.tasks.pop_front();
+        lQueue.updateSize();
+        lTask->setState(bddTask::mRunning);
+      }
+      pthread_mutex_unlock(&lQueue.mutex);
+      if(lTask)
+      {
+        run(lTask);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Main loop of a worker thread.
+  static void*
+  work(void* pWorker)
+  {
+    Worker* lWorker = (Worker*) pWorker;
+    bddTaskPool* lPool = lWorker->pool;
+    pthread_setspecific(lPool->mIndexKey, (void*) (size_t) lWorker->index);
+    for(;;)
+    {
+      if(!lPool->isActive())
+      {
+        pthread_mutex_lock(&lPool->mMutex);
+        while(!lPool->isActive()  &&  !lPool->isStopped())
+        {
+          pthread_cond_wait(&lPool->mWakeUp, &lPool->mMutex);
+        }
+        pthread_mutex_unlock(&lPool->mMutex);
+      }
+      if(lPool->isStopped())
+      {
+        return 0;
+      }
+      if(!lPool->steal(lWorker->index))
+      {
+        sched_yield();
+      }
+    }
+  }
+
+public: // Public methods.
+
+  bddTaskPool()
+    : mRun(0), mActive(false), mStop(false)
+  {}
+
+  /// Returns the index of the calling thread.
+  unsigned
+  getIndex() const
+  { return (unsigned) (size_t) pthread_getspecific(mIndexKey); }
+
+  /// Returns the number of threads, including the calling thread.
+  unsigned
+  getThreadNr() const
+  { return mQueues.empty() ? 1 : mQueues.size(); }
+
+  /// Creates pThreadNr - 1 worker threads, which execute tasks with pRun.
+  /// Returns false if the threads cannot be created.
+  bool
+  start(unsigned pThreadNr, void (*pRun)(bddTask* pTask))
+  {
+    mRun = pRun;
+    __atomic_store_n(&mActive, false, __ATOMIC_RELEASE);
+    __atomic_store_n(&mStop, false, __ATOMIC_RELEASE);
+    pthread_mutex_init(&mMutex, 0);
+    pthread_cond_init(&mWakeUp, 0);
+    pthread_key_create(&mIndexKey, 0);
+    for(unsigned lCnt = 0; lCnt < pThreadNr; ++lCnt)
+    {
+      Queue* lQueue = new Queue();
+      pthread_mutex_init(&lQueue->mutex, 0);
+      lQueue->updateSize();
+      mQueues.push_back(lQueue);
+    }
+    for(unsigned lCnt = 1; lCnt < pThreadNr; ++lCnt)
+    {
+      Worker* lWorker = new Worker();
+      lWorker->pool = this;
+      lWorker->index = lCnt;
+      pthread_t lThread;
+      if(pthread_create(&lThread, 0, &work, lWorker) != 0)
+      {
+        delete lWorker;
+        stop();
+        return false;
+      }
+      mWorkers.push_back(lWorker);
+      mThreads.push_back(lThread);
+    }
+    return true;
+  }
+
+  /// Terminates the worker threads.
+  void
+  stop()
+  {
+    if(mQueues.empty())
+    {
+      return;
+    }
+    pthread_mutex_lock(&mMutex);
+    __atomic_store_n(&mStop, true, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&mWakeUp);
+    pthread_mutex_unlock(&mMutex);
+    for(unsigned lCnt = 0; lCnt < mThreads.size(); ++lCnt)
+    {
+      pthread_join(mThreads[lCnt], 0);
+      delete mWorkers[lCnt];
+    }
+    for(unsigned lCnt = 0; lCnt < mQueues.size(); ++lCnt)
+    {
+      pthread_mutex_destroy(&mQueues[lCnt]->mutex);
+      delete mQueues[lCnt];
+    }
+    mThreads.clear();
+    mWorkers.clear();
+    mQueues.clear();
+    pthread_key_delete(mIndexKey);
+    pthread_cond_destroy(&mWakeUp);
+    pthread_mutex_destroy(&mMutex);
+  }
+
+  /// Wakes up the workers resp. lets them sleep after the current task.
+  ///   The queues must be empty when the pool becomes inactive.
+  void
+  setActive(bool pActive)
+  {
+    pthread_mutex_lock(&mMutex);
+    __atomic_store_n(&mActive, pActive, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&mWakeUp);
+    pthread_mutex_unlock(&mMutex);
+  }
+
+  /// Appends pTask to the queue of the calling thread.
+  void
+  push(bddTask* pTask)
+  {
+    Queue& lQueue = *mQueues[getIndex()];
+    pTask->failed = false;
+    pTask->setState(bddTask::mQueued);
+    pthread_mutex_lock(&lQueue.mutex);
+    lQueue.tasks.push_back(pTask);
+    lQueue.updateSize();
+    pthread_mutex_unlock(&lQueue.mutex);
+  }
+
+  /// Waits until pTask, the last task pushed by the calling thread
+  ///   and not yet joined, is done.
+  /// If no other thread stole it, the calling thread executes it,
+  ///   or, if pRun is false, drops it (with failed == true).
+  /// Otherwise the calling thread executes stolen tasks while it waits.
+  void
+  join(bddTask* pTask, bool pRun)
+  {
+    const unsigned lIndex = getIndex();
+    Queue& lQueue = *mQueues[lIndex];
+    bool lOwn = false;
+    pthread_mutex_lock(&lQueue.mutex);
+    if(!lQueue.tasks.empty()  &&  lQueue.tasks.back() == pTask)
+    {
+      lQueue.tasks.pop_back();
+      lQueue.updateSize();
+      lOwn = true;
+    }
+    pthread_mutex_unlock(&lQueue.mutex);
+
+    if(lOwn)
+    {
+      if(pRun)
+      {
+        pTask->setState(bddTask::mRunning);
+        run(pTask);
+      }
+      else
+      {
+        pTask->failed = true;
+        pTask->setState(bddTask::mDone);
+      }
+      return;
+    }
+    // Stolen: Help the other threads until the thief is done.
+    while(pTask->getState() != bddTask::mDone)
+    {
+      if(!steal(lIndex))
+      {
+        sched_yield();
+      }
+    }
+  }
+};
+
+#endif
@@ -32,6 +32,7 @@
 #define _bddRelation_h_
 
 #include "bddBdd.h"
+#include "bddZdd.h"
 #include "bddSymTab.h"
 #include "relDataType.h"
 
@@ -51,6 +52,15 @@ extern string unsigned2string(unsigned pUnsigned);
 ///   (setEqual, setContains, isEmpty) correct.
 ///   However, the method for tuple count (getTupleNr) has to
 ///   restrict to the set of all range tuples (mkRange).
+///
+/// If the ZDD package is initialized (see bddZdd::isActive()),
+///   the set of tuples is represented by a ZDD instead of a BDD.
+///   The ZDD is over the bits of the attributes in mDomain,
+///   the other attributes are don't cares (as in a BDD without nodes 
+///   for these attributes). The operations extend the domains of their
+///   operands to the union of both. Thus the relations have the same
+///   tuples as with BDDs, including the out-of-range bit vectors.
+///   Enumeration and output convert the ZDD to a BDD (see getBdd()).
 class bddRelation : public relDataType
 {
 
@@ -62,6 +72,11 @@ private: // Private static methods.
               unsigned pVarId, 
               reprNUMBER pConst)
   {
+    if (bddZdd::isActive()) {
+      return bddRelation(pSymTab, 
+                         bddZdd::mkValue(pVarId, pSymTab->getBitNr(), pConst),
+                         pVarId);
+    }
     return bddRelation(pSymTab,  
                        bddBdd(pVarId, pSymTab->getBitNr(), pConst) );
   }
@@ -104,6 +119,13 @@ public: // Public static methods.
   mkRange(const bddSymTab* pSymTab,
           unsigned pVarId)
   {
+    if (bddZdd::isActive()) {
+      return bddRelation(pSymTab, 
+                         bddZdd::mkLessEqual(pVarId,
+                                             pSymTab->getBitNr(),
+                                             pSymTab->getUniverseSize() - 1),
+                         pVarId);
+    }
     return bddRelation(pSymTab, 
                        bddBdd::mkLessEqual(pVarId,
                                            pSymTab->getBitNr(),
@@ -133,7 +155,8 @@ public: // Public static methods.
   }
 
   /// Returns set of all tuples satisfying pVar1 < pVar2.
-  /// Assertion: pVar1's position  <=  pVar2's position in the variable order.
+  /// pVar1 may also follow pVar2 in the variable order,
+  ///   e.g. with a variable order file (option -o).
   static bddRelation
   mkLess(const bddSymTab* pSymTab,
          const string& pVar1, 
@@ -142,7 +165,6 @@ public: // Public static methods.
     bddRelation result(pSymTab, false);
     unsigned lVarId1 = pSymTab->getAttributePos(pVar1);
     unsigned lVarId2 = pSymTab->getAttributePos(pVar2);
-    assert(lVarId1 <= lVarId2);
 
     bddRelation lVar2Values(pSymTab, false);
     for(int lValueIt = pSymTab->getUniverseSize()-1;
@@ -171,6 +193,42 @@ public: // Public static methods.
                    pSymTab->getAttributePos(pAttributeName), 
                    pSymTab->getValueNum(pAttributeValue));
   }
+
+  /// Dynamic variable reordering of all relations:
+  ///   Group sifting of the attributes, i.e., the bits of each attribute
+  ///   are moved together, and their positions in (pSymTab) are updated.
+  /// Attribute positions that the caller computed before are invalid afterwards.
+  /// Not for ZDDs, whose domains refer to the attribute positions.
+  static void
+  reorder(bddSymTab* pSymTab)
+  {
+    if (bddZdd::isActive()) {
+      return;
+    }
+    const vector<string> lOrder = pSymTab->getAttributeOrder();
+    map<unsigned, string> lAttrOfBlock;
+    vector<unsigned> lBlocks;
+    for (vector<string>::const_iterator lIt = lOrder.begin();
+         lIt != lOrder.end();
+         ++lIt)
+    {
+      const unsigned lBlock = pSymTab->getAttributePos(*lIt) / pSymTab->getBitNr();
+      lAttrOfBlock[lBlock] = *lIt;
+      lBlocks.push_back(lBlock);
+    }
+
+    const vector<unsigned> lNewBlocks 
+      = bddBdd::reorderBlocks(pSymTab->getBitNr(), lBlocks);
+
+    vector<string> lNewOrder;
+    for (vector<unsigned>::const_iterator lIt = lNewBlocks.begin();
+         lIt != lNewBlocks.end();
+         ++lIt)
+    {
+      lNewOrder.push_back(lAttrOfBlock[*lIt]);
+    }
+    pSymTab->setAttributeOrder(lNewOrder);
+  }
   
 private: // Attributes.
 
@@ -178,6 +236,11 @@ private: // Attributes.
   const bddSymTab* mSymTab;
   /// Set of tuples.
   bddBdd mBdd;
+  /// Set of tuples if the ZDD package is active (see comment on top
+  ///   of this class), over the bits of the attributes at the
+  ///   positions (mDomain).
+  bddZdd mZdd;
+  set<unsigned> mDomain;
 
 public: // Attributes.
 
@@ -193,6 +256,7 @@ public: // Constructors and destructor.
   bddRelation(const bddSymTab* pSymTab, bool full)
     : mSymTab(pSymTab),
       mBdd(full),
+      mZdd(full ? 1 : 0),
       mArity(-1)
   {}
   // Use the standard copy constructor. 
@@ -206,6 +270,14 @@ private:
       mBdd(pBdd),
       mArity(-1)
   {}
+  /// ZDD (pZdd) over the attribute at position (pVarId).
+  bddRelation(const bddSymTab* pSymTab, const bddZdd& pZdd, unsigned pVarId)
+    : mSymTab(pSymTab),
+      mZdd(pZdd),
+      mArity(-1)
+  {
+    mDomain.insert(pVarId);
+  }
   /// Forbid implicite casts.
   bddRelation(void*);
   /// Forbid the use of some ugly standard operators.
@@ -213,42 +285,120 @@ private:
 
 private: // Service methods.
 
-  /// Renaming of attributes.
-  ///   Safe variant, without preconditions.
-  void
-  renameSafe(unsigned pVarIdOld, unsigned pVarIdNew, unsigned pBitNr) 
+  /// Returns the cube of the BDD variables of (pAttributes),
+  ///   i.e., all bits of the encodings of the attributes.
+  bddBdd
+  mkCube(const set<string>& pAttributes) const
   {
-    // Walk through all BDD variables.
-
-    // For all bits of the binary encoding of both attributes.
-    if( pVarIdOld > pVarIdNew )
+    set<unsigned> lVarIds;
+    for (set<string>::const_iterator lIt = pAttributes.begin();
+         lIt != pAttributes.end();
+         ++lIt)
     {
-      for (unsigned lIt = 0; 
-           lIt < pBitNr;
-           ++lIt)
+      unsigned lVarId = mSymTab->getAttributePos(*lIt);
+      for (unsigned i = 0;  i < mSymTab->getBitNr();  ++i)
       {
-        unsigned lPosOld = pVarIdOld + lIt;     
-        unsigned lPosNew = pVarIdNew + lIt;     
-        
-        mBdd.intersect(bddBdd(lPosOld, lPosNew));
-        mBdd.exists(lPosOld);
+        lVarIds.insert(lVarId + i);
       }
     }
-    else
+    return bddBdd::mkCube(lVarIds);
+  }
+
+  /// Returns the attribute positions of (pAttributes).
+  set<unsigned>
+  getPositions(const set<string>& pAttributes) const
+  {
+    set<unsigned> lPositions;
+    for (set<string>::const_iterator lIt = pAttributes.begin();
+         lIt != pAttributes.end();
+         ++lIt)
     {
-      for (int lIt = pBitNr-1; 
-           lIt >= 0;
-           --lIt)
+      lPositions.insert(mSymTab->getAttributePos(*lIt));
+    }
+    return lPositions;
+  }
+
+  /// Returns the variable ids of the attributes at the positions
+  ///   (pPositions), i.e., all bits of their encodings.
+  set<unsigned>
+  getVarIds(const set<unsigned>& pPositions) const
+  {
+    set<unsigned> lVarIds;
+    for (set<unsigned>::const_iterator lIt = pPositions.begin();
+         lIt != pPositions.end();
+         ++lIt)
+    {
+      for (unsigned i = 0;  i < mSymTab->getBitNr();  ++i)
       {
-        unsigned lPosOld = pVarIdOld + lIt;     
-        unsigned lPosNew = pVarIdNew + lIt;     
-        
-        mBdd.intersect(bddBdd(lPosOld, lPosNew));
-        mBdd.exists(lPosOld);
+        lVarIds.insert(*lIt + i);
+      }
+    }
+    return lVarIds;
+  }
+
+  /// ZDD mode: Adds the attributes at the positions (pPositions)
+  ///   to mDomain, as don't cares.
+  void
+  extendDomain(const set<unsigned>& pPositions)
+  {
+    set<unsigned> lNew;
+    for (set<unsigned>::const_iterator lIt = pPositions.begin();
+         lIt != pPositions.end();
+         ++lIt)
+    {
+      if (mDomain.find(*lIt) == mDomain.end()) {
+        lNew.insert(*lIt);
       }
     }
+    if (!lNew.empty()) {
+      mZdd.extend(bddZdd::mkCube(getVarIds(lNew)));
+      mDomain.insert(lNew.begin(), lNew.end());
+    }
+  }
+
+  /// ZDD mode: Extends the domains of (*this) and (p) to their union,
+  ///   and returns the ZDD of (p) over this domain.
+  bddZdd
+  alignZdd(const bddRelation& p)
+  {
+    extendDomain(p.mDomain);
+    if (p.mDomain.size() == mDomain.size()) {
+      return p.mZdd;
+    }
+    bddRelation lTmp(p);
+    lTmp.extendDomain(mDomain);
+    return lTmp.mZdd;
   }
 
+  /// ZDD mode: Existential quantification of the attributes 
+  ///   at the positions (pPositions).
+  void
+  existsZdd(const set<unsigned>& pPositions)
+  {
+    set<unsigned> lBound;
+    for (set<unsigned>::const_iterator lIt = pPositions.begin();
+         lIt != pPositions.end();
+         ++lIt)
+    {
+      if (mDomain.erase(*lIt) > 0) {
+        lBound.insert(*lIt);
+      }
+    }
+    if (!lBound.empty()) {
+      mZdd.exists(bddZdd::mkCube(getVarIds(lBound)));
+    }
+  }
+
+  /// Returns the BDD of the relation, converted from the ZDD in ZDD mode.
+  bddBdd
+  getBdd() const
+  {
+    if (!bddZdd::isActive()) {
+      return mBdd;
+    }
+    const set<unsigned> lVarIds = getVarIds(mDomain);
+    return mZdd.toBdd(vector<unsigned>(lVarIds.begin(), lVarIds.end()));
+  }
 
 public: // Service methods.
 
@@ -261,6 +411,30 @@ public: // Service methods.
       return isEmpty() ? 0 : 1;
     }
 
+    if (bddZdd::isActive()) {
+      // Exactly the attributes of (pFree), restricted to their ranges.
+      const set<unsigned> lFree = getPositions(pFree);
+      bddRelation lTmp = *this;
+      set<unsigned> lBound;
+      for (set<unsigned>::const_iterator lIt = mDomain.begin();
+           lIt != mDomain.end();
+           ++lIt)
+      {
+        if (lFree.find(*lIt) == lFree.end()) {
+          lBound.insert(*lIt);
+        }
+      }
+      lTmp.existsZdd(lBound);
+      lTmp.extendDomain(lFree);
+      for (set<unsigned>::const_iterator lIt = lFree.begin();
+           lIt != lFree.end();
+           ++lIt)
+      {
+        lTmp.intersect(mkRange(mSymTab, *lIt));
+      }
+      return lTmp.mZdd.getSetNr();
+    }
+
     map<unsigned,string> lVarOrd = mSymTab->computeVariableOrder(pFree);
     unsigned lFirstVar = lVarOrd.begin()->first;
     unsigned lLastVar  = (--lVarOrd.end())->first;
@@ -289,59 +463,268 @@ public: // Service methods.
     return lTmp.mBdd.getTupleNr(lFirstVar, lLastVar + mSymTab->getBitNr() - 1);
   }
 
+  /// Returns a cursor over the tuples of the relation, i.e., the value 
+  ///   numbers of the attributes at positions (pVarIds) (ascending),
+  ///   in lexicographic order. Each value occurs once, also the maximal
+  ///   value (see comment on top of this class).
+  ///   The relation must not contain other attributes.
+  bddTupleCursor
+  getTuples(const vector<unsigned>& pVarIds) const
+  {
+    return getTuples(pVarIds, 
+                     mSymTab->getBitNr(), 
+                     mSymTab->getUniverseSize() - 1);
+  }
+
+  /// Like above, but for another encoding than (mSymTab)'s
+  ///   (with (pBitNr) bits, and (pMaxValue) as maximal value), 
+  ///   e.g. for relations from a snapshot (see readBdds()).
+  bddTupleCursor
+  getTuples(const vector<unsigned>& pVarIds, 
+            unsigned pBitNr, 
+            unsigned pMaxValue) const
+  {
+    return bddTupleCursor(getBdd(), pVarIds, pBitNr, pMaxValue);
+  }
+
+  /// Returns a cursor over the values of the attribute at position 'pVarId',
+  ///   for relations with only this attribute (i.e. sets).
+  bddTupleCursor
+  getTuples(unsigned pVarId) const
+  {
+    return getTuples(vector<unsigned>(1, pVarId));
+  }
+
   /// Returns a value for attribute at position 'pVarId'.
   /// Assumes that the relation is not empty.
   string
   getElement(unsigned pVarId)
   {
-    unsigned lNumValue = mBdd.getTuple(pVarId, pVarId + mSymTab->getBitNr()-1);
+    unsigned lNumValue 
+      = getBdd().getTuple(pVarId, pVarId + mSymTab->getBitNr()-1);
     return mSymTab->getAttributeValue(lNumValue);
   }
 
+  /// Returns the number of nodes of the BDD (resp. ZDD).
+  unsigned
+  getNodeNr() const
+  {
+    if (bddZdd::isActive()) {
+      return mZdd.getNodeNr();
+    }
+    return mBdd.getNodeNr();
+  }
+
 
 public: // Operations.
 
   bool
   setEqual(const bddRelation& p) const {
+    if (bddZdd::isActive()) {
+      bddRelation lTmp(*this);
+      return lTmp.alignZdd(p).setEqual(lTmp.mZdd);
+    }
     return mBdd.setEqual( p.mBdd );
   }
 
   /// Check if (*this) contains (p).
   bool
   setContains(const bddRelation& p) const {
+    if (bddZdd::isActive()) {
+      bddRelation lTmp(*this);
+      bddZdd lZdd = lTmp.alignZdd(p);
+      lZdd.difference(lTmp.mZdd);
+      return lZdd.isEmpty();
+    }
     return mBdd.setContains( p.mBdd );
   }
   
   bool
   isEmpty() const {
+    if (bddZdd::isActive()) {
+      return mZdd.isEmpty();
+    }
     return mBdd.isEmpty();
   }
   
+  /// For ZDDs, the complement relative to all bit vectors of mDomain.
   void
   complement() {
+    if (bddZdd::isActive()) {
+      bddZdd lFull = bddZdd::mkFull(getVarIds(mDomain));
+      lFull.difference(mZdd);
+      mZdd = lFull;
+      return;
+    }
     mBdd.complement();
   }
 
   void
   unite(const bddRelation& p) {
+    if (bddZdd::isActive()) {
+      mZdd.unite(alignZdd(p));
+      return;
+    }
     mBdd.unite(p.mBdd);
   }
 
   void
   intersect(const bddRelation& p) {
+    if (bddZdd::isActive()) {
+      mZdd.intersect(alignZdd(p));
+      return;
+    }
     mBdd.intersect(p.mBdd);
   }
 
+  /// Keeps the tuples that are in exactly one of (*this) and (p).
+  void
+  exclusiveOr(const bddRelation& p) {
+    if (bddZdd::isActive()) {
+      bddZdd lOther = alignZdd(p);
+      bddZdd lOnlyThis = mZdd;
+      lOnlyThis.difference(lOther);
+      lOther.difference(mZdd);
+      lOnlyThis.unite(lOther);
+      mZdd = lOnlyThis;
+      return;
+    }
+    mBdd.exclusiveOr(p.mBdd);
+  }
+
+  /// Keeps the tuples that are in both or in none of (*this) and (p).
+  void
+  equivalence(const bddRelation& p) {
+    if (bddZdd::isActive()) {
+      exclusiveOr(p);
+      complement();
+      return;
+    }
+    mBdd.equivalence(p.mBdd);
+  }
+
+  /// Becomes (*this) -> (p), i.e. the complement of (*this) united with (p).
+  void
+  implication(const bddRelation& p) {
+    if (bddZdd::isActive()) {
+      complement();
+      unite(p);
+      return;
+    }
+    mBdd.implication(p.mBdd);
+  }
+
+  /// Removes the tuples of (p).
+  void
+  difference(const bddRelation& p) {
+    if (bddZdd::isActive()) {
+      mZdd.difference(alignZdd(p));
+      return;
+    }
+    mBdd.difference(p.mBdd);
+  }
+
+  /// Becomes (pThen) for the tuples of (*this), and (pElse) for the others.
+  void
+  ifThenElse(const bddRelation& pThen, const bddRelation& pElse) {
+    if (bddZdd::isActive()) {
+      bddRelation lElse(*this);
+      lElse.complement();
+      lElse.intersect(pElse);
+      intersect(pThen);
+      unite(lElse);
+      return;
+    }
+    mBdd.ifThenElse(pThen.mBdd, pElse.mBdd);
+  }
+
+  /// Selection of constant values: Becomes the relation of the tuples 
+  ///   with the attribute values of (pValues) (attribute -> value),
+  ///   without these attributes.
+  ///   Same as intersection with mkAttributeValue() and quantification,
+  ///   but in one BDD pass that only visits the selected part.
+  void
+  restrict(const map<string, string>& pValues) {
+    if (bddZdd::isActive()) {
+      set<string> lAttributes;
+      for (map<string, string>::const_iterator lIt = pValues.begin();
+           lIt != pValues.end();
+           ++lIt)
+      {
+        intersect(mkAttributeValue(mSymTab, lIt->first, lIt->second));
+        lAttributes.insert(lIt->first);
+      }
+      exists(lAttributes);
+      return;
+    }
+    bddBdd lCube(1);
+    set<string> lMaxAttributes;
+    for (map<string, string>::const_iterator lIt = pValues.begin();
+         lIt != pValues.end();
+         ++lIt)
+    {
+      reprNUMBER lValue = mSymTab->getValueNum(lIt->second);
+      if (lValue + 1 == mSymTab->getUniverseSize())
+      {
+        // The maximal value also stands for the out-of-range bit vectors
+        //   (see comment on top of this class), not a single cofactor.
+        intersect(mkAttributeValue(mSymTab, lIt->first, lIt->second));
+        lMaxAttributes.insert(lIt->first);
+      }
+      else
+      {
+        lCube.intersect(bddBdd(mSymTab->getAttributePos(lIt->first), 
+                               mSymTab->getBitNr(), 
+                               lValue));
+      }
+    }
+    mBdd.restrict(lCube);
+    if (!lMaxAttributes.empty())
+    {
+      exists(lMaxAttributes);
+    }
+  }
+
   /// Existential quantification of (pAttribute).
   void
   exists(const string pAttribute) {
-    unsigned lVarId = mSymTab->getAttributePos(pAttribute);
-    // Existential quantification of 'mSymTab->getBitNr()' bits,
-    //   beginning at 'lVarId', i.e., for all bits of the encoding of 'pAttribute'.
-    for (int i = mSymTab->getBitNr() - 1;  i >= 0;  --i)
-    {
-      mBdd.exists(lVarId + i);
+    set<string> lAttributes;
+    lAttributes.insert(pAttribute);
+    exists(lAttributes);
+  }
+
+  /// Existential quantification of (pAttributes) in one BDD pass.
+  void
+  exists(const set<string>& pAttributes) {
+    if (bddZdd::isActive()) {
+      existsZdd(getPositions(pAttributes));
+      return;
+    }
+    mBdd.exists(mkCube(pAttributes));
+  }
+
+  /// Universal quantification of (pAttributes) in one BDD pass.
+  void
+  forall(const set<string>& pAttributes) {
+    if (bddZdd::isActive()) {
+      complement();
+      exists(pAttributes);
+      complement();
+      return;
+    }
+    mBdd.forall(mkCube(pAttributes));
+  }
+
+  /// Relational product: Intersection with (p) and existential 
+  ///   quantification of (pAttributes) in one BDD pass.
+  void
+  intersectExists(const bddRelation& p, const set<string>& pAttributes) {
+    if (bddZdd::isActive()) {
+      intersect(p);
+      exists(pAttributes);
+      return;
     }
+    mBdd.andExists(p.mBdd, mkCube(pAttributes));
   }
 
   /// Check if there is any BDD node within the given range of attributes.
@@ -352,56 +735,192 @@ public: // Operations.
     unsigned lVarIdFirst = mSymTab->getAttributePos(pVarFirst);
     unsigned lVarIdLast  = mSymTab->getAttributePos(pVarLast) + mSymTab->getBitNr()-1;
     assert(lVarIdFirst <= lVarIdLast);
+    if (bddZdd::isActive()) {
+      // The relation depends on the attributes of the range
+      //   iff it changes if they become don't cares.
+      set<unsigned> lPositions;
+      for (set<unsigned>::const_iterator lIt = mDomain.begin();
+           lIt != mDomain.end();
+           ++lIt)
+      {
+        if (*lIt >= lVarIdFirst  &&  *lIt <= lVarIdLast) {
+          lPositions.insert(*lIt);
+        }
+      }
+      if (lPositions.empty()) {
+        return false;
+      }
+      const bddZdd lCube = bddZdd::mkCube(getVarIds(lPositions));
+      bddZdd lZdd = mZdd;
+      lZdd.exists(lCube);
+      lZdd.extend(lCube);
+      return !lZdd.setEqual(mZdd);
+    }
     return mBdd.testVars(lVarIdFirst, lVarIdLast);
   }
 
   /// Renaming of attributes.
   void
   rename(const string pAttributeOld, const string pAttributeNew) {
-    unsigned lVarIdOld = mSymTab->getAttributePos(pAttributeOld);
-    unsigned lVarIdNew = mSymTab->getAttributePos(pAttributeNew);
-
-    // Renaming of attributes. 
-
-    // For direct renaming:
-    // Forbidden range of variable ids for renaming [min, max].
-    // Case 1) pVarIdOld < pVarIdNew
-    unsigned lVarIdFirst = lVarIdOld + mSymTab->getBitNr();
-    unsigned lVarIdLast  = lVarIdNew + mSymTab->getBitNr()-1;
-    // Case 2) pVarIdOld > pVarIdNew
-    if( lVarIdOld > lVarIdNew )
+    map<string, string> lRenaming;
+    lRenaming[pAttributeOld] = pAttributeNew;
+    rename(lRenaming);
+  }
+
+  /// Simultaneous renaming of all attributes in pRenaming 
+  ///   (old name -> new name) in one pass over the BDD.
+  ///   The new attributes may overlap with the old ones (e.g. swaps),
+  ///   attributes renamed to the same name are identified.
+  void
+  rename(const map<string, string>& pRenaming) {
+    if (bddZdd::isActive()) {
+      renameZdd(pRenaming);
+      return;
+    }
+    const unsigned lBitNr = mSymTab->getBitNr();
+    vector<unsigned> lVarMap;
+    for (map<string, string>::const_iterator lIt = pRenaming.begin();
+         lIt != pRenaming.end();
+         ++lIt)
+    {
+      unsigned lVarIdOld = mSymTab->getAttributePos(lIt->first);
+      unsigned lVarIdNew = mSymTab->getAttributePos(lIt->second);
+      // Variable ids that are not renamed keep their ids.
+      while (lVarMap.size() < lVarIdOld + lBitNr)
+      {
+        lVarMap.push_back(lVarMap.size());
+      }
+      for (unsigned i = 0;  i < lBitNr;  ++i)
+      {
+        lVarMap[lVarIdOld + i] = lVarIdNew + i;
+      }
+    }
+    mBdd.replaceVars(lVarMap);
+  }
+
+  /// Like rename(), for ZDDs: The renaming of the ZDD must be injective,
+  ///   thus the attributes that become identified are selected
+  ///   for equal values first, and all but one are quantified.
+  void
+  renameZdd(const map<string, string>& pRenaming) {
+    const unsigned lBitNr = mSymTab->getBitNr();
+    // New position of each attribute of the domain.
+    map<unsigned, unsigned> lNewPos;
+    for (set<unsigned>::const_iterator lIt = mDomain.begin();
+         lIt != mDomain.end();
+         ++lIt)
+    {
+      lNewPos[*lIt] = *lIt;
+    }
+    for (map<string, string>::const_iterator lIt = pRenaming.begin();
+         lIt != pRenaming.end();
+         ++lIt)
     {
-      lVarIdFirst = lVarIdNew;
-      lVarIdLast  = lVarIdOld - 1;
+      unsigned lVarIdOld = mSymTab->getAttributePos(lIt->first);
+      if (lNewPos.find(lVarIdOld) != lNewPos.end()) {
+        lNewPos[lVarIdOld] = mSymTab->getAttributePos(lIt->second);
+      }
     }
 
-    // Check if there is any BDD node of a varId between the variables
-    //   or of a varId of the new variable.
-    if( mBdd.testVars(lVarIdFirst, lVarIdLast) )
+    // Identification: The first attribute with a new position remains.
+    map<unsigned, unsigned> lFirstOfNewPos;
+    set<unsigned> lIdentified;
+    for (map<unsigned, unsigned>::const_iterator lIt = lNewPos.begin();
+         lIt != lNewPos.end();
+         ++lIt)
     {
-      // Safe variant, without preconditions.
-      renameSafe(lVarIdOld, lVarIdNew, mSymTab->getBitNr());
+      map<unsigned, unsigned>::const_iterator lFirst 
+        = lFirstOfNewPos.find(lIt->second);
+      if (lFirst == lFirstOfNewPos.end()) {
+        lFirstOfNewPos[lIt->second] = lIt->first;
+      } else {
+        for (unsigned i = 0;  i < lBitNr;  ++i)
+        {
+          mZdd.selectEqual(lFirst->second + i, lIt->first + i);
+        }
+        lIdentified.insert(lIt->first);
+      }
     }
-    else
+    existsZdd(lIdentified);
+
+    // Injective renaming of the remaining attributes.
+    vector<unsigned> lVarMap;
+    set<unsigned> lDomain;
+    for (map<unsigned, unsigned>::const_iterator lIt = lFirstOfNewPos.begin();
+         lIt != lFirstOfNewPos.end();
+         ++lIt)
     {
-      // Direct variant, 
-      //   with the precondition that no BDD node exists between the variables.
-      // Parameters: First varId to rename.
-      //             Last varId to rename.
-      //             Offset, i.e. distance to new.
-      mBdd.renameVars(lVarIdOld,
-                      lVarIdOld + (mSymTab->getBitNr() - 1),
-                      lVarIdNew - lVarIdOld
-                      );
+      // Variable ids that are not renamed keep their ids.
+      while (lVarMap.size() < lIt->second + lBitNr)
+      {
+        lVarMap.push_back(lVarMap.size());
+      }
+      for (unsigned i = 0;  i < lBitNr;  ++i)
+      {
+        lVarMap[lIt->second + i] = lIt->first + i;
+      }
+      lDomain.insert(lIt->first);
     }
+    mZdd.rename(lVarMap);
+    mDomain = lDomain;
   }
 
 
 public: // IO.
 
+  /// Writes the BDDs of (pRelations), with shared nodes, 
+  ///   in binary form to (pOut) (see bddBdd::writeNodes()).
+  ///   Not in ZDD mode, like readBdds().
+  static void
+  writeBdds(ostream& pOut, const vector<bddRelation>& pRelations) {
+    vector<bddBdd> lBdds;
+    for (unsigned i = 0; i < pRelations.size(); ++i)
+    {
+      lBdds.push_back(pRelations[i].mBdd);
+    }
+    bddBdd::writeNodes(pOut, lBdds);
+  }
+
+  /// Reads the BDDs written by writeBdds() from the (pSize) bytes at 
+  ///   (pData), and appends them to (pRelations).
+  ///   Variable id v becomes (pVarMap[v]), if (v < pVarMap.size()).
+  ///   Returns false if the data are corrupt or memory is exhausted.
+  static bool
+  readBdds(const bddSymTab* pSymTab,
+           const char* pData, 
+           size_t pSize,
+           const vector<unsigned>& pVarMap,
+           vector<bddRelation>& pRelations) {
+    vector<bddBdd> lBdds;
+    if (!bddBdd::readNodes(pData, pSize, lBdds))
+    {
+      return false;
+    }
+    for (unsigned i = 0; i < lBdds.size(); ++i)
+    {
+      if (!pVarMap.empty())
+      {
+        lBdds[i].replaceVars(pVarMap);
+      }
+      pRelations.push_back(bddRelation(pSymTab, lBdds[i]));
+    }
+    return true;
+  }
+
   void
   printBddInfo(ostream& pS) const {
-    // Includes garbage collection to get real values.
+    if (bddZdd::isActive()) {
+      unsigned lFreeNodes = bddZdd::getUnusedNodeNr();
+      unsigned lMaxNodes  = bddZdd::getMaxNodeNr();
+      pS << "Number of ZDD nodes: " << mZdd.getNodeNr() << endl
+         << "Percentage of free nodes in ZDD package: " 
+         << lFreeNodes << " / " << lMaxNodes << " = " 
+         << (unsigned)(((double)lFreeNodes / (double)lMaxNodes) * 100) 
+         << " %" << endl;
+      return;
+    }
+    // Without garbage collection, which would drop the dead intermediate
+    //   results: Counts the nodes created since the last one as free.
     unsigned lFreeNodes = mBdd.getFreeNodeNr();
     unsigned lMaxNodes  = mBdd.getMaxNodeNr();
 
@@ -418,7 +937,7 @@ public: // IO.
   void
   printNodesPerVarId(ostream& pS, const set<string>& pFree) const {
     map<unsigned, string>   lVarOrd = mSymTab->computeVariableOrder(pFree);
-    map<unsigned, unsigned> lBddNodesPerVar = mBdd.getNodesPerVarId();
+    map<unsigned, unsigned> lBddNodesPerVar = getBdd().getNodesPerVarId();
     if (lVarOrd.empty() || lBddNodesPerVar.empty()) {  // BDD has only terminal nodes.
       pS << 0 << endl;
       return;
@@ -451,54 +970,37 @@ public: // IO.
     }
   }
 
-  /// Print set of tuples (plain) according to the given order of attributes.
-  /// Recursiv procedure.
+  /// Print set of tuples (plain) according to the given order of attributes,
+  ///   which must be the variable order of the attributes of the relation.
   void 
   printRelation(ostream& pS, 
                 const string pTuple,
-                vector<string> pAttributeList) const 
+                const vector<string>& pAttributeList) const 
   {
-    // Empty relation?
-    if( isEmpty() ) {
-      return;
-    }
-
-    // End of Recursion.
-    if( pAttributeList.empty() ) {
-      pS << pTuple << endl;
-      return;
+    vector<unsigned> lVarIds;
+    for (vector<string>::const_iterator lIt = pAttributeList.begin();
+         lIt != pAttributeList.end();
+         ++lIt)
+    {
+      lVarIds.push_back(mSymTab->getAttributePos(*lIt));
     }
 
-    // Proceed next attribute (i.e. column in relation) in given list.
-    // Use a copy of this relation.
-    bddRelation lRel(*this);
-    
-    // Output of the values of the first attribute in (pTermList),
-    //   i.e. the given ordering is regarded.
-    unsigned lVarId = mSymTab->getAttributePos( * pAttributeList.begin() );
-    pAttributeList.erase(pAttributeList.begin());
-
-    // For all values of the current attribute.
-    while (!lRel.isEmpty()) {
-      // Get next value of the attribute.
-      unsigned lNumValue = lRel.mBdd.getTuple(lVarId, 
-                                              lVarId + mSymTab->getBitNr()-1);
-
-      // Compute cofactor for current value in (lTmpRel).
-      bddRelation lTmpRel(lRel);
-      lTmpRel.intersect( mkEqual(mSymTab, lVarId, lNumValue) );
-      // Print value.
-      string lStringValue( mSymTab->getAttributeValue(lNumValue) );
-      if( mSymTab->isQuoted(lStringValue) )
+    // For all tuples, in lexicographic order.
+    for (bddTupleCursor lCursor = getTuples(lVarIds);
+         lCursor.isValid();
+         lCursor.next())
+    {
+      string lLine(pTuple);
+      for (unsigned i = 0; i < lVarIds.size(); ++i)
       {
-        lStringValue = '"' + lStringValue + '"';
+        string lStringValue( mSymTab->getAttributeValue(lCursor.getTuple()[i]) );
+        if( mSymTab->isQuoted(lStringValue) )
+        {
+          lStringValue = '"' + lStringValue + '"';
+        }
+        lLine += lStringValue + '\t';
       }
-      // Recursive call for the next attribute.
-      lTmpRel.printRelation(pS, pTuple + lStringValue + '\t', pAttributeList);
-      
-      // Delete printed tuples.
-      lTmpRel.complement();  
-      lRel.intersect( lTmpRel );
+      pS << lLine << endl;
     }
   }
 
@@ -519,7 +1021,7 @@ public: // IO.
 
     // Maps var ids to nodes.
     multimap<unsigned,bddGraphNode> lGraph;
-    mBdd.getGraph(lGraph);
+    getBdd().getGraph(lGraph);
 
     string lEdgeStyle = " [arrowsize=\"1.0\",fontname=\"Helvetica\",fontsize=\"8\",";
     string lNodeStyle = " [fontname=\"Helvetica\",fontsize=\"16\",height=\"0.3\",width=\"0.5\",color=black,style=unfilled,";
@@ -579,10 +1081,10 @@ public: // IO.
     pS << "}" << endl;
   }
 
-  /// Prints mBdd as reduced binary decision tree.
+  /// Prints the BDD as reduced binary decision tree.
   void
   printBDT(ostream& pS) const {
-    mBdd.print(pS);
+    getBdd().print(pS);
   }
 
   /// Cut given relation to single element for all given attributes.
@@ -600,8 +1102,8 @@ public: // IO.
       unsigned lVarId = mSymTab->getAttributePos( lIt->second );
       // Consider one single value of attribute (*lIt),
       //   i.e., the given ordering in (pAttributeList) is regarded (just for efficiency).
-      unsigned lNumValue = lRel.mBdd.getTuple(lVarId, 
-                                              lVarId + mSymTab->getBitNr()-1);
+      unsigned lNumValue = lRel.getBdd().getTuple(lVarId, 
+                                                  lVarId + mSymTab->getBitNr()-1);
       lRel.intersect( mkEqual(mSymTab, lVarId, lNumValue) );
     }
     return lRel;
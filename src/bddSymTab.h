@@ -171,6 +171,30 @@ public: // Accessors.
     return it->second * getBitNr();
   }
 
+  /// Returns the attribute at position 'pPos'.
+  string
+  getAttributeAtPos(unsigned pPos) const
+  {
+    map<unsigned, string>::const_iterator it = mPositions.find(pPos / getBitNr());
+    // Otherwise no attribute at this position.
+    assert(it != mPositions.end());
+    return it->second;
+  }
+
+  /// Returns all attributes in the variable order.
+  vector<string>
+  getAttributeOrder() const
+  {
+    vector<string> result;
+    for(map<unsigned, string>::const_iterator lIt = mPositions.begin();
+        lIt != mPositions.end();
+        ++lIt)
+    {
+      result.push_back(lIt->second);
+    }
+    return result;
+  }
+
   /// Return the number of value (pAttributeValue), 
   ///   i.e. its internal representation.
   unsigned
@@ -252,6 +276,41 @@ public: // Service methods.
     }
   }  
 
+  /// This method changes this symbol table!
+  /// Rearranges the attributes of 'pOrder' in the given order,
+  ///   i.e., they exchange their positions among each other.
+  ///   The positions of the other attributes do not change.
+  ///   Unknown attributes in 'pOrder' are ignored.
+  /// BDDs that use the attributes must be reordered accordingly
+  ///   (cf. bddRelation::reorder()).
+  void
+  setAttributeOrder(const vector<string>& pOrder)
+  {
+    vector<string> lAttributes;
+    set<unsigned>  lAttrNums;
+    for(vector<string>::const_iterator lIt = pOrder.begin();
+        lIt != pOrder.end();
+        ++lIt)
+    {
+      map<string, unsigned>::const_iterator lAttrIt = mAttributes.find(*lIt);
+      if( lAttrIt != mAttributes.end()  &&
+          lAttrNums.find(lAttrIt->second) == lAttrNums.end() ) 
+      {
+        lAttributes.push_back(*lIt);
+        lAttrNums.insert(lAttrIt->second);
+      }
+    }
+    // Assign the positions in ascending order.
+    vector<string>::const_iterator lAttrIt = lAttributes.begin();
+    for(set<unsigned>::const_iterator lIt = lAttrNums.begin();
+        lIt != lAttrNums.end();
+        ++lIt, ++lAttrIt)
+    {
+      mAttributes[*lAttrIt] = *lIt;
+      mPositions[*lIt] = *lAttrIt;
+    }
+  }
+
   const map<unsigned,string>
   computeVariableOrder(const set<string>& pAttributes) const
   { 
@@ -0,0 +1,1160 @@
+/*
+ * CrocoPat is a tool for relational programming.
+ * This file is part of CrocoPat.
+ *
+ * Copyright (C) 2002-2008  Dirk Beyer
+ *
+ * CrocoPat is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * CrocoPat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with CrocoPat; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Please find the GNU Lesser General Public License in file
+ * License_LGPL.txt or at http://www.gnu.org/licenses/lgpl.txt
+ *
+ * Author:
+ * Dirk Beyer (firstname.lastname@sfu.ca)
+ * Simon Fraser University
+ *
+ * With contributions of: Andreas Noack, Michael Vogel
+ */
+
+#include "bddZdd.h"
+
+#include <vector>
+#include <iostream>
+#include <set>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <map>
+
+// Static attributes.
+bddZddNode* bddZdd::mNodes = 0;
+unsigned bddZdd::mMaxNodeNr = 0;
+unsigned bddZdd::mNodeNrLimit = 0;
+unsigned bddZdd::mFree = 0;
+unsigned bddZdd::mFreeNr = 0;
+unsigned* bddZdd::mExtRefCnts = 0;
+unsigned* bddZdd::mUniqueHash = 0;
+unsigned bddZdd::mUniqueHBitNr = 0;
+bddCache<bddBinEntry> bddZdd::mApplyCache;
+bddCache<bddBinEntry> bddZdd::mVarCache;
+bddCache<bddStatEntry> bddZdd::mStatCache;
+map<vector<unsigned>, unsigned> bddZdd::mRenameKeys;
+unsigned short* bddZdd::mStamps = 0;
+unsigned short bddZdd::mEpoch = 0;
+
+unsigned long bddZdd::mCallNr[mOpNr];
+unsigned long bddZdd::mGcNr = 0;
+double bddZdd::mGcTime = 0;
+unsigned bddZdd::mPeakLiveNr = 0;
+unsigned bddZdd::mPeakUsedNr = 0;
+unsigned bddZdd::mPeakMarkNr = 0;
+unsigned long bddZdd::mCreatedNr = 0;
+unsigned long bddZdd::mGrowNr = 0;
+unsigned bddZdd::mGcLiveNr = 0;
+bddObserver bddZdd::mObserver = 0;
+
+/////////////////////////////////////////////////////////////////
+/// Hash function, same as bddBdd::hash(). The high bits select the chain.
+inline unsigned
+bddZdd::hash(unsigned pVar, unsigned pLow, unsigned pHigh)
+{
+  return ((pVar * 14099753 + pLow) * 9243337 + pHigh) * 3901787;
+}
+
+/// Returns a new stamp for a traversal. When the epochs wrap around,
+///   all stamps are reset, such that no node carries the new stamp.
+unsigned short
+bddZdd::newEpoch()
+{
+  ++mEpoch;
+  if(mEpoch == 0)
+  {
+    memset(mStamps, 0, (size_t) mMaxNodeNr * sizeof(unsigned short));
+    mEpoch = 1;
+  }
+  return mEpoch;
+}
+
+/// Marks (mark=1) all nodes of the ZDD with the root pRoot.
+///   Iterative with an explicit stack, as bddBdd::mark().
+void
+bddZdd::mark(unsigned pRoot, vector<unsigned>& pStack)
+{
+  if(mNodes[pRoot].mark)
+  {
+    return;
+  }
+  mNodes[pRoot].mark = 1;
+  pStack.push_back(pRoot);
+  while(!pStack.empty())
+  {
+    const unsigned lNode = pStack.back();
+    pStack.pop_back();
+    const unsigned lSons[2] = { getLow(lNode), getHigh(lNode) };
+    for(unsigned lCnt = 0; lCnt < 2; ++lCnt)
+    {
+      if(!mNodes[lSons[lCnt]].mark)
+      {
+        mNodes[lSons[lCnt]].mark = 1;
+        pStack.push_back(lSons[lCnt]);
+      }
+    }
+  }
+}
+
+/// Inserts node pNode at the beginning of its chain.
+void
+bddZdd::hashInsert(unsigned pNode)
+{
+  const unsigned lChain = hash(mNodes[pNode].var,
+                               mNodes[pNode].low,
+                               mNodes[pNode].high) >> (32 - mUniqueHBitNr);
+  mNodes[pNode].next = mUniqueHash[lChain];
+  mUniqueHash[lChain] = pNode;
+}
+
+/// Garbage collection: All dead nodes (i.e. all nodes which are not reachable
+/// from an externally referenced node) are freed
+/// (i.e. inserted into unused-list mFree).
+/// Terminal nodes are never freed.
+void
+bddZdd::gc()
+{
+  const bddObserved lObserved(mObserver, "gc");
+  const clock_t lStart = clock();
+  const unsigned lUsedNr = mMaxNodeNr - 2 - mFreeNr;
+  // Mark all live nodes.
+  vector<unsigned> lStack;
+  for(unsigned lCnt = 2; lCnt < mMaxNodeNr; ++lCnt)
+  {
+    if(mExtRefCnts[lCnt] != 0)
+    {
+      mark(lCnt, lStack);
+    }
+  }
+
+  // Drop the cache entries with dead nodes, the others remain valid.
+  mApplyCache.sweep(&isMarked);
+  mVarCache.sweep(&isMarked);
+  mStatCache.sweep(&isMarked);
+
+  // Free the dead nodes, and insert the live ones into the cleared
+  //   mUniqueHash. From the end, such that the free nodes at the
+  //   beginning of mNodes are used first.
+  memset(mUniqueHash, 0, (1u << mUniqueHBitNr) * sizeof(unsigned));
+  mFree = 0;
+  mFreeNr = 0;
+  for(unsigned lCnt = mMaxNodeNr - 1; lCnt >= 2; --lCnt)
+  {
+    if(!mNodes[lCnt].mark)
+    {
+      mNodes[lCnt].low = mFree;
+      mFree = lCnt;
+      ++mFreeNr;
+    }
+    else
+    {
+      mNodes[lCnt].mark = 0;
+      hashInsert(lCnt);
+    }
+  }
+
+  mGcLiveNr = mMaxNodeNr - 2 - mFreeNr;
+  ++mGcNr;
+  mGcTime += (double) (clock() - lStart) / CLOCKS_PER_SEC;
+  mPeakUsedNr = max(mPeakUsedNr, lUsedNr);
+  mPeakMarkNr = max(mPeakMarkNr, lUsedNr);
+  mPeakLiveNr = max(mPeakLiveNr, mGcLiveNr);
+}
+
+/// Garbage collection before an operation, if less than 1/8 of the nodes
+///   is free. Grows the node array if less than 1/4 of the nodes
+///   is free afterwards, such that the collections do not become frequent.
+void
+bddZdd::gcIfDue()
+{
+  if(mFreeNr >= mMaxNodeNr / 8)
+  {
+    return;
+  }
+  gc();
+  if(mFreeNr < mMaxNodeNr / 4)
+  {
+    grow();
+  }
+}
+
+/// Grows the node array by factor 2 (but not beyond mNodeNrLimit),
+///   and the hash table and the caches by the same factor.
+///   Unlike bddBdd::grow(), the new nodes are inserted into the list
+///   of unused nodes immediately, and the chains of mUniqueHash are
+///   moved into the new table, i.e., no garbage collection is needed.
+/// Returns false if the node array cannot grow.
+bool
+bddZdd::grow()
+{
+  const bddObserved lObserved(mObserver, "grow");
+  unsigned lNewMaxNodeNr = mMaxNodeNr;
+  if(mMaxNodeNr <= UINT_MAX / 2)
+  {
+    lNewMaxNodeNr = 2 * mMaxNodeNr;
+  }
+  else
+  {
+    lNewMaxNodeNr = UINT_MAX;
+  }
+  if(mNodeNrLimit != 0  &&  lNewMaxNodeNr > mNodeNrLimit + 2)
+  {
+    lNewMaxNodeNr = mNodeNrLimit + 2;
+  }
+  if(lNewMaxNodeNr <= mMaxNodeNr)
+  {
+    return false;
+  }
+
+  // Reference counters first, such that they always cover mNodes.
+  unsigned* lExtRefCnts = (unsigned*) realloc(mExtRefCnts,
+    (size_t) lNewMaxNodeNr * sizeof(unsigned));
+  if(!lExtRefCnts)
+  {
+    return false;
+  }
+  mExtRefCnts = lExtRefCnts;
+  memset(mExtRefCnts + mMaxNodeNr, 0,
+         (size_t) (lNewMaxNodeNr - mMaxNodeNr) * sizeof(unsigned));
+
+  unsigned short* lStamps = (unsigned short*) realloc(mStamps,
+    (size_t) lNewMaxNodeNr * sizeof(unsigned short));
+  if(!lStamps)
+  {
+    return false;
+  }
+  mStamps = lStamps;
+  memset(mStamps + mMaxNodeNr, 0,
+         (size_t) (lNewMaxNodeNr - mMaxNodeNr) * sizeof(unsigned short));
+
+  bddZddNode* lNodes = (bddZddNode*)
+    realloc(mNodes, (size_t) lNewMaxNodeNr * sizeof(bddZddNode));
+  if(!lNodes)
+  {
+    return false;
+  }
+  mNodes = lNodes;
+  memset(mNodes + mMaxNodeNr, 0,
+         (size_t) (lNewMaxNodeNr - mMaxNodeNr) * sizeof(bddZddNode));
+
+  // At most two nodes per chain on average.
+  unsigned lUniqueHBitNr = mUniqueHBitNr;
+  while((2u << lUniqueHBitNr) < lNewMaxNodeNr  &&  lUniqueHBitNr < 31)
+  {
+    ++lUniqueHBitNr;
+  }
+  if(lUniqueHBitNr > mUniqueHBitNr)
+  {
+    unsigned* lUniqueHash
+      = (unsigned*) calloc((size_t) 1 << lUniqueHBitNr, sizeof(unsigned));
+    if(lUniqueHash)
+    {
+      unsigned* lOldUniqueHash = mUniqueHash;
+      const unsigned lOldChainNr = 1u << mUniqueHBitNr;
+      mUniqueHash = lUniqueHash;
+      mUniqueHBitNr = lUniqueHBitNr;
+      for(unsigned lChain = 0; lChain < lOldChainNr; ++lChain)
+      {
+        unsigned lNode = lOldUniqueHash[lChain];
+        while(lNode != 0)
+        {
+          const unsigned lNext = mNodes[lNode].next;
+          hashInsert(lNode);
+          lNode = lNext;
+        }
+      }
+      free(lOldUniqueHash);
+    }
+  }
+
+  // New nodes into the list of unused nodes, the lowest first.
+  for(unsigned lCnt = lNewMaxNodeNr - 1; lCnt >= mMaxNodeNr; --lCnt)
+  {
+    mNodes[lCnt].low = mFree;
+    mFree = lCnt;
+    ++mFreeNr;
+  }
+  mApplyCache.grow(1);
+  mVarCache.grow(1);
+  mStatCache.grow(1);
+  mMaxNodeNr = lNewMaxNodeNr;
+  ++mGrowNr;
+  return true;
+}
+
+/// Provides free nodes after insert() failed in the pTry-th try
+///   of an operation, i.e., the node array cannot grow any more:
+///   Collects the garbage, including the intermediate results
+///   of the failed try. Aborts the program if the operation
+///   failed before, or no node is free.
+void
+bddZdd::reclaim(unsigned pTry)
+{
+  gc();
+  if(pTry > 0  ||  mFreeNr == 0)
+  {
+    cerr << "Error: ZDD package out of memory." << endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+/// Returns the index of the node with the passed var-, low- and
+/// high-indices. If such node does not exists, it is inserted into
+/// mNodes and mUniqueHash. If there are no free nodes left and the
+/// tables cannot grow, throws exception.
+unsigned
+bddZdd::insert(unsigned pVar, unsigned pLow, unsigned pHigh)
+{
+  // Zero-suppression of nodes whose high son is the empty family.
+  if(pHigh == 0)
+  {
+    return pLow;
+  }
+
+  unsigned lChain = hash(pVar, pLow, pHigh) >> (32 - mUniqueHBitNr);
+  for(unsigned lNode = mUniqueHash[lChain];
+      lNode != 0;
+      lNode = mNodes[lNode].next)
+  {
+    if(   mNodes[lNode].var == pVar
+       && mNodes[lNode].low == pLow
+       && mNodes[lNode].high == pHigh)
+    {
+      return lNode;
+    }
+  }
+
+  // Create new node.
+  if(mFree == 0)
+  {
+    if(!grow())
+    {
+      throw "Error: ZDD package out of memory\n";
+    }
+    lChain = hash(pVar, pLow, pHigh) >> (32 - mUniqueHBitNr);
+  }
+
+  const unsigned lResult = mFree;
+  mFree = mNodes[lResult].low;
+  --mFreeNr;
+  ++mCreatedNr;
+  mNodes[lResult].mark = 0;
+  mNodes[lResult].var = pVar;
+  mNodes[lResult].low = pLow;
+  mNodes[lResult].high = pHigh;
+  mNodes[lResult].next = mUniqueHash[lChain];
+  mUniqueHash[lChain] = lResult;
+  return lResult;
+}
+
+/// Runs operation pOp, and again if it failed.
+unsigned
+bddZdd::run(unsigned pOp, unsigned pArg1, unsigned pArg2)
+{
+  ++mCallNr[pOp];
+  gcIfDue();
+  return retryOnOutOfNodes(bddBind(&apply_, pOp, pArg1, pArg2), &reclaim);
+}
+
+/// Dispatches the operations with two node arguments.
+unsigned
+bddZdd::apply_(unsigned pOp, unsigned pArg1, unsigned pArg2)
+{
+  switch(pOp)
+  {
+  case mUnite:
+    return unite_(pArg1, pArg2);
+  case mIntersect:
+    return intersect_(pArg1, pArg2);
+  case mDifference:
+    return difference_(pArg1, pArg2);
+  case mExists:
+    return exists_(pArg1, pArg2);
+  case mExtend:
+    return extend_(pArg1, pArg2);
+  default:
+    assert(false);
+    return 0;
+  }
+}
+
+/// Union of the families.
+unsigned
+bddZdd::unite_(unsigned pRoot1, unsigned pRoot2)
+{
+  if(pRoot1 == 0  ||  pRoot1 == pRoot2)
+  {
+    return pRoot2;
+  }
+  if(pRoot2 == 0)
+  {
+    return pRoot1;
+  }
+
+  // Commutative: One cache entry for both orders.
+  if(pRoot1 > pRoot2)
+  {
+    const unsigned lTmp = pRoot1;
+    pRoot1 = pRoot2;
+    pRoot2 = lTmp;
+  }
+  unsigned lResult;
+  if(mApplyCache.lookup(mUnite, pRoot1, pRoot2, 0, lResult))
+  {
+    return lResult;
+  }
+
+  const unsigned lVar1 = getVar(pRoot1);
+  const unsigned lVar2 = getVar(pRoot2);
+  if(lVar1 < lVar2)
+  {
+    lResult = insert(lVar1, unite_(getLow(pRoot1), pRoot2), getHigh(pRoot1));
+  }
+  else if(lVar1 > lVar2)
+  {
+    lResult = insert(lVar2, unite_(pRoot1, getLow(pRoot2)), getHigh(pRoot2));
+  }
+  else
+  {
+    lResult = insert(lVar1,
+                     unite_(getLow(pRoot1), getLow(pRoot2)),
+                     unite_(getHigh(pRoot1), getHigh(pRoot2)));
+  }
+
+  mApplyCache.insert(mUnite, pRoot1, pRoot2, 0, lResult);
+  return lResult;
+}
+
+/// Intersection of the families.
+unsigned
+bddZdd::intersect_(unsigned pRoot1, unsigned pRoot2)
+{
+  if(pRoot1 == 0  ||  pRoot2 == 0)
+  {
+    return 0;
+  }
+  if(pRoot1 == pRoot2)
+  {
+    return pRoot1;
+  }
+
+  // Commutative: One cache entry for both orders.
+  if(pRoot1 > pRoot2)
+  {
+    const unsigned lTmp = pRoot1;
+    pRoot1 = pRoot2;
+    pRoot2 = lTmp;
+  }
+  unsigned lResult;
+  if(mApplyCache.lookup(mIntersect, pRoot1, pRoot2, 0, lResult))
+  {
+    return lResult;
+  }
+
+  // A set with a variable that the other top node skips
+  //   is not in the other family.
+  const unsigned lVar1 = getVar(pRoot1);
+  const unsigned lVar2 = getVar(pRoot2);
+  if(lVar1 < lVar2)
+  {
+    lResult = intersect_(getLow(pRoot1), pRoot2);
+  }
+  else if(lVar1 > lVar2)
+  {
+    lResult = intersect_(pRoot1, getLow(pRoot2));
+  }
+  else
+  {
+    lResult = insert(lVar1,
+                     intersect_(getLow(pRoot1), getLow(pRoot2)),
+                     intersect_(getHigh(pRoot1), getHigh(pRoot2)));
+  }
+
+  mApplyCache.insert(mIntersect, pRoot1, pRoot2, 0, lResult);
+  return lResult;
+}
+
+/// Difference of the families.
+unsigned
+bddZdd::difference_(unsigned pRoot1, unsigned pRoot2)
+{
+  if(pRoot1 == 0  ||  pRoot1 == pRoot2)
+  {
+    return 0;
+  }
+  if(pRoot2 == 0)
+  {
+    return pRoot1;
+  }
+
+  unsigned lResult;
+  if(mApplyCache.lookup(mDifference, pRoot1, pRoot2, 0, lResult))
+  {
+    return lResult;
+  }
+
+  const unsigned lVar1 = getVar(pRoot1);
+  const unsigned lVar2 = getVar(pRoot2);
+  if(lVar1 < lVar2)
+  {
+    lResult = insert(lVar1,
+                     difference_(getLow(pRoot1), pRoot2),
+                     getHigh(pRoot1));
+  }
+  else if(lVar1 > lVar2)
+  {
+    lResult = difference_(pRoot1, getLow(pRoot2));
+  }
+  else
+  {
+    lResult = insert(lVar1,
+                     difference_(getLow(pRoot1), getLow(pRoot2)),
+                     difference_(getHigh(pRoot1), getHigh(pRoot2)));
+  }
+
+  mApplyCache.insert(mDifference, pRoot1, pRoot2, 0, lResult);
+  return lResult;
+}
+
+/// Removes the variables of pCube from all sets: The sets with and
+///   without such a variable are united.
+unsigned
+bddZdd::exists_(unsigned pRoot, unsigned pCube)
+{
+  if(pRoot <= 1  ||  pCube == 1)
+  {
+    return pRoot;
+  }
+  const unsigned lVar = getVar(pRoot);
+  const unsigned lCubeVar = getVar(pCube);
+  if(lCubeVar < lVar)
+  {
+    // No set contains the variable.
+    return exists_(pRoot, getHigh(pCube));
+  }
+
+  unsigned lResult;
+  if(mApplyCache.lookup(mExists, pRoot, pCube, 0, lResult))
+  {
+    return lResult;
+  }
+
+  if(lCubeVar == lVar)
+  {
+    lResult = unite_(exists_(getLow(pRoot), getHigh(pCube)),
+                     exists_(getHigh(pRoot), getHigh(pCube)));
+  }
+  else
+  {
+    lResult = insert(lVar,
+                     exists_(getLow(pRoot), pCube),
+                     exists_(getHigh(pRoot), pCube));
+  }
+
+  mApplyCache.insert(mExists, pRoot, pCube, 0, lResult);
+  return lResult;
+}
+
+/// Product with the power set of pCube: Each variable of pCube
+///   becomes a node with equal sons.
+unsigned
+bddZdd::extend_(unsigned pRoot, unsigned pCube)
+{
+  if(pRoot == 0  ||  pCube == 1)
+  {
+    return pRoot;
+  }
+
+  unsigned lResult;
+  if(mApplyCache.lookup(mExtend, pRoot, pCube, 0, lResult))
+  {
+    return lResult;
+  }
+
+  const unsigned lVar = getVar(pRoot);
+  const unsigned lCubeVar = getVar(pCube);
+  if(lVar < lCubeVar)
+  {
+    lResult = insert(lVar,
+                     extend_(getLow(pRoot), pCube),
+                     extend_(getHigh(pRoot), pCube));
+  }
+  else
+  {
+    // If some sets contain the variable already (lVar == lCubeVar),
+    //   it is a don't care for all of them, too.
+    const unsigned lSon = (lVar == lCubeVar)
+      ? extend_(unite_(getLow(pRoot), getHigh(pRoot)), getHigh(pCube))
+      : extend_(pRoot, getHigh(pCube));
+    lResult = insert(lCubeVar, lSon, lSon);
+  }
+
+  mApplyCache.insert(mExtend, pRoot, pCube, 0, lResult);
+  return lResult;
+}
+
+/// Adds variable pVar to all sets.
+unsigned
+bddZdd::addVar_(unsigned pRoot, unsigned pVar)
+{
+  if(pRoot == 0)
+  {
+    return 0;
+  }
+  const unsigned lVar = getVar(pRoot);
+  if(lVar > pVar)
+  {
+    return insert(pVar, 0, pRoot);
+  }
+
+  unsigned lResult;
+  if(mVarCache.lookup(mAddVar, pRoot, pVar, 0, lResult))
+  {
+    return lResult;
+  }
+
+  if(lVar == pVar)
+  {
+    // Sets that contain the variable already remain unchanged.
+    lResult = insert(pVar, 0, unite_(getLow(pRoot), getHigh(pRoot)));
+  }
+  else
+  {
+    lResult = insert(lVar,
+                     addVar_(getLow(pRoot), pVar),
+                     addVar_(getHigh(pRoot), pVar));
+  }
+
+  mVarCache.insert(mAddVar, pRoot, pVar, 0, lResult);
+  return lResult;
+}
+
+/// Keeps the sets with variable pVar.
+unsigned
+bddZdd::onset_(unsigned pRoot, unsigned pVar)
+{
+  const unsigned lVar = getVar(pRoot);
+  if(lVar > pVar)
+  {
+    // Also for the terminals: No set contains pVar.
+    return 0;
+  }
+  if(lVar == pVar)
+  {
+    return insert(pVar, 0, getHigh(pRoot));
+  }
+
+  unsigned lResult;
+  if(mVarCache.lookup(mOnset, pRoot, pVar, 0, lResult))
+  {
+    return lResult;
+  }
+  lResult = insert(lVar,
+                   onset_(getLow(pRoot), pVar),
+                   onset_(getHigh(pRoot), pVar));
+  mVarCache.insert(mOnset, pRoot, pVar, 0, lResult);
+  return lResult;
+}
+
+/// Keeps the sets without variable pVar.
+unsigned
+bddZdd::offset_(unsigned pRoot, unsigned pVar)
+{
+  const unsigned lVar = getVar(pRoot);
+  if(lVar > pVar)
+  {
+    return pRoot;
+  }
+  if(lVar == pVar)
+  {
+    return getLow(pRoot);
+  }
+
+  unsigned lResult;
+  if(mVarCache.lookup(mOffset, pRoot, pVar, 0, lResult))
+  {
+    return lResult;
+  }
+  lResult = insert(lVar,
+                   offset_(getLow(pRoot), pVar),
+                   offset_(getHigh(pRoot), pVar));
+  mVarCache.insert(mOffset, pRoot, pVar, 0, lResult);
+  return lResult;
+}
+
+/// Replaces each variable id v < pVarMap.size() by pVarMap[v].
+///   pKey identifies the renaming pVarMap in the cache.
+unsigned
+bddZdd::rename_(unsigned                pRoot,
+                const vector<unsigned>& pVarMap,
+                unsigned                pKey)
+{
+  if(getVar(pRoot) >= pVarMap.size())
+  {
+    // Terminal, or only variable ids after the renamed ones.
+    return pRoot;
+  }
+
+  unsigned lResult;
+  if(mVarCache.lookup(mRename, pRoot, pKey, 0, lResult))
+  {
+    return lResult;
+  }
+
+  const unsigned lLow  = rename_(getLow(pRoot),  pVarMap, pKey);
+  const unsigned lHigh = rename_(getHigh(pRoot), pVarMap, pKey);
+  const unsigned lVar  = pVarMap[getVar(pRoot)];
+  if(lVar < getVar(lLow)  &&  lVar < getVar(lHigh))
+  {
+    // Order preserved: Relabel node pRoot.
+    lResult = insert(lVar, lLow, lHigh);
+  }
+  else
+  {
+    // New variable is not on top of the renamed sons.
+    //   Injective, thus no set of lHigh contains it.
+    lResult = unite_(lLow, addVar_(lHigh, lVar));
+  }
+
+  mVarCache.insert(mRename, pRoot, pKey, 0, lResult);
+  return lResult;
+}
+
+/// Returns the number of sets, cached per node.
+double
+bddZdd::getSetNr_(unsigned pRoot)
+{
+  if(pRoot <= 1)
+  {
+    return pRoot;
+  }
+  bddStatEntry::Result lResult;
+  if(mStatCache.lookup(mCount, pRoot, 0, 0, lResult))
+  {
+    return lResult.value;
+  }
+  // Counts do not underflow, thus the exponent is not used.
+  lResult.value = getSetNr_(getLow(pRoot)) + getSetNr_(getHigh(pRoot));
+  lResult.exponent = 0;
+  mStatCache.insert(mCount, pRoot, 0, 0, lResult);
+  return lResult.value;
+}
+
+/// Builds the BDD bottom-up with bddBdd::insert(). A variable of the domain
+///   that the ZDD skips is 0, i.e., a BDD node with the high son 0.
+unsigned
+bddZdd::toBdd_(unsigned                                 pRoot,
+               const vector<unsigned>&                  pVars,
+               unsigned                                 pPos,
+               map<pair<unsigned, unsigned>, unsigned>& pMemo)
+{
+  if(pRoot == 0)
+  {
+    return 0;
+  }
+  if(pPos == pVars.size())
+  {
+    // The domain contains all variables of the ZDD.
+    assert(pRoot == 1);
+    return 1;
+  }
+
+  const pair<unsigned, unsigned> lKey(pRoot, pPos);
+  map<pair<unsigned, unsigned>, unsigned>::const_iterator lIt
+    = pMemo.find(lKey);
+  if(lIt != pMemo.end())
+  {
+    return lIt->second;
+  }
+
+  const unsigned lVar = pVars[pPos];
+  assert(getVar(pRoot) >= lVar);
+  unsigned lResult;
+  if(getVar(pRoot) == lVar)
+  {
+    lResult = bddBdd::insert(lVar,
+                             toBdd_(getLow(pRoot), pVars, pPos + 1, pMemo),
+                             toBdd_(getHigh(pRoot), pVars, pPos + 1, pMemo));
+  }
+  else
+  {
+    lResult = bddBdd::insert(lVar, toBdd_(pRoot, pVars, pPos + 1, pMemo), 0);
+  }
+  pMemo[lKey] = lResult;
+  return lResult;
+}
+
+/// Initialization of ZDD package.
+void
+bddZdd::init(unsigned pMaxNodeNr,
+             unsigned pUniqueHBitNr,
+             unsigned pBinCBitNr,
+             unsigned pStatCBitNr,
+             unsigned pNodeNrLimit)
+{
+  // Allocate memory.
+  //   Plain C allocation, because the tables are resized by realloc().
+  mMaxNodeNr = pMaxNodeNr + 2;
+  mNodeNrLimit = pNodeNrLimit;
+  mNodes = (bddZddNode*) calloc(mMaxNodeNr, sizeof(bddZddNode));
+  mExtRefCnts = (unsigned*) calloc(mMaxNodeNr, sizeof(unsigned));
+  mStamps = (unsigned short*) calloc(mMaxNodeNr, sizeof(unsigned short));
+  mEpoch = 0;
+
+  // At most two nodes per chain on average.
+  mUniqueHBitNr = (pUniqueHBitNr > 1) ? pUniqueHBitNr - 1 : 1;
+  while((2u << mUniqueHBitNr) < mMaxNodeNr  &&  mUniqueHBitNr < 31)
+  {
+    ++mUniqueHBitNr;
+  }
+  mUniqueHash = (unsigned*) calloc((size_t) 1 << mUniqueHBitNr,
+                                   sizeof(unsigned));
+
+  // Two entries per set. The node indices among the arguments and results
+  //   (bit 3: result) are checked by garbage collection.
+  bool lCachesOk
+    =  mApplyCache.init(pBinCBitNr - 1, 1 | 2 | 8)
+    && mVarCache.init(pBinCBitNr - 2, 1 | 8)
+    && mStatCache.init(pStatCBitNr - 1, 1);
+
+  if(!mNodes || !mExtRefCnts || !mStamps || !mUniqueHash || !lCachesOk)
+  {
+    cerr << "Error: "
+         << "Not enough memory for initialization of ZDD package." << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // Initialise terminal nodes.
+  for(unsigned lCnt = 0; lCnt < 2; ++lCnt)
+  {
+    mNodes[lCnt].var = mTerminalVar;
+    mNodes[lCnt].mark = 1;
+  }
+
+  // Initialise mFree list of unused nodes.
+  mFree = 0;
+  mFreeNr = 0;
+  for(unsigned lCnt = mMaxNodeNr - 1; lCnt >= 2; --lCnt)
+  {
+    mNodes[lCnt].low = mFree;
+    mFree = lCnt;
+    ++mFreeNr;
+  }
+}
+
+/// Frees memory used by the static data structures.
+void
+bddZdd::done()
+{
+  free(mNodes);
+  mNodes = 0;
+  free(mExtRefCnts);
+  mExtRefCnts = 0;
+  free(mStamps);
+  mStamps = 0;
+  free(mUniqueHash);
+  mUniqueHash = 0;
+  mApplyCache.done();
+  mVarCache.done();
+  mStatCache.done();
+}
+
+/// Returns the maximum number of used nodes since resetPeakNodeNr().
+unsigned
+bddZdd::getPeakNodeNr()
+{
+  return max(mPeakMarkNr, mMaxNodeNr - 2 - mFreeNr);
+}
+
+/// Restarts the measurement of getPeakNodeNr() with at least pNodeNr nodes.
+void
+bddZdd::resetPeakNodeNr(unsigned pNodeNr)
+{
+  mPeakMarkNr = max(pNodeNr, mMaxNodeNr - 2 - mFreeNr);
+}
+
+/// Returns the overall number of lookups of all caches.
+unsigned long
+bddZdd::getCacheLookupNr()
+{
+  unsigned long lResult = 0;
+  for(unsigned lOp = 1; lOp < mOpNr; ++lOp)
+  {
+    lResult += mApplyCache.getLookupNr(lOp) + mVarCache.getLookupNr(lOp)
+      + mStatCache.getLookupNr(lOp);
+  }
+  return lResult;
+}
+
+/// Returns the overall number of hits of all caches.
+unsigned long
+bddZdd::getCacheHitNr()
+{
+  unsigned long lResult = 0;
+  for(unsigned lOp = 1; lOp < mOpNr; ++lOp)
+  {
+    lResult += mApplyCache.getHitNr(lOp) + mVarCache.getHitNr(lOp)
+      + mStatCache.getHitNr(lOp);
+  }
+  return lResult;
+}
+
+/// Writes the statistics as JSON object, like bddBdd::printStats().
+void
+bddZdd::printStats(ostream& pS)
+{
+  // Names of the operation identifiers, as in the enumeration.
+  static const char* const lOpNames[mOpNr] = { 0,
+    "unite", "intersect", "difference", "exists", "extend",
+    "addVar", "onset", "offset", "rename", "setCount" };
+
+  pS << "{\n  \"operations\": {";
+  for(unsigned lOp = 1; lOp < mOpNr; ++lOp)
+  {
+    const bddCache<bddBinEntry>& lCache
+      = (lOp < mAddVar) ? mApplyCache : mVarCache;
+    const unsigned long lLookupNr = (lOp < mCount)
+      ? lCache.getLookupNr(lOp) : mStatCache.getLookupNr(lOp);
+    const unsigned long lHitNr = (lOp < mCount)
+      ? lCache.getHitNr(lOp) : mStatCache.getHitNr(lOp);
+    pS << (lOp == 1 ? "\n" : ",\n")
+       << "    \"" << lOpNames[lOp] << "\": { "
+       << "\"calls\": " << mCallNr[lOp] << ", "
+       << "\"cacheLookups\": " << lLookupNr << ", "
+       << "\"cacheHits\": " << lHitNr << ", "
+       << "\"cacheMisses\": " << lLookupNr - lHitNr << " }";
+  }
+  pS << "\n  },\n";
+
+  pS << "  \"gc\": { "
+     << "\"major\": " << mGcNr << ", "
+     << "\"seconds\": " << mGcTime << " },\n";
+
+  const unsigned lUsedNr = mMaxNodeNr - 2 - mFreeNr;
+  pS << "  \"nodes\": { "
+     << "\"size\": " << mMaxNodeNr - 2 << ", "
+     << "\"limit\": " << mNodeNrLimit << ", "
+     << "\"used\": " << lUsedNr << ", "
+     << "\"peakLive\": " << mPeakLiveNr << ", "
+     << "\"peakUsed\": " << max(mPeakUsedNr, lUsedNr) << ", "
+     << "\"created\": " << mCreatedNr << ", "
+     << "\"grows\": " << mGrowNr << " }\n";
+  pS << "}" << endl;
+}
+
+bddZdd&
+bddZdd::operator=(const bddZdd& pZdd)
+{
+  if(this != &pZdd)
+  {
+    setRoot(pZdd.mRoot);
+  }
+  return *this;
+}
+
+/// Creates ZDD with the only set pVarIds.
+bddZdd
+bddZdd::mkCube(const set<unsigned>& pVarIds)
+{
+  gcIfDue();
+  return bddZdd(retryOnOutOfNodes(bddBind(&mkCube_, pVarIds), &reclaim));
+}
+
+/// Creates ZDD with the only set pVarIds.
+unsigned
+bddZdd::mkCube_(const set<unsigned>& pVarIds)
+{
+  // Bottom-up, i.e., beginning with the greatest variable id.
+  unsigned lRoot = 1;
+  for(set<unsigned>::const_reverse_iterator lIt = pVarIds.rbegin();
+      lIt != pVarIds.rend();
+      ++lIt)
+  {
+    lRoot = insert(*lIt, 0, lRoot);
+  }
+  return lRoot;
+}
+
+/// Creates ZDD for all subsets of pVarIds.
+bddZdd
+bddZdd::mkFull(const set<unsigned>& pVarIds)
+{
+  gcIfDue();
+  return bddZdd(retryOnOutOfNodes(bddBind(&mkFull_, pVarIds), &reclaim));
+}
+
+/// Creates ZDD for all subsets of pVarIds.
+unsigned
+bddZdd::mkFull_(const set<unsigned>& pVarIds)
+{
+  unsigned lRoot = 1;
+  for(set<unsigned>::const_reverse_iterator lIt = pVarIds.rbegin();
+      lIt != pVarIds.rend();
+      ++lIt)
+  {
+    lRoot = insert(*lIt, lRoot, lRoot);
+  }
+  return lRoot;
+}
+
+/// Creates ZDD for the value pValue: The set of the variables of the 1 bits.
+bddZdd
+bddZdd::mkValue(unsigned pVarId, unsigned pBitNr, unsigned pValue)
+{
+  set<unsigned> lVarIds;
+  for(unsigned lIt = 0; lIt < pBitNr; ++lIt)
+  {
+    if((pValue & (1u << lIt)) != 0)
+    {
+      lVarIds.insert(pVarId + (pBitNr - lIt - 1));
+    }
+  }
+  return mkCube(lVarIds);
+}
+
+/// Creates ZDD for 'x <= pValue', like bddBdd::mkLessEqual().
+bddZdd
+bddZdd::mkLessEqual(unsigned pVarId, unsigned pBitNr, unsigned pValue)
+{
+  // pValue < 2^pBitNr.
+  assert(pValue < (unsigned)(1<<pBitNr));
+
+  gcIfDue();
+  return bddZdd(retryOnOutOfNodes(bddBind(&mkLessEqual_, 
+                                          pVarId, pBitNr, pValue),
+                                  &reclaim));
+}
+
+/// Creates ZDD for 'x <= pValue':
+///   From the least significant bit (the greatest variable id) on,
+///   lRoot is the family of the lower bits that are <= those of pValue,
+///   and lFull the family of all lower bits.
+unsigned
+bddZdd::mkLessEqual_(unsigned pVarId, unsigned pBitNr, unsigned pValue)
+{
+  unsigned lRoot = 1;
+  unsigned lFull = 1;
+  for(unsigned lIt = 0; lIt < pBitNr; ++lIt)
+  {
+    const unsigned lPosition = pVarId + (pBitNr - lIt - 1);
+    if((pValue & (1u << lIt)) != 0)
+    {
+      lRoot = insert(lPosition, lFull, lRoot);
+    }
+    lFull = insert(lPosition, lFull, lFull);
+  }
+  return lRoot;
+}
+
+/// Returns number of represented sets.
+double
+bddZdd::getSetNr() const
+{
+  ++mCallNr[mCount];
+  return getSetNr_(mRoot);
+}
+
+/// Returns number of nodes (Terminal nodes are not counted).
+///   Stamps the visited nodes with a new epoch (see mStamps).
+unsigned
+bddZdd::getNodeNr() const
+{
+  const unsigned short lEpoch = newEpoch();
+  unsigned lResult = 0;
+  vector<unsigned> lStack;
+  if(visit(mRoot, lEpoch))
+  {
+    lStack.push_back(mRoot);
+  }
+  while(!lStack.empty())
+  {
+    const unsigned lNode = lStack.back();
+    lStack.pop_back();
+    ++lResult;
+    if(visit(getLow(lNode), lEpoch))
+    {
+      lStack.push_back(getLow(lNode));
+    }
+    if(visit(getHigh(lNode), lEpoch))
+    {
+      lStack.push_back(getHigh(lNode));
+    }
+  }
+  return lResult;
+}
+
+/// Returns the BDD over the domain pVars.
+bddBdd
+bddZdd::toBdd(const vector<unsigned>& pVars) const
+{
+  // A BDD operation, which protects its intermediate results.
+  bddBdd::gcIfDue();
+  return bddBdd(retryOnOutOfNodes(bddBind(&toBddEdge_, mRoot, pVars),
+                                  &bddBdd::reclaim));
+}
+
+/// Returns the BDD edge for the ZDD with root pRoot over the domain pVars.
+unsigned
+bddZdd::toBddEdge_(unsigned pRoot, const vector<unsigned>& pVars)
+{
+  map<pair<unsigned, unsigned>, unsigned> lMemo;
+  return toBdd_(pRoot, pVars, 0, lMemo);
+}
+
+/// Keeps the sets with both or none of pVar1 and pVar2.
+void
+bddZdd::selectEqual(unsigned pVar1, unsigned pVar2)
+{
+  ++mCallNr[mOnset];
+  gcIfDue();
+  setRoot(retryOnOutOfNodes(bddBind(&selectEqual_, mRoot, pVar1, pVar2),
+                            &reclaim));
+}
+
+/// Keeps the sets with both or none of pVar1 and pVar2.
+unsigned
+bddZdd::selectEqual_(unsigned pRoot, unsigned pVar1, unsigned pVar2)
+{
+  // No garbage collection during the operation, thus the
+  //   intermediate results need no references.
+  const unsigned lBoth = onset_(onset_(pRoot, pVar1), pVar2);
+  const unsigned lNone = offset_(offset_(pRoot, pVar1), pVar2);
+  return unite_(lBoth, lNone);
+}
+
+/// Replace each variable id v < pVarMap.size() by pVarMap[v]
+///   simultaneously (see rename_()).
+void
+bddZdd::rename(const vector<unsigned>& pVarMap)
+{
+  // Same renamings share their cache entries.
+  map<vector<unsigned>, unsigned>::const_iterator lIt
+    = mRenameKeys.find(pVarMap);
+  if(lIt == mRenameKeys.end())
+  {
+    lIt = mRenameKeys.insert(make_pair(pVarMap, (unsigned) mRenameKeys.size())).first;
+  }
+
+  ++mCallNr[mRename];
+  gcIfDue();
+  setRoot(retryOnOutOfNodes(bddBind(&rename_, mRoot, pVarMap, lIt->second),
+                            &reclaim));
+}
@@ -0,0 +1,536 @@
+/*
+ * CrocoPat is a tool for relational programming.
+ * This file is part of CrocoPat.
+ *
+ * Copyright (C) 2002-2008  Dirk Beyer
+ *
+ * CrocoPat is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * CrocoPat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with CrocoPat; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Please find the GNU Lesser General Public License in file
+ * License_LGPL.txt or at http://www.gnu.org/licenses/lgpl.txt
+ *
+ * Author:
+ * Dirk Beyer (firstname.lastname@sfu.ca)
+ * Simon Fraser University
+ *
+ * With contributions of: Andreas Noack, Michael Vogel
+ */
+
+#ifndef _bddZdd_h
+#define _bddZdd_h
+
+#include "bddBdd.h"
+
+#include <vector>
+#include <set>
+#include <map>
+#include <cassert>
+#include <climits>
+#include <ctime>
+
+/// ZDD node
+///
+/// A Zero-suppressed Decision Diagram represents a family of sets
+///   of variables, e.g., a relation as the family of the sets of
+///   variables whose bits are 1 in the tuples.
+/// Nodes whose high son is the empty family are not stored
+///   (zero-suppression), thus a variable that does not occur
+///   on a path is 0, not a don't care as in a BDD.
+///   Sparse relations, whose tuples have few 1 bits, need few nodes.
+/// Sons are referenced by plain node indices (no complement edges).
+struct bddZddNode
+{
+  /// To mark the node in garbage collection and node count
+  unsigned mark:1;
+  /// Variable id.
+  unsigned var:31;
+  /// Index of the low son (sets without the variable).
+  /// Also used for linking unused nodes in the node array.
+  unsigned low;
+  /// Index of the high son (sets with the variable).
+  unsigned high;
+  /// Index of the next node in the same chain of the unique table
+  ///   (0 for the end of the chain).
+  unsigned next;
+};
+
+/// One Zero-suppressed Decision Diagram
+/// and static data structures of the whole shared ZDD package.
+/// An alternative to bddBdd for sparse relations (see bddRelation).
+///   A ZDD has no don't cares: It is a family of sets over a set of
+///   variables (the domain) that the package user keeps track of.
+///   Before two ZDDs with different domains are combined,
+///   extend() adds the missing variables to their domains.
+class bddZdd : private relObject
+{
+private: // Constants.
+
+  /// Variable id of the terminal nodes, greater than all other ids.
+  enum { mTerminalVar = (1u << 31) - 1 };
+
+  /// Identifiers of the operations in the caches.
+  ///   The calls of selectEqual() are counted as mOnset.
+  enum { mUnite = 1, mIntersect, mDifference,   // mApplyCache
+         mExists, mExtend,                       // mApplyCache (cubes)
+         mAddVar, mOnset, mOffset, mRename,      // mVarCache
+         mCount };                               // mStatCache
+  /// Bound of the operation identifiers (for the statistics).
+  enum { mOpNr = mCount + 1 };
+
+private: // Static attributes.
+
+  /// Node Array.
+  /// mNodes[0] is the terminal for the empty family,
+  /// mNodes[1] the terminal for the family that contains
+  /// only the empty set (base). Both are always marked (mark == 1)
+  /// and have the variable id mTerminalVar.
+  /// 0 if the package is not initialized (see isActive()).
+  static bddZddNode* mNodes;
+  /// Number of elements of mNodes. Grows on demand (see grow()).
+  static unsigned mMaxNodeNr;
+  /// Maximum number of nodes (terminals not counted) that mNodes may
+  /// grow to. 0 means no limit.
+  static unsigned mNodeNrLimit;
+  /// Index of the first unused node in mNodes.
+  /// Unused nodes are linked using their low-element.
+  static unsigned mFree;
+  /// Number of unused nodes in the list mFree.
+  static unsigned mFreeNr;
+
+  /// Numbers of external (i.e. by the package user) references,
+  ///   one counter per element of mNodes (parallel array).
+  /// Updated by constructors and destructors. Terminals are not counted.
+  /// Used in garbage collections to recognise live nodes.
+  static unsigned* mExtRefCnts;
+
+  /// Hash table of all used nodes, with chaining (see bddZddNode::next).
+  /// Used by insert to ensure that mNodes contains no two equal nodes.
+  /// Index of the first node of each chain, 0 for an empty chain.
+  static unsigned* mUniqueHash;
+  /// Number of chains of mUniqueHash == 2^mUniqueHBitNr.
+  static unsigned mUniqueHBitNr;
+  /// Caches for the results of the operations, one per family
+  ///   (see the identifiers of the operations).
+  /// Garbage collection drops only the entries that refer to dead nodes.
+  /// Cache for the binary operations and the operations with cubes.
+  static bddCache<bddBinEntry> mApplyCache;
+  /// Cache for the operations with variable ids as arguments.
+  static bddCache<bddBinEntry> mVarCache;
+  /// Cache for the results of getSetNr().
+  static bddCache<bddStatEntry> mStatCache;
+
+  /// Cache argument for rename_() per renaming (variable map),
+  ///   such that the cache entries of a renaming are reused by later calls.
+  static map<vector<unsigned>, unsigned> mRenameKeys;
+
+  /// Visited markers of the traversals, one per element of mNodes,
+  ///   and the epoch of the last traversal, as bddBdd::mStamps.
+  static unsigned short* mStamps;
+  static unsigned short mEpoch;
+
+  /// Statistics for printStats().
+  /// Number of calls of the public operations, per operation identifier.
+  static unsigned long mCallNr[mOpNr];
+  /// Number of garbage collections, and their processor time in seconds.
+  static unsigned long mGcNr;
+  static double mGcTime;
+  /// Maximum number of live nodes after, resp. used nodes before
+  ///   a garbage collection.
+  static unsigned mPeakLiveNr;
+  static unsigned mPeakUsedNr;
+  /// Maximum number of used nodes since resetPeakNodeNr().
+  static unsigned mPeakMarkNr;
+  /// Overall number of nodes created by insert().
+  static unsigned long mCreatedNr;
+  /// Numbers of growths of the node array.
+  static unsigned long mGrowNr;
+  /// Number of live nodes after the last garbage collection.
+  static unsigned mGcLiveNr;
+  /// Observer of garbage collections and growth (0 for none).
+  static bddObserver mObserver;
+
+private: // Private static methods.
+
+  /// Returns the variable id resp. the sons of node pNode.
+  static unsigned
+  getVar(unsigned pNode)
+  { return mNodes[pNode].var; }
+  static unsigned
+  getLow(unsigned pNode)
+  { return mNodes[pNode].low; }
+  static unsigned
+  getHigh(unsigned pNode)
+  { return mNodes[pNode].high; }
+
+  /// Hash function for mUniqueHash.
+  static unsigned
+  hash(unsigned pVar, unsigned pLow, unsigned pHigh);
+
+  /// Returns true if node pNode is marked (for bddCache::sweep()).
+  static bool
+  isMarked(unsigned pNode)
+  { return mNodes[pNode].mark; }
+
+  /// Marks all nodes of the ZDD with the root pRoot, iteratively.
+  static void
+  mark(unsigned pRoot, vector<unsigned>& pStack);
+  /// Returns a new stamp for a traversal (see mStamps).
+  static unsigned short
+  newEpoch();
+  /// Stamps the node pNode (not a terminal) with pEpoch.
+  ///   Returns false if it was already stamped, i.e., visited.
+  static bool
+  visit(unsigned pNode, unsigned short pEpoch)
+  {
+    if(pNode < 2  ||  mStamps[pNode] == pEpoch)
+    {
+      return false;
+    }
+    mStamps[pNode] = pEpoch;
+    return true;
+  }
+
+  /// Inserts node pNode into its chain of mUniqueHash.
+  static void
+  hashInsert(unsigned pNode);
+
+  /// Garbage collection: Frees all nodes that are not reachable from
+  ///   externally referenced nodes, and rebuilds mUniqueHash.
+  ///   Only between operations, i.e., intermediate results are dead.
+  static void
+  gc();
+
+  /// Proactive garbage collection before an operation,
+  ///   if less than 1/8 of the nodes is free.
+  static void
+  gcIfDue();
+
+  /// Grows the node array, the hash table, and the caches.
+  ///   The new nodes are added to the list of unused nodes,
+  ///   and the node indices remain valid. Thus an operation
+  ///   continues after insert() grew the tables.
+  /// Returns false if the limit is reached or memory is exhausted.
+  static bool
+  grow();
+
+  /// Provides free nodes after insert() failed in the pTry-th try
+  /// of an operation: Garbage collection, and growth of the tables
+  /// if garbage collection does not free enough nodes.
+  /// Aborts the program if the node array cannot grow any more.
+  static void
+  reclaim(unsigned pTry);
+
+  /// Returns the index of the node with the passed var-, low- and
+  /// high-indices. If such node does not exists, it is inserted into
+  /// mNodes and mUniqueHash. If there are no free nodes left and the
+  /// tables cannot grow, throws exception.
+  /// Zero-suppression: Returns pLow if pHigh is the empty family.
+  static unsigned
+  insert(unsigned pVar, unsigned pLow, unsigned pHigh);
+
+  /// Runs operation pOp (see the identifiers of the operations)
+  ///   with the arguments pArg1 and pArg2, after garbage collection
+  ///   if due, and again after reclaim() if the nodes are exhausted.
+  static unsigned
+  run(unsigned pOp, unsigned pArg1, unsigned pArg2);
+
+  /// The operations. The cubes are ZDDs with one set (see mkCube()).
+  static unsigned
+  apply_(unsigned pOp, unsigned pArg1, unsigned pArg2);
+  static unsigned
+  unite_(unsigned pRoot1, unsigned pRoot2);
+  static unsigned
+  intersect_(unsigned pRoot1, unsigned pRoot2);
+  static unsigned
+  difference_(unsigned pRoot1, unsigned pRoot2);
+  /// Removes the variables of the cube pCube from all sets.
+  static unsigned
+  exists_(unsigned pRoot, unsigned pCube);
+  /// Adds the variables of the cube pCube as don't cares, i.e.,
+  ///   the product with the power set of pCube.
+  ///   The sets must not contain these variables.
+  static unsigned
+  extend_(unsigned pRoot, unsigned pCube);
+  /// Adds variable pVar to all sets, which must not contain it.
+  static unsigned
+  addVar_(unsigned pRoot, unsigned pVar);
+  /// Keeps the sets with resp. without variable pVar.
+  static unsigned
+  onset_(unsigned pRoot, unsigned pVar);
+  static unsigned
+  offset_(unsigned pRoot, unsigned pVar);
+  /// Replaces each variable id v < pVarMap.size() by pVarMap[v]
+  ///   simultaneously. pVarMap must be injective on the variables
+  ///   of the ZDD, but need not preserve the variable order.
+  static unsigned
+  rename_(unsigned                pRoot,
+          const vector<unsigned>& pVarMap,
+          unsigned                pKey);
+  /// Returns the number of sets.
+  static double
+  getSetNr_(unsigned pRoot);
+  /// Node creation of the named constructors (see mkCube() etc.).
+  static unsigned
+  mkCube_(const set<unsigned>& pVarIds);
+  static unsigned
+  mkFull_(const set<unsigned>& pVarIds);
+  static unsigned
+  mkLessEqual_(unsigned pVarId, unsigned pBitNr, unsigned pValue);
+  /// Keeps the sets with both or none of pVar1 and pVar2.
+  static unsigned
+  selectEqual_(unsigned pRoot, unsigned pVar1, unsigned pVar2);
+  /// Returns the BDD edge for the ZDD with root pRoot over the domain
+  ///   pVars (see toBdd()).
+  static unsigned
+  toBddEdge_(unsigned pRoot, const vector<unsigned>& pVars);
+  /// Returns the BDD edge for the ZDD with root pRoot over the domain
+  ///   pVars[pPos], pVars[pPos+1], ...
+  ///   pMemo holds the results per (root, position).
+  static unsigned
+  toBdd_(unsigned                                 pRoot,
+         const vector<unsigned>&                  pVars,
+         unsigned                                 pPos,
+         map<pair<unsigned, unsigned>, unsigned>& pMemo);
+
+public: // Public static methods.
+
+  /// Initialisation of ZDD package. The package is optional,
+  ///   i.e., only initialized if it is used (see isActive()).
+  /// Parameters:
+  ///   number of elements of mNodes == pMaxNodeNr,
+  ///   number of chains of mUniqueHash == 2^(pUniqueHBitNr-1),
+  ///     or more if the nodes do not fit in,
+  ///   number of entries of mApplyCache and mVarCache == 2^pBinCBitNr each,
+  ///   number of entries of mStatCache == 2^pStatCBitNr.
+  /// These are initial sizes. The tables grow on demand,
+  ///   up to pNodeNrLimit nodes (0 for no limit).
+  static void
+  init(unsigned pMaxNodeNr,
+    unsigned pUniqueHBitNr, unsigned pBinCBitNr, unsigned pStatCBitNr,
+    unsigned pNodeNrLimit = 0);
+  /// Frees memory used by the static data structures.
+  static void
+  done();
+  /// Returns true between init() and done().
+  static bool
+  isActive()
+  { return mNodes != 0; }
+
+  /// Writes the statistics of the package (calls and cache hits
+  ///   per operation, garbage collections, growth)
+  ///   as JSON object to pS. Must be called before done().
+  static void
+  printStats(ostream& pS);
+
+  /// Returns the number of nodes created since init().
+  static unsigned long
+  getCreatedNodeNr()
+  { return mCreatedNr; }
+  /// Returns the maximum number of used (live or dead) nodes
+  ///   since the last call of resetPeakNodeNr(), as for bddBdd.
+  static unsigned
+  getPeakNodeNr();
+  /// Restarts the measurement of getPeakNodeNr(), with the current
+  ///   number of used nodes, or pNodeNr if this is larger.
+  static void
+  resetPeakNodeNr(unsigned pNodeNr = 0);
+  /// Returns the number of used (live or dead) nodes without
+  ///   garbage collection, resp. the number of live nodes after
+  ///   the last garbage collection (see mGcLiveNr).
+  static unsigned
+  getUsedNodeNr()
+  { return mMaxNodeNr - 2 - mFreeNr; }
+  static unsigned
+  getGcLiveNodeNr()
+  { return mGcLiveNr; }
+  /// Returns the number of unused nodes (see mFree), without
+  ///   garbage collection.
+  static unsigned
+  getUnusedNodeNr()
+  { return mFreeNr; }
+  /// Returns the overall numbers of lookups resp. hits of all caches.
+  static unsigned long
+  getCacheLookupNr();
+  static unsigned long
+  getCacheHitNr();
+
+  /// Sets the observer of garbage collections and growth
+  ///   (0 for none), as bddBdd::setObserver().
+  static void
+  setObserver(bddObserver pObserver)
+  { mObserver = pObserver; }
+  /// Returns the current size of the node array.
+  static unsigned
+  getMaxNodeNr()
+  { return mMaxNodeNr; }
+
+private: // Attributes.
+
+  /// Index (in mNodes) of the root node of the ZDD.
+  unsigned mRoot;
+
+private: // Private methods.
+
+  /// Decrements the reference counter of mRoot (if mRoot is no terminal).
+  void decRef()
+  {
+    if(mRoot > 1)
+    {
+      // Otherwise error in external ZDD references.
+      assert(mExtRefCnts[mRoot] > 0);
+      --mExtRefCnts[mRoot];
+    }
+  }
+
+  /// Increments the reference counter of mRoot (if mRoot is no terminal).
+  void incRef()
+  {
+    if(mRoot > 1)
+    {
+      ++mExtRefCnts[mRoot];
+    }
+  }
+
+  /// Replaces mRoot by pRoot.
+  void setRoot(unsigned pRoot)
+  {
+    decRef();
+    mRoot = pRoot;
+    incRef();
+  }
+
+public: // Constructors and destructor.
+
+  /// Creates ZDD with root pRoot: 0 for the empty family,
+  ///   1 for the family that contains only the empty set.
+  bddZdd(unsigned pRoot = 0)
+  {
+    mRoot = pRoot;
+    incRef();
+  }
+
+  /// Creates ZDD as a copy of pZdd.
+  bddZdd(const bddZdd& pZdd)
+  {
+    mRoot = pZdd.mRoot;
+    incRef();
+  }
+
+  ~bddZdd()
+  {
+    decRef();
+  }
+
+  /// Assignment operator.
+  bddZdd&
+  operator=(const bddZdd& pZdd);
+
+  /// Non-standard named constructor.
+  /// Creates ZDD with the set of variables 'pVarIds' as only element
+  ///   (a cube). Cubes are used as sets of variables for exists()
+  ///   and extend().
+  static bddZdd
+  mkCube(const set<unsigned>& pVarIds);
+
+  /// Non-standard named constructor.
+  /// Creates ZDD for all subsets of 'pVarIds' (the full relation
+  ///   over the domain 'pVarIds').
+  static bddZdd
+  mkFull(const set<unsigned>& pVarIds);
+
+  /// Non-standard named constructor.
+  /// Creates ZDD that assign bit values of 'pValue' to 'pBitNr' variables
+  ///   beginning at position 'pVarId', with the encoding of bddBdd.
+  static bddZdd
+  mkValue(unsigned pVarId, unsigned pBitNr, unsigned pValue);
+
+  /// Non-standard named constructor.
+  /// Creates ZDD for 'x <= pValue'
+  ///   for 'pBitNr' variables of 'x' beginning at position 'pVarId'.
+  static bddZdd
+  mkLessEqual(unsigned pVarId, unsigned pBitNr, unsigned pValue);
+
+public: // Accessors.
+
+  /// Returns number of represented sets.
+  double
+  getSetNr() const;
+
+  /// Returns number of nodes (Terminal nodes are not counted).
+  unsigned
+  getNodeNr() const;
+
+  /// Returns the BDD for the ZDD over the domain pVars (ascending),
+  ///   which must contain all variables of the ZDD.
+  bddBdd
+  toBdd(const vector<unsigned>& pVars) const;
+
+public: // Service methods.
+
+  /// Check if the families represented by *this and pZdd are equal.
+  bool
+  setEqual(const bddZdd& pZdd) const
+  { return mRoot == pZdd.mRoot; }
+
+  /// Check if the represented family is empty.
+  bool
+  isEmpty() const
+  { return mRoot == 0; }
+
+  /// When the node array is full, the following operations continue
+  ///   after growth of the tables. If the tables cannot grow,
+  ///   they collect garbage and try again.
+  /// If this fails, too, the program is aborted.
+
+  /// Unites with pZdd.
+  void
+  unite(const bddZdd& pZdd)
+  { setRoot(run(mUnite, mRoot, pZdd.mRoot)); }
+
+  /// Intersects with pZdd.
+  void
+  intersect(const bddZdd& pZdd)
+  { setRoot(run(mIntersect, mRoot, pZdd.mRoot)); }
+
+  /// Removes the sets of pZdd.
+  void
+  difference(const bddZdd& pZdd)
+  { setRoot(run(mDifference, mRoot, pZdd.mRoot)); }
+
+  /// Removes the variables of the cube pCube (see mkCube()) from all sets,
+  ///   i.e., existential quantification.
+  void
+  exists(const bddZdd& pCube)
+  { setRoot(run(mExists, mRoot, pCube.mRoot)); }
+
+  /// Adds the variables of the cube pCube as don't cares,
+  ///   i.e., extends the domain by variables that no set contains.
+  void
+  extend(const bddZdd& pCube)
+  { setRoot(run(mExtend, mRoot, pCube.mRoot)); }
+
+  /// Keeps only the sets that contain either both or none of
+  ///   the variables pVar1 and pVar2 (pVar1 == pVar2 in BDD terms).
+  void
+  selectEqual(unsigned pVar1, unsigned pVar2);
+
+  /// Replaces each variable id v < pVarMap.size() by pVarMap[v]
+  ///   simultaneously. pVarMap must be injective on the variables
+  ///   of the ZDD, but need not preserve the variable order.
+  void
+  rename(const vector<unsigned>& pVarMap);
+};
+
+#endif
@@ -29,9 +29,12 @@
  */
 
 #include "bddBdd.h"
+#include "bddZdd.h"
 #include "relStatement.h"
 #include <FlexLexer.h>
 #include "relReaderWriter.h"
+#include "relProfile.h"
+#include "relTrace.h"
 
 #include <fstream>
 #include <sstream>
@@ -40,8 +43,14 @@
 #include <cmath>
 #include <csignal>
 #include <unistd.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <cstring>
+#include <cerrno>
+#include <climits>
 using namespace std;
 
 /// Global function.
@@ -56,6 +65,12 @@ relStatement*             gSyntaxTree        = NULL;
 map<string, relDataType*> gVariables;
 map<string, relStatement*> gProcedures;
 bool                      gPrintWarnings     = true;
+string*                   gOrderFileName     = NULL;  // For reordering.
+string*                   gSnapshotInName    = NULL;  // Input data snapshot.
+string*                   gSnapshotOutName   = NULL;
+unsigned                  gReorderLocks      = 0;
+bool                      gPrintStats        = false; // BDD statistics.
+bool                      gProfile           = false; // Profiler.
 
 /// Global variable for BDD init, RSF reader, symtab init.
 const unsigned gRSFLineLength   = 100000; // Default: 100000 chars per RSF line max.
@@ -122,6 +137,45 @@ signal_handler(int pSignal)
   exit(EXIT_FAILURE);
 }
 
+//////////////////////////////////////////////////////////////////////////////
+/// Prints the statistics of the BDD package to stderr (option --stats),
+///   resp. of the ZDD package if the relations are ZDDs (option --zdd).
+///   Registered with atexit() for the statement EXIT, 
+///   and called explicitly before the BDD package is freed.
+void
+printStats(void)
+{
+  if (gPrintStats) {
+    gPrintStats = false;
+    if (bddZdd::isActive()) {
+      bddZdd::printStats(cerr);
+    } else {
+      bddBdd::printStats(cerr);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// Prints the profile of the RML program to stderr (option --profile).
+///   Registered with atexit() like printStats().
+void
+printProfile(void)
+{
+  if (gProfile) {
+    gProfile = false;
+    relProfiler::printReport(cerr);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// Closes the timeline (option --trace). Registered with atexit() 
+///   like printStats().
+void
+closeTrace(void)
+{
+  relTrace::close();
+}
+
 //////////////////////////////////////////////////////////////////////////////
 /// Reads a next value into 'pValue', 
 ///   uses global configuration set by file2vector (gReadPos).
@@ -283,6 +337,366 @@ createBddRelation(vector< vector<string> >& pRelation)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////
+/// Binary snapshot of the input data, to start without parsing RSF.
+/// Numbers are unsigned ints in host byte order, a string is its length 
+///   and its characters. After gSnapshotMagic follow: gSnapshotByteOrder 
+///   (to reject snapshots from hosts with another byte order), the bit 
+///   width, the values (number, and per value the string and a byte 
+///   which is 1 for quoted values), the internal attributes (number, 
+///   and per attribute its name and block, i.e. position / bit width),
+///   the relations (number, and per relation its name, arity, and 
+///   width, i.e. the greatest number of elements of its tuples),
+///   and the shared nodes of the relations (see bddBdd::writeNodes()).
+const char gSnapshotMagic[] = "CrocoPat snapshot 1\n";
+const unsigned gSnapshotByteOrder = 0x01020304;
+
+/// Snapshot file in memory, and its contents that are read
+///   before the BDD package is ready (see readSnapshot()).
+struct snapshotData
+{
+  /// The file contents, mapped into memory if possible.
+  const char* mem;
+  size_t size;
+  bool mapped;
+  /// Reading position, and end of the contents.
+  const char* pos;
+  const char* end;
+  unsigned bitNr;
+  vector<string> values;
+  /// Internal attribute of each block.
+  map<unsigned, string> blocks;
+  vector<string> relations;
+  vector<int> arities;
+  vector<unsigned> widths;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// Writes (pNumber) to a snapshot.
+void
+writeSnapshotNumber(ostream& pOut, unsigned pNumber)
+{
+  pOut.write((const char*) &pNumber, sizeof(pNumber));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// Writes (pString) to a snapshot.
+void
+writeSnapshotString(ostream& pOut, const string& pString)
+{
+  writeSnapshotNumber(pOut, pString.size());
+  pOut.write(pString.data(), pString.size());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// Writes a snapshot of the value universe, the internal attributes,
+///   and the relations in (pWidths), which maps them to their tuple widths.
+void
+writeSnapshot(const string& pFileName, const map<string, unsigned>& pWidths)
+{
+  ofstream lOut(pFileName.c_str(), ios::out | ios::binary);
+  if (!lOut.good()) {
+    cerr << "Error: Cannot open snapshot file '" << pFileName << "'." << endl;
+    exit(EXIT_FAILURE);
+  }
+  lOut.write(gSnapshotMagic, strlen(gSnapshotMagic));
+  writeSnapshotNumber(lOut, gSnapshotByteOrder);
+  writeSnapshotNumber(lOut, gSymTab->getBitNr());
+
+  writeSnapshotNumber(lOut, gSymTab->getUniverseSize());
+  for (unsigned i = 0; i < gSymTab->getUniverseSize(); ++i) {
+    const string lValue = gSymTab->getAttributeValue(i);
+    writeSnapshotString(lOut, lValue);
+    lOut.put(gSymTab->isQuoted(lValue) ? 1 : 0);
+  }
+
+  writeSnapshotNumber(lOut, gAttributeNum);
+  for (unsigned i = 0; i < gAttributeNum; ++i) {
+    const string lAttribute = gAttributePrefix + unsigned2string(i);
+    writeSnapshotString(lOut, lAttribute);
+    writeSnapshotNumber(lOut, gSymTab->getAttributePos(lAttribute) / gSymTab->getBitNr());
+  }
+
+  vector<bddRelation> lRelations;
+  writeSnapshotNumber(lOut, pWidths.size());
+  for (map<string, unsigned>::const_iterator lIt = pWidths.begin();
+       lIt != pWidths.end();
+       ++lIt) {
+    const bddRelation* lRel = dynamic_cast<bddRelation*>(gVariables[lIt->first]);
+    assert(lRel != NULL);
+    writeSnapshotString(lOut, lIt->first);
+    writeSnapshotNumber(lOut, (unsigned) lRel->mArity);
+    writeSnapshotNumber(lOut, lIt->second);
+    lRelations.push_back(*lRel);
+  }
+  bddRelation::writeBdds(lOut, lRelations);
+
+  if (!lOut.good()) {
+    cerr << "Error: Cannot write snapshot file '" << pFileName << "'." << endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// Reads a number from a snapshot. Returns false at the end.
+bool
+readSnapshotNumber(snapshotData& pSnapshot, unsigned& pNumber)
+{
+  if ((size_t) (pSnapshot.end - pSnapshot.pos) < sizeof(pNumber)) {
+    return false;
+  }
+  memcpy(&pNumber, pSnapshot.pos, sizeof(pNumber));
+  pSnapshot.pos += sizeof(pNumber);
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// Reads a string from a snapshot. Returns false at the end.
+bool
+readSnapshotString(snapshotData& pSnapshot, string& pString)
+{
+  unsigned lLength;
+  if (   !readSnapshotNumber(pSnapshot, lLength)
+      || (size_t) (pSnapshot.end - pSnapshot.pos) < lLength) {
+    return false;
+  }
+  pString.assign(pSnapshot.pos, lLength);
+  pSnapshot.pos += lLength;
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// Reports a corrupt snapshot file and terminates.
+void
+snapshotCorrupt(const string& pFileName)
+{
+  cerr << "Error: Snapshot file '" << pFileName << "' is corrupt." << endl;
+  exit(EXIT_FAILURE);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// Maps snapshot file (pFileName) into memory, or reads it if it cannot
+///   be mapped, and reads everything except the BDDs: Adds the values 
+///   to the value universe and declares the relations, like file2vector().
+void
+readSnapshot(const string& pFileName, snapshotData& pSnapshot)
+{
+  const int lFile = open(pFileName.c_str(), O_RDONLY);
+  struct stat lStat;
+  if (lFile < 0  ||  fstat(lFile, &lStat) != 0) {
+    cerr << "Error: Cannot open snapshot file '" << pFileName << "'." << endl;
+    exit(EXIT_FAILURE);
+  }
+  pSnapshot.size = lStat.st_size;
+  pSnapshot.mapped = false;
+  void* lMem = MAP_FAILED;
+  if (pSnapshot.size > 0) {
+    lMem = mmap(NULL, pSnapshot.size, PROT_READ, MAP_PRIVATE, lFile, 0);
+  }
+  if (lMem != MAP_FAILED) {
+    pSnapshot.mapped = true;
+    pSnapshot.mem = (const char*) lMem;
+  } else {
+    char* lBuffer = (char*) malloc(pSnapshot.size + 1);
+    size_t lRead = 0;
+    while (lBuffer != NULL  &&  lRead < pSnapshot.size) {
+      const ssize_t lNr = read(lFile, lBuffer + lRead, pSnapshot.size - lRead);
+      if (lNr <= 0) {
+        break;
+      }
+      lRead += lNr;
+    }
+    if (lBuffer == NULL  ||  lRead < pSnapshot.size) {
+      cerr << "Error: Cannot read snapshot file '" << pFileName << "'." << endl;
+      exit(EXIT_FAILURE);
+    }
+    pSnapshot.mem = lBuffer;
+  }
+  close(lFile);
+  pSnapshot.pos = pSnapshot.mem;
+  pSnapshot.end = pSnapshot.mem + pSnapshot.size;
+
+  const size_t lMagicLength = strlen(gSnapshotMagic);
+  if (   pSnapshot.size < lMagicLength
+      || memcmp(pSnapshot.mem, gSnapshotMagic, lMagicLength) != 0) {
+    cerr << "Error: '" << pFileName << "' is no snapshot file." << endl;
+    exit(EXIT_FAILURE);
+  }
+  pSnapshot.pos += lMagicLength;
+
+  unsigned lNr;
+  if (!readSnapshotNumber(pSnapshot, lNr)) {
+    snapshotCorrupt(pFileName);
+  }
+  if (lNr != gSnapshotByteOrder) {
+    cerr << "Error: Snapshot file '" << pFileName 
+         << "' was written on a host with another byte order." << endl;
+    exit(EXIT_FAILURE);
+  }
+  if (   !readSnapshotNumber(pSnapshot, pSnapshot.bitNr)
+      || !readSnapshotNumber(pSnapshot, lNr)) {
+    snapshotCorrupt(pFileName);
+  }
+  for (unsigned i = 0; i < lNr; ++i) {
+    string lValue;
+    if (!readSnapshotString(pSnapshot, lValue)  ||  pSnapshot.pos == pSnapshot.end) {
+      snapshotCorrupt(pFileName);
+    }
+    if (*pSnapshot.pos++) {
+      gSymTab->setQuoted(lValue);
+    }
+    gValueUniverse.insert(lValue);
+    pSnapshot.values.push_back(lValue);
+  }
+
+  if (!readSnapshotNumber(pSnapshot, lNr)) {
+    snapshotCorrupt(pFileName);
+  }
+  for (unsigned i = 0; i < lNr; ++i) {
+    string lAttribute;
+    unsigned lBlock;
+    if (   !readSnapshotString(pSnapshot, lAttribute)
+        || !readSnapshotNumber(pSnapshot, lBlock)) {
+      snapshotCorrupt(pFileName);
+    }
+    pSnapshot.blocks[lBlock] = lAttribute;
+  }
+
+  if (!readSnapshotNumber(pSnapshot, lNr)) {
+    snapshotCorrupt(pFileName);
+  }
+  for (unsigned i = 0; i < lNr; ++i) {
+    string lName;
+    unsigned lArity;
+    unsigned lWidth;
+    if (   !readSnapshotString(pSnapshot, lName)
+        || !readSnapshotNumber(pSnapshot, lArity)
+        || !readSnapshotNumber(pSnapshot, lWidth)) {
+      snapshotCorrupt(pFileName);
+    }
+    if (gVariables.find(lName) == gVariables.end()) {  // New relation.
+      gVariables[lName] = new bddRelation(gSymTab, false);
+    }
+    pSnapshot.relations.push_back(lName);
+    pSnapshot.arities.push_back((int) lArity);
+    pSnapshot.widths.push_back(lWidth);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// Assigns the relations of the snapshot read by readSnapshot()
+///   to the relation variables, like createBddRelation(), 
+///   and frees the snapshot file.
+/// If the value universe is still the one of the snapshot,
+///   the BDDs are taken over directly, only the positions of the
+///   attributes may change. Otherwise (the program contains new values),
+///   the tuples are enumerated and encoded again.
+void
+createSnapshotRelations(const string& pFileName, 
+                        snapshotData& pSnapshot, 
+                        map<string, unsigned>& pWidths)
+{
+  const bool lSameUniverse
+    = gSymTab->getUniverseSize() == pSnapshot.values.size();
+
+  // Map the blocks of the snapshot to the current positions.
+  vector<unsigned> lVarMap;
+  if (lSameUniverse) {
+    for (map<unsigned, string>::const_iterator lIt = pSnapshot.blocks.begin();
+         lIt != pSnapshot.blocks.end();
+         ++lIt) {
+      while (lVarMap.size() < (lIt->first + 1) * pSnapshot.bitNr) {
+        lVarMap.push_back(lVarMap.size());
+      }
+      for (unsigned j = 0; j < pSnapshot.bitNr; ++j) {
+        lVarMap[lIt->first * pSnapshot.bitNr + j] 
+          = gSymTab->getAttributePos(lIt->second) + j;
+      }
+    }
+  }
+
+  vector<bddRelation> lRelations;
+  if (!bddRelation::readBdds(gSymTab, 
+                             pSnapshot.pos, 
+                             pSnapshot.end - pSnapshot.pos,
+                             lVarMap,
+                             lRelations)
+      || lRelations.size() != pSnapshot.relations.size()) {
+    snapshotCorrupt(pFileName);
+  }
+
+  vector< vector<string> > lRelationVector;
+  for (unsigned i = 0; i < lRelations.size(); ++i) {
+    const string& lName = pSnapshot.relations[i];
+    pWidths[lName] = pSnapshot.widths[i];
+    bddRelation* lResult = dynamic_cast<bddRelation*>(gVariables[lName]);
+    if (lResult == NULL  ||  dynamic_cast<bddRelationConst*>(lResult) != NULL) {
+      cerr << "Error: Snapshot relation '" << lName
+           << "' is a predefined standard variable." << endl;
+      exit(EXIT_FAILURE);
+    }
+    if (lSameUniverse) {
+      *lResult = lRelations[i];
+      lResult->mArity = pSnapshot.arities[i];
+      continue;
+    }
+
+    // Blocks of the internal attributes of the tuples, ascending,
+    //   and the element of the attribute in the tuples of the cursor.
+    map<unsigned, unsigned> lElementOfBlock;
+    for (map<unsigned, string>::const_iterator lIt = pSnapshot.blocks.begin();
+         lIt != pSnapshot.blocks.end();
+         ++lIt) {
+      for (unsigned j = 0; j < pSnapshot.widths[i]; ++j) {
+        if (lIt->second == gAttributePrefix + unsigned2string(j)) {
+          lElementOfBlock[lIt->first] = j;
+        }
+      }
+    }
+    if (lElementOfBlock.size() != pSnapshot.widths[i]) {
+      snapshotCorrupt(pFileName);
+    }
+    vector<unsigned> lVarIds;
+    for (map<unsigned, unsigned>::const_iterator lIt = lElementOfBlock.begin();
+         lIt != lElementOfBlock.end();
+         ++lIt) {
+      lVarIds.push_back(lIt->first * pSnapshot.bitNr);
+    }
+    for (bddTupleCursor lCursor = lRelations[i].getTuples(lVarIds, 
+                                                          pSnapshot.bitNr, 
+                                                          pSnapshot.values.size() - 1);
+         lCursor.isValid();
+         lCursor.next()) {
+      vector<string> lRow(pSnapshot.widths[i] + 1);
+      lRow[0] = lName;
+      unsigned k = 0;
+      for (map<unsigned, unsigned>::const_iterator lIt = lElementOfBlock.begin();
+           lIt != lElementOfBlock.end();
+           ++lIt, ++k) {
+        lRow[lIt->second + 1] = pSnapshot.values[lCursor.getTuple()[k]];
+      }
+      lRelationVector.push_back(lRow);
+    }
+  }
+
+  // Free the snapshot before the relations are encoded again.
+  lRelations.clear();
+  if (pSnapshot.mapped) {
+    munmap((void*) pSnapshot.mem, pSnapshot.size);
+  } else {
+    free((void*) pSnapshot.mem);
+  }
+  pSnapshot.mem = NULL;
+
+  if (!lSameUniverse) {
+    createBddRelation(lRelationVector);
+    for (unsigned i = 0; i < pSnapshot.relations.size(); ++i) {
+      dynamic_cast<bddRelation*>(gVariables[pSnapshot.relations[i]])->mArity 
+        = pSnapshot.arities[i];
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////  
 #define STRINGIFY(x) #x
 #define EXPAND(x) STRINGIFY(x)
@@ -307,14 +721,34 @@ printHelp(void)
        << "Execute RML (Relation Manipulation Language) program FILE." << endl
        << "ARGUMENTs are passed to the RML program." << endl
        << "Options:" << endl
+       << "  -c POLICY    replacement policy of the BDD caches: lru (default) or fifo." << endl
        << "  -e           do not read RSF data from stdin." << endl
        << "  -h           display this help message and exit." << endl
+       << "  -i FILE      read input data from snapshot FILE instead of stdin." << endl
+       << "  -j NUMBER    use NUMBER threads for BDD operations (default 1)." << endl
        << "  -l FILE      use library file FILE." << endl
-       << "  -m NUMBER    approximate memory for BDD package in MB (default 50)." << endl
+       << "  -m NUMBER    initial memory for BDD package in MB (default 4, was 50);" << endl
+       << "               the package grows on demand." << endl
+       << "  -M NUMBER    limit of the BDD node table, in MB of about 30000 nodes" << endl
+       << "               (default: no limit). Approximate: the caches and the" << endl
+       << "               unique table grow with the nodes and are not counted." << endl
+       << "  -o FILE      use variable order file FILE: read at start if it exists," << endl
+       << "               and written after each reordering." << endl
        << "  -q           quiet mode, supress warnings." << endl
+       << "  -r NUMBER    reorder BDD variables automatically if more than NUMBER" << endl
+       << "               BDD nodes are in use (default: only by REORDER statement)." << endl
        << "  -v           print version information and exit." << endl
+       << "  -w FILE      write input data to snapshot FILE after reading." << endl
+       << "  --profile    print the costs of the statements and relational expressions" << endl
+       << "               of the program to stderr at exit." << endl
+       << "  --stats      print statistics of the BDD package (JSON) to stderr at exit." << endl
+       << "  --trace FILE write a timeline of statements, loader phases and BDD events" << endl
+       << "               to FILE (Chrome trace event format, e.g. for Perfetto)." << endl
+       << "  --zdd        represent relations by ZDDs instead of BDDs (for sparse" << endl
+       << "               relations); options -m and -M apply to the ZDD package." << endl
+       << "               Not with -i and -w, no reordering." << endl
        << endl
-       << "Input data are read from stdin, unless option -e is given." << endl
+       << "Input data are read from stdin, unless option -e or -i is given." << endl
        << endl
        << "http://www.cs.sfu.ca/~dbeyer/CrocoPat/" << endl 
        << endl
@@ -322,6 +756,26 @@ printHelp(void)
        << endl;
 }
 
+////////////////////////////////////////////////////////////////////////  
+/// Returns the value (pArg) of option -(pOption), which must be a number
+///   from 1 to (pMax). Otherwise prints an error and the usage message,
+///   and terminates.
+int
+parseNumberOption(char pOption, const char* pArg, long pMax)
+{
+  char* lEnd;
+  errno = 0;
+  const long lValue = strtol(pArg, &lEnd, 10);
+  if (   lEnd == pArg  ||  *lEnd != '\0'  ||  errno != 0
+      || lValue < 1  ||  lValue > pMax) {
+    cerr << "Error: Option -" << pOption << " expects a number from 1 to "
+         << pMax << ", not '" << pArg << "'." << endl;
+    printHelp();
+    exit(EXIT_FAILURE);
+  }
+  return (int) lValue;
+}
+
 ////////////////////////////////////////////////////////////////////////  
 /// Main program.
 int 
@@ -333,13 +787,51 @@ crocopat(int argc, char *argv [])
   // Initialize input stream. Default: stdin.
   istream* gDataInStream = &cin;
 
-  // Initial value for BDD pkg size.
-  int gBddPkgSizeMB = 50;   // Default: 50 MB. Changed by cmd line option.
+  // Initial value for BDD pkg size. The BDD package grows on demand.
+  int gBddPkgSizeMB = 4;    // Default: 4 MB. Changed by cmd line option.
+  // Maximum BDD pkg size.
+  int gBddPkgMaxSizeMB = 0; // Default: no limit. Changed by cmd line option.
+  // Number of BDD nodes for automatic reordering.
+  int gReorderNodeNr = 0;   // Default: no automatic reordering.
+  // Replacement policy of the BDD caches.
+  bddCachePolicy gCachePolicy = LRU;
+  // Number of threads for BDD operations.
+  int gThreadNr = 1;        // Default: sequential.
+  const int gMaxThreadNr = 1024;
+  // The node numbers (30000 nodes per MB, see below) must fit 
+  //   the edges of the BDD package, which hold 2^31 nodes.
+  const int gMaxPkgSizeMB = ((UINT_MAX >> 1) + 1) / 30000 - 1;
+  // Relations as ZDDs.
+  bool gZdd = false;        // Default: BDDs.
 
   // Handle command line options.
+  //   Long options have no short form, their values are beyond char.
+  const int lOptStats = 256;
+  const int lOptProfile = 257;
+  const int lOptTrace = 258;
+  const int lOptZdd = 259;
+  static const struct option lLongOptions[] = {
+    { "stats",   no_argument,       NULL, lOptStats },
+    { "profile", no_argument,       NULL, lOptProfile },
+    { "trace",   required_argument, NULL, lOptTrace },
+    { "zdd",     no_argument,       NULL, lOptZdd },
+    { NULL,      0,                 NULL, 0 }
+  };
   int c;
-  while ( (c = getopt(argc, argv, "ehl:m:qv")) != -1 ) {
+  while ( (c = getopt_long(argc, argv, "c:ehi:j:l:m:M:o:qr:vw:", 
+                           lLongOptions, NULL)) != -1 ) {
     switch (c) {
+    case 'c':
+      // Cache replacement policy.
+      if (string(optarg) == "lru") {
+        gCachePolicy = LRU;
+      } else if (string(optarg) == "fifo") {
+        gCachePolicy = FIFO;
+      } else {
+        cerr << "Error: Unknown cache policy '" << optarg << "'." << endl;
+        exit(EXIT_FAILURE);
+      }
+      break;
     case 'e':
       // No input data.
       gDataInStream = NULL;
@@ -347,24 +839,77 @@ crocopat(int argc, char *argv [])
     case 'h':
       printHelp();
       exit(EXIT_SUCCESS);
+    case 'i':
+      // Input data snapshot.
+      gSnapshotInName = new string(optarg);
+      break;
+    case 'j':
+      // Number of threads.
+      gThreadNr = parseNumberOption(c, optarg, gMaxThreadNr);
+      break;
     case 'l':
       // Library file needs to be parsed.
       gLibFileName = new string(optarg);
       break;
     case 'm':
       // Memory size for BDD package.
-      gBddPkgSizeMB = atoi(optarg);
-      assert(gBddPkgSizeMB > 0);
+      gBddPkgSizeMB = parseNumberOption(c, optarg, gMaxPkgSizeMB);
+      break;
+    case 'M':
+      // Memory limit for BDD package.
+      gBddPkgMaxSizeMB = parseNumberOption(c, optarg, gMaxPkgSizeMB);
+      break;
+    case 'o':
+      // Variable order file.
+      gOrderFileName = new string(optarg);
       break;
     case 'q':   
       gPrintWarnings = false;
       break;
+    case 'r':
+      // Threshold for automatic reordering.
+      gReorderNodeNr = parseNumberOption(c, optarg, INT_MAX);
+      break;
     case 'v':   
       printVersion();
       exit(EXIT_SUCCESS);
+    case 'w':
+      // Snapshot of the input data.
+      gSnapshotOutName = new string(optarg);
+      break;
+    case lOptStats:
+      // Statistics of the BDD package.
+      gPrintStats = true;
+      atexit(&printStats);
+      break;
+    case lOptProfile:
+      // Profile of the RML program.
+      gProfile = true;
+      atexit(&printProfile);
+      break;
+    case lOptTrace:
+      // Timeline of the run.
+      relTrace::close();
+      if (!relTrace::open(optarg)) {
+        cerr << "Error: Cannot write trace file '" << optarg << "'." << endl;
+        exit(EXIT_FAILURE);
+      }
+      atexit(&closeTrace);
+      break;
+    case lOptZdd:
+      // Relations as ZDDs.
+      gZdd = true;
+      break;
     }
   }
 
+  // Snapshots contain BDDs.
+  if (gZdd  &&  (gSnapshotInName != NULL  ||  gSnapshotOutName != NULL)) {
+    cerr << "Error: Option --zdd cannot be combined with snapshots "
+         << "(options -i and -w)." << endl;
+    exit(EXIT_FAILURE);
+  }
+
   
   // If no program file is given, print help text.
   if (optind >= argc) {
@@ -396,15 +941,46 @@ crocopat(int argc, char *argv [])
     for( unsigned i = 0; i < gAttributeNum; ++i) {
       gSymTab->addAttribute( gAttributePrefix + unsigned2string(i) ); 
     }
+    // Variable order of a previous run.
+    if (gOrderFileName != NULL) {
+      ifstream lOrderStream(gOrderFileName->c_str(), ios::in);
+      vector<string> lOrder;
+      string lAttribute;
+      while (lOrderStream >> lAttribute) {
+        lOrder.push_back(lAttribute);
+      }
+      gSymTab->setAttributeOrder(lOrder);
+    }
   }
   // Initialize BDD package.
   {
-    // Default: ca. 2000000 BDD nodes (50 MB);
+    // Default: ca. 120000 BDD nodes (4 MB), growing on demand;
     //unsigned lNrNodes  = gBddPkgSizeMB * (1024 * 1024) / 36;
-    unsigned lNrNodes  = gBddPkgSizeMB * 30000;
+    unsigned lNrNodes  = (unsigned) gBddPkgSizeMB * 30000u;
     unsigned lHashSize = (unsigned) ( log((float)lNrNodes) / log(2.0) );
+    // Limit: Same ratio of nodes per MB. Only the node table is limited,
+    //   the caches and the unique table grow in proportion.
+    unsigned lMaxNrNodes = (unsigned) gBddPkgMaxSizeMB * 30000u;
+    if (lMaxNrNodes != 0  &&  lMaxNrNodes < lNrNodes) {
+      lMaxNrNodes = lNrNodes;
+    }
+    if (gZdd) {
+      // Relations as ZDDs. The BDD package only converts them 
+      //   for output, with the default size.
+      bddZdd::init(lNrNodes, lHashSize, lHashSize, lHashSize - 4, lMaxNrNodes);
+      lNrNodes = 4 * 30000;
+      lHashSize = (unsigned) ( log((float)lNrNodes) / log(2.0) );
+      lMaxNrNodes = 0;
+      gReorderNodeNr = 0;
+    }
     // Initialize BDD package.
-    bddBdd::init(lNrNodes, lHashSize, lHashSize, lHashSize - 4);
+    bddBdd::init(lNrNodes, lHashSize, lHashSize, lHashSize - 4, lMaxNrNodes);
+    bddBdd::setReorderThreshold(gReorderNodeNr);
+    bddBdd::setCachePolicy(gCachePolicy);
+    if (!bddBdd::setThreadNr(gThreadNr)) {
+      cerr << "Error: Cannot create " << gThreadNr << " threads." << endl;
+      exit(EXIT_FAILURE);
+    }
   }
   // Declare predefined (internal or constant) variables.
   {
@@ -427,14 +1003,22 @@ crocopat(int argc, char *argv [])
 
   {
     vector< vector<string> > lRelationVector;
+    snapshotData lSnapshot;
 
-    // Read relation from data input stream.
-    if (gDataInStream != NULL) {  // NULL pointer means don't read any input data.
+    // Read relation from snapshot or data input stream.
+    if (gSnapshotInName != NULL) {
+      relTrace::begin("readSnapshot", "load");
+      readSnapshot(*gSnapshotInName, lSnapshot);
+      relTrace::end();
+    } else if (gDataInStream != NULL) {  // NULL pointer means don't read any input data.
+      relTrace::begin("file2vector", "load");
       file2vector(*gDataInStream, lRelationVector);
+      relTrace::end();
     }
 
 
     // Read syntax tree (program parser).
+    relTrace::begin("parse", "load");
     {
       // First read procedures from library, if necessary.
       if (gLibFileName != NULL) {
@@ -466,6 +1050,7 @@ crocopat(int argc, char *argv [])
       }
       lProgramStream.close();
     }
+    relTrace::end();
     // Now the syntax tree is contained in 'gSyntaxTree'.
 
 
@@ -473,12 +1058,35 @@ crocopat(int argc, char *argv [])
     gSymTab->initValueUniverse(gValueUniverse);
 
     // Transform relation from vector to BDD representation.
-    createBddRelation(lRelationVector);
+    //   Remember the greatest number of elements of the tuples.
+    map<string, unsigned> lWidths;
+    if (gSnapshotInName != NULL) {
+      relTrace::begin("createSnapshotRelations", "load");
+      createSnapshotRelations(*gSnapshotInName, lSnapshot, lWidths);
+      relTrace::end();
+    } else {
+      relTrace::begin("createBddRelation", "load");
+      createBddRelation(lRelationVector);
+      relTrace::end();
+      for (unsigned i = 0; i < lRelationVector.size(); ++i) {
+        if (lRelationVector[i].size() != 0) {
+          unsigned& lWidth = lWidths[lRelationVector[i][0]];
+          lWidth = max(lWidth, (unsigned) lRelationVector[i].size() - 1);
+        }
+      }
+    }
     // Now all relations are assigned to relational variables.
+
+    if (gSnapshotOutName != NULL) {
+      relTrace::begin("writeSnapshot", "load");
+      writeSnapshot(*gSnapshotOutName, lWidths);
+      relTrace::end();
+    }
   }
 
 
   // Initialize predefined constant relations.
+  relTrace::begin("predefined relations", "load");
   {
     delete gVariables["="];
     delete gVariables["!="];
@@ -514,8 +1122,16 @@ crocopat(int argc, char *argv [])
     gVariables[">="]    = new bddRelationConst(lRelTmp);
   }
 
+  relTrace::end();
+
+  // Input relations and constants live long: 
+  //   Keep them out of the scans of minor garbage collections.
+  bddBdd::promoteAll();
+
   // Interpret syntax tree.
+  relTrace::begin("interpret", "program");
   gSyntaxTree->interpret(gSymTab);
+  relTrace::end();
 
 
   // Free memory.
@@ -544,13 +1160,27 @@ crocopat(int argc, char *argv [])
     gVariables.clear();
     
     // Free syntax tree.
+    printProfile();
     delete gSyntaxTree;
+    relProfiler::clear();
     
     // Uninitialize BDD storage.
+    printStats();
+    closeTrace();
     bddBdd::done();
+    if (bddZdd::isActive()) {
+      bddZdd::done();
+    }
 
     // Free symbol table.
     delete gSymTab;
+
+    delete gOrderFileName;
+    gOrderFileName = NULL;
+    delete gSnapshotInName;
+    gSnapshotInName = NULL;
+    delete gSnapshotOutName;
+    gSnapshotOutName = NULL;
   }
 
   // For controlling deallocation.
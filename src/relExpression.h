@@ -33,6 +33,7 @@
 
 #include "bddRelation.h"
 #include "relTerm.h"
+#include "relProfile.h"
 
 #include <string>
 #include <fstream>
@@ -55,12 +56,185 @@ extern bool             gPrintWarnings;
 //////////////////////////////////////////////////////////////////////////////
 class relExpression : public relObject
 {
+private:
+  /// Line of the expression in the RML program (0 if unknown).
+  unsigned mLine;
+
 public:
+  relExpression()
+    : mLine(0)
+  {}
+
+  unsigned
+  getLine() const
+  {
+    return mLine;
+  }
+
+  void
+  setLine(unsigned pLine)
+  {
+    mLine = pLine;
+  }
+
   virtual set<string>
   collectFreeAttrs() = 0;
 
   virtual bddRelation
   interpret(bddSymTab* pSymTab) = 0;
+
+  /// Describes the expression without its subexpressions in the plan 
+  ///   of EXPLAIN, e.g., "&" or "CALL(x, _)". 
+  ///   Empty for wrappers (e.g., relExprProfile), which are not shown.
+  virtual string
+  getExplainLabel(bddSymTab* pSymTab) = 0;
+
+  /// Returns the places of the relational subexpressions,
+  ///   where EXPLAIN ANALYZE puts its measuring wrappers.
+  virtual vector<relExpression**>
+  getSubExprs()
+  {
+    return vector<relExpression**>();
+  }
+
+  /// Adds the attributes of the expression to the symbol table
+  ///   in the same order as the interpretation, for EXPLAIN.
+  virtual void
+  addAttributes(bddSymTab* pSymTab)
+  {
+    vector<relExpression**> lSubExprs = getSubExprs();
+    for (unsigned i = 0; i < lSubExprs.size(); ++i) {
+      (*lSubExprs[i])->addAttributes(pSymTab);
+    }
+  }
+
+  /// Interprets the expression and quantifies existentially 
+  ///   the free attributes (pAttributes) of the result.
+  /// Overridden by expressions that can combine both in one BDD pass.
+  virtual bddRelation
+  interpretExists(bddSymTab* pSymTab, const set<string>& pAttributes)
+  {
+    bddRelation result( interpret(pSymTab) );
+    result.exists(pAttributes);
+    return result;
+  }
+
+protected:
+  /// Returns the terms for EXPLAIN, e.g., "x, _, \"main\"".
+  static string
+  explainTerms(const vector<relTerm*>* pTermList, bddSymTab* pSymTab)
+  {
+    string result;
+    for(unsigned i = 0; i < pTermList->size(); ++i) {
+      if (i > 0) {
+        result += ", ";
+      }
+      relTerm* lTerm = (*pTermList)[i];
+      if (dynamic_cast<relTermExists*>(lTerm) != NULL) {
+        result += "_";
+      } else if (dynamic_cast<relTermStrExpr*>(lTerm) != NULL) {
+        result += "\"" + lTerm->interpret(pSymTab) + "\"";
+      } else {
+        result += lTerm->interpret(pSymTab);
+      }
+    }
+    return result;
+  }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// Profiled expression (option --profile): Measures the interpretations 
+///   of the wrapped expression, and the sizes of their results.
+class relExprProfile : public relExpression
+{
+private:
+  relExpression*   mExpr;
+  relProfileEntry* mEntry;
+  /// False for the temporary wrappers of EXPLAIN ANALYZE.
+  bool             mOwnsExpr;
+
+  /// Adds the sizes of (pResult) to the entry. (pQuantified) are the 
+  ///   quantified free attributes, the others are attributes of the result.
+  void
+  addResult(const bddRelation& pResult, const set<string>& pQuantified)
+  {
+    relProfileOverhead lOverhead;
+    set<string> lFree = mExpr->collectFreeAttrs();
+    for( set<string>::const_iterator 
+         lIt = pQuantified.begin();
+         lIt != pQuantified.end();
+         ++lIt)
+    {
+      lFree.erase(*lIt);
+    }
+    mEntry->mHasResult = true;
+    mEntry->mResultNodeNr = max(mEntry->mResultNodeNr, pResult.getNodeNr());
+    mEntry->mResultTupleNr = max(mEntry->mResultTupleNr, 
+                                 pResult.getTupleNr(lFree));
+  }
+
+public:
+  relExprProfile(relExpression* pExpr, const string& pKind)
+    : mExpr(pExpr),
+      mEntry(relProfiler::newEntry(pKind, pExpr->getLine())),
+      mOwnsExpr(true)
+  {
+    setLine(pExpr->getLine());
+  }
+
+  /// Measures into (pEntry), without owning (pExpr) (for EXPLAIN ANALYZE).
+  relExprProfile(relExpression* pExpr, relProfileEntry* pEntry)
+    : mExpr(pExpr),
+      mEntry(pEntry),
+      mOwnsExpr(false)
+  {
+    setLine(pExpr->getLine());
+  }
+
+  ~relExprProfile()
+  {
+    if (mOwnsExpr) {
+      delete mExpr;
+    }
+  }
+
+  virtual set<string>
+  collectFreeAttrs()
+  {
+    return mExpr->collectFreeAttrs();
+  }
+
+  virtual string
+  getExplainLabel(bddSymTab*)
+  {
+    return "";
+  }
+
+  virtual vector<relExpression**>
+  getSubExprs()
+  {
+    return vector<relExpression**>(1, &mExpr);
+  }
+
+  virtual bddRelation
+  interpret(bddSymTab* pSymTab)
+  {
+    relProfileScope lScope(mEntry);
+    bddRelation result( mExpr->interpret(pSymTab) );
+    lScope.stop();
+    addResult(result, set<string>());
+    return result;
+  }
+
+  virtual bddRelation
+  interpretExists(bddSymTab* pSymTab, const set<string>& pAttributes)
+  {
+    relProfileScope lScope(mEntry);
+    bddRelation result( mExpr->interpretExists(pSymTab, pAttributes) );
+    lScope.stop();
+    addResult(result, pAttributes);
+    return result;
+  }
 };
 
 //////////////////////////////////////////////////////////////////////////////
@@ -105,8 +279,14 @@ public:
     return result;
   }
 
-  virtual bddRelation
-  interpret(bddSymTab* pSymTab)
+  virtual string
+  getExplainLabel(bddSymTab* pSymTab)
+  {
+    return *mRelVar + "(" + explainTerms(mTermList, pSymTab) + ")";
+  }
+
+  virtual void
+  addAttributes(bddSymTab* pSymTab)
   {
     // Add attributes to SymTab, if new.
     //   From top to bottom is important to get the right variable order.
@@ -117,6 +297,12 @@ public:
         pSymTab->addAttribute( (*mTermList)[i]->interpret(pSymTab) ); 
       }
     }
+  }
+
+  virtual bddRelation
+  interpret(bddSymTab* pSymTab)
+  {
+    addAttributes(pSymTab);
     
     // Warnings and return for unknown strings.
     for(unsigned i = 0; i < mTermList->size(); ++i) {
@@ -181,45 +367,53 @@ public:
       }
     }
 
-    // Quantify or intersect with value.
-    //   Ordering: From bottom to top, for efficiency.
-    for(int i = lTermList.size()-1; i >= 0; --i)
+    // Quantify or select the cofactor of the value.
+    set<string> lQuantified;
+    map<string, string> lValues;
+    for(unsigned i = 0; i < lTermList.size(); ++i)
     {
       string lTerm = lTermList[i]->interpret(pSymTab);
       if (dynamic_cast<relTermExists*>(lTermList[i]) != NULL)
       {
         // Quantification.
-        result.exists(gAttributePrefix + unsigned2string(i));
+        lQuantified.insert(gAttributePrefix + unsigned2string(i));
       }
       else if (dynamic_cast<relTermStrExpr*>(lTermList[i]) != NULL)
       {
         // lTerm is a string (constant) and exists in symtab (checked above).
-        result.intersect(bddRelation::mkAttributeValue(
-                                                       pSymTab, 
-                                                       gAttributePrefix + unsigned2string(i), 
-                                                       lTerm)
-                         );
-        result.exists(gAttributePrefix + unsigned2string(i)); 
+        lValues[gAttributePrefix + unsigned2string(i)] = lTerm;
       }
     }
+    if (!lValues.empty())
+    {
+      result.restrict(lValues);
+    }
+    if (!lQuantified.empty())
+    {
+      result.exists(lQuantified);
+    }
 
-    // Rename internal attributes to the given user attributes.
-    //   Ordering: From bottom to top, for efficiency.
-    for(int i = lTermList.size()-1; i >= 0; --i)
+    // Rename internal attributes to the given user attributes,
+    //   all in one pass.
+    map<string, string> lRenaming;
+    for(unsigned i = 0; i < lTermList.size(); ++i)
     {
       string lTerm = lTermList[i]->interpret(pSymTab);
       if (dynamic_cast<relTermAttribute*>(lTermList[i]) != NULL)
       {
         // lTerm is an attribute.
-        // Rename.
-        result.rename(gAttributePrefix + unsigned2string(i), lTerm);
+        lRenaming[gAttributePrefix + unsigned2string(i)] = lTerm;
       }
     }
+    result.rename(lRenaming);
     
     // Check if the arity of the stored relation was greater than
     //   the number of terms by looking for BDD nodes of internal attributes.
-    if ( result.testVars(gAttributePrefix + unsigned2string(0),
-                         gAttributePrefix + unsigned2string(gAttributeNum-1)) ) {
+    //   The internal attributes occupy the first (gAttributeNum) positions,
+    //   in any order (cf. bddRelation::reorder()).
+    if ( result.testVars(pSymTab->getAttributeAtPos(0),
+                         pSymTab->getAttributeAtPos((gAttributeNum-1) 
+                                                    * pSymTab->getBitNr())) ) {
       cerr << "Error: The arity of relation '" << *mRelVar 
            << "' is greater than the number of terms." << endl;
       exit(EXIT_FAILURE);
@@ -258,6 +452,12 @@ public:
     return result;
   }
 
+  virtual string
+  getExplainLabel(bddSymTab*)
+  {
+    return "(number) " + *mRelSym + " (number)";
+  }
+
   virtual bddRelation
   interpret(bddSymTab* pSymTab)
   {
@@ -282,7 +482,7 @@ public:
 //////////////////////////////////////////////////////////////////////////////
 class relExprExists : public relExpression
 {
-private:
+protected:
   vector<relTerm*>* mTermList;
   relExpression*    mExpr;
 
@@ -321,11 +521,14 @@ public:
     return result;
   }
 
-  virtual bddRelation
-  interpret(bddSymTab* pSymTab)
+protected:
+  /// Returns the attributes to quantify, i.e., the free attributes 
+  ///   of the subexpression in the term list. Reports all other terms.
+  set<string>
+  collectQuantAttrs(bddSymTab* pSymTab)
   {
-    bddRelation result( mExpr->interpret(pSymTab) );
     const set<string> lFree = mExpr->collectFreeAttrs();
+    set<string> result;
     for( vector<relTerm*>::iterator 
          lIt = mTermList->begin();
          lIt != mTermList->end();
@@ -340,11 +543,57 @@ public:
              << "Attribute '" << lAttr 
              << "' does not occur free in the expression." << endl;
       } else {
-        result.exists(lAttr);
+        result.insert(lAttr);
       }
     }
     return result;
   }
+
+public:
+  virtual string
+  getExplainLabel(bddSymTab* pSymTab)
+  {
+    return "EX(" + explainTerms(mTermList, pSymTab) + ")";
+  }
+
+  virtual vector<relExpression**>
+  getSubExprs()
+  {
+    return vector<relExpression**>(1, &mExpr);
+  }
+
+  virtual bddRelation
+  interpret(bddSymTab* pSymTab)
+  {
+    const set<string> lAttributes = collectQuantAttrs(pSymTab);
+    // The subexpression may fuse the quantification 
+    //   with its last operation (e.g., relational product for AND).
+    return mExpr->interpretExists(pSymTab, lAttributes);
+  }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+class relExprForall : public relExprExists
+{
+public:
+  relExprForall(vector<relTerm*>* pTermList, relExpression* pExpr)
+    : relExprExists(pTermList, pExpr)
+  {}
+
+  virtual string
+  getExplainLabel(bddSymTab* pSymTab)
+  {
+    return "FA(" + explainTerms(mTermList, pSymTab) + ")";
+  }
+
+  virtual bddRelation
+  interpret(bddSymTab* pSymTab)
+  {
+    const set<string> lAttributes = collectQuantAttrs(pSymTab);
+    bddRelation result( mExpr->interpret(pSymTab) );
+    result.forall(lAttributes);
+    return result;
+  }
 };
 
 //////////////////////////////////////////////////////////////////////////////
@@ -369,6 +618,18 @@ public:
         return mExpr->collectFreeAttrs();
   }
 
+  virtual string
+  getExplainLabel(bddSymTab*)
+  {
+    return "!";
+  }
+
+  virtual vector<relExpression**>
+  getSubExprs()
+  {
+    return vector<relExpression**>(1, &mExpr);
+  }
+
   virtual bddRelation
   interpret(bddSymTab* pSymTab)
   {
@@ -406,6 +667,21 @@ public:
         return result;
   }
 
+  virtual string
+  getExplainLabel(bddSymTab*)
+  {
+    return "&";
+  }
+
+  virtual vector<relExpression**>
+  getSubExprs()
+  {
+    vector<relExpression**> result;
+    result.push_back(&mExpr1);
+    result.push_back(&mExpr2);
+    return result;
+  }
+
   virtual bddRelation
   interpret(bddSymTab* pSymTab)
   {
@@ -413,6 +689,15 @@ public:
     result.intersect( mExpr2->interpret(pSymTab) );
     return result;
   }
+
+  /// Relational product, without building the intersection.
+  virtual bddRelation
+  interpretExists(bddSymTab* pSymTab, const set<string>& pAttributes)
+  {
+    bddRelation result( mExpr1->interpret(pSymTab) );
+    result.intersectExists( mExpr2->interpret(pSymTab), pAttributes );
+    return result;
+  }
 };
 
 //////////////////////////////////////////////////////////////////////////////
@@ -443,6 +728,21 @@ public:
         return result;
   }
 
+  virtual string
+  getExplainLabel(bddSymTab*)
+  {
+    return "|";
+  }
+
+  virtual vector<relExpression**>
+  getSubExprs()
+  {
+    vector<relExpression**> result;
+    result.push_back(&mExpr1);
+    result.push_back(&mExpr2);
+    return result;
+  }
+
   virtual bddRelation
   interpret(bddSymTab* pSymTab)
   {
@@ -452,6 +752,59 @@ public:
   }
 };
 
+//////////////////////////////////////////////////////////////////////////////
+class relExprImplies : public relExpression
+{
+private:
+  relExpression* mExpr1;
+  relExpression* mExpr2;
+
+public:
+  relExprImplies(relExpression* pExpr1, relExpression* pExpr2)
+    : mExpr1(pExpr1),
+      mExpr2(pExpr2)
+  {}
+
+  ~relExprImplies()
+  {
+    delete mExpr1;
+    delete mExpr2;
+  }
+
+  virtual set<string>
+  collectFreeAttrs()
+  {
+        set<string> result = mExpr1->collectFreeAttrs();
+        set<string> tmp    = mExpr2->collectFreeAttrs();
+        result.insert(tmp.begin(), tmp.end());
+        return result;
+  }
+
+  virtual string
+  getExplainLabel(bddSymTab*)
+  {
+    return "->";
+  }
+
+  virtual vector<relExpression**>
+  getSubExprs()
+  {
+    vector<relExpression**> result;
+    result.push_back(&mExpr1);
+    result.push_back(&mExpr2);
+    return result;
+  }
+
+  virtual bddRelation
+  interpret(bddSymTab* pSymTab)
+  {
+    // NOT(expr1) OR expr2.
+    bddRelation result( mExpr1->interpret(pSymTab) );
+    result.implication( mExpr2->interpret(pSymTab) );
+    return result;
+  }
+};
+
 //////////////////////////////////////////////////////////////////////////////
 class relExprEquiv : public relExpression
 {
@@ -480,18 +833,27 @@ public:
         return result;
   }
 
+  virtual string
+  getExplainLabel(bddSymTab*)
+  {
+    return "<->";
+  }
+
+  virtual vector<relExpression**>
+  getSubExprs()
+  {
+    vector<relExpression**> result;
+    result.push_back(&mExpr1);
+    result.push_back(&mExpr2);
+    return result;
+  }
+
   virtual bddRelation
   interpret(bddSymTab* pSymTab)
   {
-    // (expr1 AND expr2) OR NOT(expr1 OR expr2).
-    bddRelation lExpr1 = mExpr1->interpret(pSymTab);
-    bddRelation lExpr2 = mExpr2->interpret(pSymTab);
-    bddRelation lIntersect = lExpr1;
-    lIntersect.intersect(lExpr2);
-    bddRelation result = lExpr1;
-    result.unite(lExpr2);
-    result.complement();
-    result.unite(lIntersect);
+    // (expr1 AND expr2) OR NOT(expr1 OR expr2), in one BDD pass.
+    bddRelation result( mExpr1->interpret(pSymTab) );
+    result.equivalence( mExpr2->interpret(pSymTab) );
     return result;
   }
 };
@@ -524,6 +886,26 @@ public:
         return mExpr->collectFreeAttrs();
   }
 
+  virtual string
+  getExplainLabel(bddSymTab*)
+  {
+    return (mAlg == EXPTRAVERS) ? "TCFAST" : "TC";
+  }
+
+  virtual vector<relExpression**>
+  getSubExprs()
+  {
+    return vector<relExpression**>(1, &mExpr);
+  }
+
+  virtual void
+  addAttributes(bddSymTab* pSymTab)
+  {
+    mExpr->addAttributes(pSymTab);
+    // The temporary attribute of interpret().
+    pSymTab->addAttribute(".INTERNAL_TMPATTR.");
+  }
+
   // Side effect: Adds a symbol to the symbol table.
   virtual bddRelation
   interpret(bddSymTab* pSymTab)
@@ -629,6 +1011,8 @@ public:
     { // Main Part.
         // Variation 0 (for minimal time consumption)
         // Iteration to compute fixed point.
+        set<string> lQuantAttrs;
+        lQuantAttrs.insert(lAttributeY);
         bddRelation lPrevRel(pSymTab, false);
         while( ! lPrevRel.setEqual(result) )
         {
@@ -639,9 +1023,8 @@ public:
           lTmpRel.rename(lAttributeY, tmpAttr);       // R(X, TMPATTR).
           lTmpRel.rename(lAttributeX, lAttributeY);   // R(Y, TMPATTR).
           
-          // Step.
-          result.intersect(lTmpRel);                  // R(X, Y, TMPATTR).
-          result.exists(lAttributeY);                 // R(X, TMPATTR).
+          // Step: Relational product, R(X, Y, TMPATTR) is never built.
+          result.intersectExists(lTmpRel, lQuantAttrs);  // R(X, TMPATTR).
           result.rename(tmpAttr, lAttributeY);        // R(X, Y).
           
           result.unite( lPrevRel );
@@ -732,23 +1115,25 @@ public:
       lValuesY.rename(lAttributeY, lAttributeX);
       lValuesX.intersect(lValuesY);
       const unsigned lVarId = pSymTab->getAttributePos(lAttributeX);
+      set<string> lQuantAttrs;
+      lQuantAttrs.insert(lAttributeX);
       // For all elements of the set lValueX.
-      while (!lValuesX.isEmpty()) {
+      for (bddTupleCursor lCursor = lValuesX.getTuples(lVarId);
+           lCursor.isValid();
+           lCursor.next()) {
             // Get next value of the attribute.
-            string lValue = lValuesX.getElement(lVarId);
+            string lValue = pSymTab->getAttributeValue(lCursor.getTuple()[0]);
             // Compute cofactor for current value in (lTmpRel).
             bddRelation lCurrentValue( bddRelation::mkAttributeValue(pSymTab, lAttributeX, lValue) );
     
 
         bddRelation lStartNodesY(lInvResult);
-        lStartNodesY.intersect(lCurrentValue);
-        lStartNodesY.exists(lAttributeX);
+        lStartNodesY.intersectExists(lCurrentValue, lQuantAttrs);
         bddRelation lStartNodesX(lStartNodesY);
         lStartNodesX.rename(lAttributeY, lAttributeX);
 
         bddRelation lEndNodesY(result);
-        lEndNodesY.intersect(lCurrentValue);
-        lEndNodesY.exists(lAttributeX);
+        lEndNodesY.intersectExists(lCurrentValue, lQuantAttrs);
         bddRelation lEndNodesX(lEndNodesY);
         lEndNodesX.rename(lAttributeY, lAttributeX);
             
@@ -757,11 +1142,6 @@ public:
 
         result.unite(lStartNodesX);
         lInvResult.unite(lEndNodesX);
-
-
-            // Delete current element from set.
-            lCurrentValue.complement();
-            lValuesX.intersect(lCurrentValue);
       }
     }
 
@@ -801,6 +1181,21 @@ public:
     return result;
   }
 
+  virtual string
+  getExplainLabel(bddSymTab*)
+  {
+    return "(set) " + *mRelOp + " (set)";
+  }
+
+  virtual vector<relExpression**>
+  getSubExprs()
+  {
+    vector<relExpression**> result;
+    result.push_back(&mExpr1);
+    result.push_back(&mExpr2);
+    return result;
+  }
+
   virtual bddRelation
   interpret(bddSymTab* pSymTab)
   {
@@ -855,6 +1250,22 @@ public:
     return result;
   }
   
+  virtual string
+  getExplainLabel(bddSymTab* pSymTab)
+  {
+    const vector<relTerm*> lTerms(1, mTerm);
+    return "@\"" + mRegExString->interpret(pSymTab).getValue() + "\"(" 
+      + explainTerms(&lTerms, pSymTab) + ")";
+  }
+
+  virtual void
+  addAttributes(bddSymTab* pSymTab)
+  {
+    if (dynamic_cast<relTermAttribute*>(mTerm) != NULL) {
+      pSymTab->addAttribute(mTerm->interpret(pSymTab));
+    }
+  }
+
   /// Error handling for regex operation.
   void 
   errorproc(int pErrorCode, 
@@ -994,6 +1405,18 @@ public:
         return mExpr->collectFreeAttrs();
   }
 
+  virtual string
+  getExplainLabel(bddSymTab*)
+  {
+    return "TUPLEOF";
+  }
+
+  virtual vector<relExpression**>
+  getSubExprs()
+  {
+    return vector<relExpression**>(1, &mExpr);
+  }
+
   virtual bddRelation
   interpret(bddSymTab* pSymTab)
   {
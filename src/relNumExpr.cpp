@@ -77,23 +77,15 @@ relNumExprUnOp::interpret(bddSymTab* pSymTab)
   double lMin  = DBL_MAX;
   double lMax  = -DBL_MAX;
   // For all elements of the set (all values for attribute lAttribute).
-  while (!lRel.isEmpty()) {
-    // Get next value of the attribute.
-    string lValue = lRel.getElement(lVarId);
+  for (bddTupleCursor lCursor = lRel.getTuples(lVarId);
+       lCursor.isValid();
+       lCursor.next()) {
+    string lValue = pSymTab->getAttributeValue(lCursor.getTuple()[0]);
     double lNumValue = string2double(lValue);
     lSum += lNumValue;
     ++lCard;
     lMin = min(lMin, lNumValue);
     lMax = max(lMax, lNumValue);
-    
-    // Compute cofactor for current value in (lTmpRel).
-    bddRelation lCurrentValue( 
-                  bddRelation::mkEqual(pSymTab, 
-                                       lVarId, 
-                                       pSymTab->getValueNum(lValue)) );
-    // Delete current element from set.
-    lCurrentValue.complement();  
-    lRel.intersect(lCurrentValue);
   }
 
   if (mOp == MIN)       result.setValue( lMin );
@@ -0,0 +1,245 @@
+/*
+ * CrocoPat is a tool for relational programming.
+ * This file is part of CrocoPat. 
+ *
+ * Copyright (C) 2002-2008  Dirk Beyer
+ *
+ * CrocoPat is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * CrocoPat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with CrocoPat; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Please find the GNU Lesser General Public License in file
+ * License_LGPL.txt or at http://www.gnu.org/licenses/lgpl.txt
+ *
+ * Author:
+ * Dirk Beyer (firstname.lastname@sfu.ca)
+ * Simon Fraser University
+ *
+ * With contributions of: Andreas Noack, Michael Vogel
+ */
+
+#include "relProfile.h"
+#include "bddZdd.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sys/time.h>
+
+relProfileScope* relProfileScope::mCurrent = NULL;
+
+double        relProfileOverhead::mCpuTime   = 0;
+double        relProfileOverhead::mWallTime  = 0;
+unsigned long relProfileOverhead::mCreatedNr = 0;
+
+vector<relProfileEntry*> relProfiler::mEntries;
+
+//////////////////////////////////////////////////////////////////////////////
+/// Returns the real time in seconds.
+static double
+getWallTime()
+{
+  struct timeval lTime;
+  gettimeofday(&lTime, NULL);
+  return lTime.tv_sec + lTime.tv_usec / 1e6;
+}
+
+/// Returns the processor time in seconds since pStart.
+static double
+getCpuTime(clock_t pStart)
+{
+  return ((double) (clock() - pStart)) / CLOCKS_PER_SEC;
+}
+
+/// Returns the number of nodes created resp. the peak number of used nodes
+///   of the package that represents the relations (see option --zdd).
+static unsigned long
+getCreatedNodeNr()
+{
+  return bddZdd::isActive() ? bddZdd::getCreatedNodeNr() 
+                            : bddBdd::getCreatedNodeNr();
+}
+
+static unsigned
+getPeakNodeNr()
+{
+  return bddZdd::isActive() ? bddZdd::getPeakNodeNr() 
+                            : bddBdd::getPeakNodeNr();
+}
+
+/// Restarts the measurement of getPeakNodeNr().
+static void
+resetPeakNodeNr(unsigned pNodeNr = 0)
+{
+  if (bddZdd::isActive()) {
+    bddZdd::resetPeakNodeNr(pNodeNr);
+  } else {
+    bddBdd::resetPeakNodeNr(pNodeNr);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+relProfileScope::relProfileScope(relProfileEntry* pEntry)
+  : mEntry(pEntry),
+    mParent(mCurrent),
+    mCpuStart(clock()),
+    mWallStart(getWallTime()),
+    mCreatedStart(getCreatedNodeNr()),
+    mOuterPeakNr(getPeakNodeNr()),
+    mChildCpuTime(0),
+    mOverheadCpuStart(relProfileOverhead::mCpuTime),
+    mOverheadWallStart(relProfileOverhead::mWallTime),
+    mOverheadCreatedStart(relProfileOverhead::mCreatedNr),
+    mStopped(false)
+{
+  resetPeakNodeNr();
+  ++mEntry->mActiveNr;
+  mCurrent = this;
+}
+
+relProfileScope::~relProfileScope()
+{
+  stop();
+}
+
+void
+relProfileScope::stop()
+{
+  if (mStopped) {
+    return;
+  }
+  mStopped = true;
+
+  const double lCpuTime = getCpuTime(mCpuStart)
+    - (relProfileOverhead::mCpuTime - mOverheadCpuStart);
+  const double lWallTime = getWallTime() - mWallStart
+    - (relProfileOverhead::mWallTime - mOverheadWallStart);
+  const unsigned long lCreatedNr = getCreatedNodeNr() - mCreatedStart
+    - (relProfileOverhead::mCreatedNr - mOverheadCreatedStart);
+  // The enclosing scope continues with the maximum of both peaks.
+  const unsigned lPeakNr = getPeakNodeNr();
+  resetPeakNodeNr(max(mOuterPeakNr, lPeakNr));
+
+  ++mEntry->mCallNr;
+  --mEntry->mActiveNr;
+  // Recursive interpretations are contained in the outermost one.
+  if (mEntry->mActiveNr == 0) {
+    mEntry->mCpuTime   += lCpuTime;
+    mEntry->mWallTime  += lWallTime;
+    mEntry->mCreatedNr += lCreatedNr;
+  }
+  mEntry->mSelfCpuTime += lCpuTime - mChildCpuTime;
+  mEntry->mPeakNr = max(mEntry->mPeakNr, lPeakNr);
+
+  if (mParent != NULL) {
+    mParent->mChildCpuTime += lCpuTime;
+  }
+  mCurrent = mParent;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+relProfileOverhead::relProfileOverhead()
+  : mCpuStart(clock()),
+    mWallStart(getWallTime()),
+    mCreatedStart(getCreatedNodeNr())
+{}
+
+relProfileOverhead::~relProfileOverhead()
+{
+  mCpuTime   += getCpuTime(mCpuStart);
+  mWallTime  += getWallTime() - mWallStart;
+  mCreatedNr += getCreatedNodeNr() - mCreatedStart;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+relProfileEntry*
+relProfiler::newEntry(const string& pKind, unsigned pLine)
+{
+  mEntries.push_back(new relProfileEntry(pKind, pLine));
+  return mEntries.back();
+}
+
+/// Order of the report: Most expensive first, then by line.
+static bool
+costlier(const relProfileEntry* pEntry1, const relProfileEntry* pEntry2)
+{
+  if (pEntry1->mSelfCpuTime != pEntry2->mSelfCpuTime) {
+    return pEntry1->mSelfCpuTime > pEntry2->mSelfCpuTime;
+  }
+  if (pEntry1->mCpuTime != pEntry2->mCpuTime) {
+    return pEntry1->mCpuTime > pEntry2->mCpuTime;
+  }
+  return pEntry1->mLine < pEntry2->mLine;
+}
+
+void
+relProfiler::printReport(ostream& pS)
+{
+  vector<relProfileEntry*> lEntries;
+  for (vector<relProfileEntry*>::const_iterator lIt = mEntries.begin();
+       lIt != mEntries.end();
+       ++lIt) {
+    if ((*lIt)->mCallNr > 0) {
+      lEntries.push_back(*lIt);
+    }
+  }
+  stable_sort(lEntries.begin(), lEntries.end(), costlier);
+
+  const ios::fmtflags lFlags = pS.flags();
+  const streamsize lPrecision = pS.precision();
+  pS << "Profile (times in seconds, sorted by self processor time):" << endl
+     << setw(6)  << "line"
+     << setw(10) << "calls"
+     << setw(10) << "self"
+     << setw(10) << "total"
+     << setw(10) << "wall"
+     << setw(12) << "created"
+     << setw(10) << "peak"
+     << setw(10) << "nodes"
+     << setw(14) << "tuples"
+     << "  node" << endl;
+  for (vector<relProfileEntry*>::const_iterator lIt = lEntries.begin();
+       lIt != lEntries.end();
+       ++lIt) {
+    const relProfileEntry& lEntry = **lIt;
+    pS << fixed << setprecision(3)
+       << setw(6)  << lEntry.mLine
+       << setw(10) << lEntry.mCallNr
+       << setw(10) << lEntry.mSelfCpuTime
+       << setw(10) << lEntry.mCpuTime
+       << setw(10) << lEntry.mWallTime
+       << setw(12) << lEntry.mCreatedNr
+       << setw(10) << lEntry.mPeakNr;
+    if (lEntry.mHasResult) {
+      pS << setprecision(0)
+         << setw(10) << lEntry.mResultNodeNr
+         << setw(14) << lEntry.mResultTupleNr;
+    } else {
+      pS << setw(10) << "-"
+         << setw(14) << "-";
+    }
+    pS << "  " << lEntry.mKind << endl;
+  }
+  pS.flags(lFlags);
+  pS.precision(lPrecision);
+}
+
+void
+relProfiler::clear()
+{
+  for (vector<relProfileEntry*>::iterator lIt = mEntries.begin();
+       lIt != mEntries.end();
+       ++lIt) {
+    delete *lIt;
+  }
+  mEntries.clear();
+}
@@ -0,0 +1,172 @@
+/*
+ * CrocoPat is a tool for relational programming.
+ * This file is part of CrocoPat. 
+ *
+ * Copyright (C) 2002-2008  Dirk Beyer
+ *
+ * CrocoPat is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * CrocoPat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with CrocoPat; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Please find the GNU Lesser General Public License in file
+ * License_LGPL.txt or at http://www.gnu.org/licenses/lgpl.txt
+ *
+ * Author:
+ * Dirk Beyer (firstname.lastname@sfu.ca)
+ * Simon Fraser University
+ *
+ * With contributions of: Andreas Noack, Michael Vogel
+ */
+
+#ifndef _relProfile_h
+#define _relProfile_h
+
+#include "bddBdd.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <ctime>
+using namespace std;
+
+/// Global variable: True if the interpreter profiles the program
+///   (option --profile). Read by the parser, which then wraps the 
+///   statements and relational expressions (see relStmtProfile, 
+///   relExprProfile).
+extern bool gProfile;
+
+//////////////////////////////////////////////////////////////////////////////
+/// Measurements for one node of the syntax tree, 
+///   summed over all interpretations of the node.
+class relProfileEntry
+{
+public:
+  /// Description of the node, e.g., the operator.
+  string        mKind;
+  /// Line of the node in the RML program.
+  unsigned      mLine;
+  /// Number of interpretations.
+  unsigned long mCallNr;
+  /// Processor and real time in seconds, including the subnodes,
+  ///   and processor time without the profiled subnodes.
+  double        mCpuTime;
+  double        mWallTime;
+  double        mSelfCpuTime;
+  /// Number of BDD nodes created, including the subnodes.
+  unsigned long mCreatedNr;
+  /// Maximum number of used BDD nodes during an interpretation.
+  unsigned      mPeakNr;
+  /// True for expressions: Maximum numbers of BDD nodes and tuples 
+  ///   of a result.
+  bool          mHasResult;
+  unsigned      mResultNodeNr;
+  double        mResultTupleNr;
+  /// Number of running interpretations (more than one for recursion),
+  ///   such that recursive calls are counted only once in mCpuTime.
+  unsigned      mActiveNr;
+
+  relProfileEntry(const string& pKind, unsigned pLine)
+    : mKind(pKind),
+      mLine(pLine),
+      mCallNr(0),
+      mCpuTime(0),
+      mWallTime(0),
+      mSelfCpuTime(0),
+      mCreatedNr(0),
+      mPeakNr(0),
+      mHasResult(false),
+      mResultNodeNr(0),
+      mResultTupleNr(0),
+      mActiveNr(0)
+  {}
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// One interpretation of a profiled node: The constructor starts 
+///   the measurement, stop() ends it. Scopes nest like the interpretations,
+///   the innermost running scope is mCurrent.
+/// The costs of the profiler itself (see relProfileOverhead) 
+///   are excluded from the measurements.
+class relProfileScope
+{
+private:
+  relProfileEntry* mEntry;
+  relProfileScope* mParent;
+  clock_t          mCpuStart;
+  double           mWallStart;
+  unsigned long    mCreatedStart;
+  /// Peak of the enclosing scope before this one started.
+  unsigned         mOuterPeakNr;
+  /// Processor time of the subscopes, for the self time.
+  double           mChildCpuTime;
+  /// Overhead of the profiler at the start (see relProfileOverhead).
+  double           mOverheadCpuStart;
+  double           mOverheadWallStart;
+  unsigned long    mOverheadCreatedStart;
+  bool             mStopped;
+
+  static relProfileScope* mCurrent;
+
+public:
+  relProfileScope(relProfileEntry* pEntry);
+  ~relProfileScope();
+
+  void
+  stop();
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// Measures work that the profiler adds to the interpretation 
+///   (e.g., counting the tuples of results), which is subtracted 
+///   from the measurements of all running scopes.
+class relProfileOverhead
+{
+private:
+  clock_t       mCpuStart;
+  double        mWallStart;
+  unsigned long mCreatedStart;
+
+  friend class relProfileScope;
+  /// Overall overhead so far.
+  static double        mCpuTime;
+  static double        mWallTime;
+  static unsigned long mCreatedNr;
+
+public:
+  relProfileOverhead();
+  ~relProfileOverhead();
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// Registry of the entries of all profiled nodes.
+class relProfiler
+{
+private:
+  static vector<relProfileEntry*> mEntries;
+
+public:
+  /// Returns a new entry for a node, owned by the registry.
+  static relProfileEntry*
+  newEntry(const string& pKind, unsigned pLine);
+
+  /// Prints the entries of the interpreted nodes,
+  ///   sorted by processor time without subnodes (descending).
+  static void
+  printReport(ostream& pS);
+
+  /// Deletes all entries.
+  static void
+  clear();
+};
+
+#endif
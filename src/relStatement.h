@@ -29,19 +29,150 @@
  */
 
 #include "relPrintExpr.h"
+#include "relTrace.h"
+
+#include <iomanip>
 
 /// Global variable for interpreter.
 class relStatement;
 extern map<string, relStatement*> gProcedures;
 
+/// Global variables for dynamic variable reordering.
+extern string*  gOrderFileName;  // File for the variable order (or NULL).
+extern unsigned gReorderLocks;   // Number of active FOR loops.
+
+//////////////////////////////////////////////////////////////////////////////
+/// Reorders the BDD variables (see bddRelation::reorder()), 
+///   and writes the new variable order to the order file, if given.
+/// Only allowed between statements, because expressions keep
+///   attribute positions, and not within FOR loops (see gReorderLocks).
+inline void
+reorderVariables(bddSymTab* pSymTab)
+{
+  bddRelation::reorder(pSymTab);
+  if (gOrderFileName != NULL) {
+    ofstream lOrderStream(gOrderFileName->c_str(), ios::out);
+    if ( !lOrderStream.good() ) {
+      cerr << "Error: Cannot write variable order file '" 
+           << *gOrderFileName << "'." << endl;
+      return;
+    }
+    const vector<string> lOrder = pSymTab->getAttributeOrder();
+    copy(lOrder.begin(), 
+         lOrder.end(), 
+         ostream_iterator<string>(lOrderStream, "\n"));
+  }
+}
+
+/// Reorders the BDD variables if the BDD package asks for it.
+inline void
+reorderVariablesIfDue(bddSymTab* pSymTab)
+{
+  if (gReorderLocks == 0  &&  bddBdd::isReorderDue()) {
+    reorderVariables(pSymTab);
+  }
+}
+
+/// Compacts the node array if the BDD package asks for it.
+///   Like reordering, not within FOR loops (the cursor refers to nodes).
+inline void
+compactNodesIfDue()
+{
+  if (gReorderLocks == 0  &&  bddBdd::isCompactDue()) {
+    bddBdd::compact();
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////
 class relStatement : public relObject
 {
+private:
+  /// Line of the statement in the RML program (0 if unknown).
+  unsigned mLine;
+
 public:
+  relStatement()
+    : mLine(0)
+  {}
+
+  unsigned
+  getLine() const
+  {
+    return mLine;
+  }
+
+  void
+  setLine(unsigned pLine)
+  {
+    mLine = pLine;
+  }
+
   virtual void
   interpret(bddSymTab* pSymTab) = 0;
 };
 
+//////////////////////////////////////////////////////////////////////////////
+/// Profiled statement (option --profile): Measures the interpretations 
+///   of the wrapped statement.
+class relStmtProfile : public relStatement
+{
+private:
+  relStatement*    mStmt;
+  relProfileEntry* mEntry;
+
+public:
+  relStmtProfile(relStatement* pStmt, const string& pKind)
+    : mStmt(pStmt),
+      mEntry(relProfiler::newEntry(pKind, pStmt->getLine()))
+  {
+    setLine(pStmt->getLine());
+  }
+
+  ~relStmtProfile()
+  {
+    delete mStmt;
+  }
+
+  virtual void
+  interpret(bddSymTab* pSymTab)
+  {
+    relProfileScope lScope(mEntry);
+    mStmt->interpret(pSymTab);
+  }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// Traced statement (option --trace): Each interpretation 
+///   of the wrapped statement is a span of the timeline.
+class relStmtTrace : public relStatement
+{
+private:
+  relStatement* mStmt;
+  /// Name of the spans.
+  string        mName;
+
+public:
+  relStmtTrace(relStatement* pStmt, const string& pKind)
+    : mStmt(pStmt),
+      mName("line " + unsigned2string(pStmt->getLine()) + ": " + pKind)
+  {
+    setLine(pStmt->getLine());
+  }
+
+  ~relStmtTrace()
+  {
+    delete mStmt;
+  }
+
+  virtual void
+  interpret(bddSymTab* pSymTab)
+  {
+    relTrace::begin(mName, "statement");
+    mStmt->interpret(pSymTab);
+    relTrace::end();
+  }
+};
+
 //////////////////////////////////////////////////////////////////////////////
 class relStmtSeq : public relStatement
 {
@@ -65,6 +196,8 @@ public:
   interpret(bddSymTab* pSymTab)
   {
     mStmt1->interpret(pSymTab);
+    reorderVariablesIfDue(pSymTab);
+    compactNodesIfDue();
     mStmt2->interpret(pSymTab);
   }
 };
@@ -169,12 +302,13 @@ public:
     
     bddRelation lExprResult  = mExpr->interpret(pSymTab);
     
-    // Relation for elimination of the (one) cofactor specified 
-    //   by the constants.
-    bddRelation lEliminateCofactor(pSymTab, true);
+    // The (one) cofactor specified by the constants,
+    //   which the new value replaces in the old relation.
+    bddRelation lCofactor(pSymTab, true);
 
-    // Rename user attributes to the internal attributes.
-    //   Ordering: From top to bottom, for efficiency.
+    // Rename user attributes to the internal attributes,
+    //   all in one pass after the loop.
+    map<string, string> lRenaming;
     for(unsigned i = 0; i < mTermList->size(); ++i)
     {
       const string lTerm = (*mTermList)[i]->interpret(pSymTab);
@@ -184,28 +318,19 @@ public:
         // Add internal attribute to SymTab, if new.
         pSymTab->addAttribute(gAttributePrefix + unsigned2string(i)); 
 
-        // Rename.
-        lExprResult.rename(lTerm,
-                           gAttributePrefix + unsigned2string(i));
+        // Only the first occurrence of a repeated attribute is renamed,
+        //   the other internal attributes remain unconstrained.
+        lRenaming.insert(make_pair(lTerm, gAttributePrefix + unsigned2string(i)));
       }
       else if (dynamic_cast<relTermStrExpr*>((*mTermList)[i]) != NULL)
       {
         // lTerm is a string constant.
-        //   We have to eliminate the old cofactor for the given constant.
-        // Remember the cofactor of constant 'lTerm' 
-        //   for elimination from old relation.
-        lEliminateCofactor.intersect(bddRelation::mkAttributeValue(
-                                         pSymTab, 
-                                         gAttributePrefix + unsigned2string(i), 
-                                         lTerm)
-                                     );
-
-        // Restrict new relation to cofactor of constant.
-        lExprResult.intersect(bddRelation::mkAttributeValue(
-                                 pSymTab, 
-                                 gAttributePrefix + unsigned2string(i), 
-                                 lTerm)
-                              );
+        // Remember the cofactor of constant 'lTerm'.
+        lCofactor.intersect(bddRelation::mkAttributeValue(
+                                pSymTab, 
+                                gAttributePrefix + unsigned2string(i), 
+                                lTerm)
+                            );
       }
       else
       {
@@ -213,7 +338,7 @@ public:
         assert(false);
       }
     }
-    lEliminateCofactor.complement();
+    lExprResult.rename(lRenaming);
 
     // Fetch old value.
     map<string, relDataType*>::const_iterator lVarIt = gVariables.find(*mRelVar);
@@ -227,9 +352,10 @@ public:
     }
     bddRelation* lResult = dynamic_cast<bddRelation*>(lVarIt->second);
     assert(lResult != NULL);             // Must be a REL variable.
-    // Change value.
-    lResult->intersect(lEliminateCofactor);
-    lResult->unite(lExprResult);
+    // Change value: The new value within the cofactor, 
+    //   the old value outside, in one BDD pass.
+    lCofactor.ifThenElse(lExprResult, *lResult);
+    *lResult = lCofactor;
 
     // Some type checking: Track arity.
     lResult->mArity = mTermList->size();
@@ -469,6 +595,8 @@ public:
     while( lCondition.setEqual(bddRelation(pSymTab, true)) )
     {
       mStmt->interpret(pSymTab);
+      reorderVariablesIfDue(pSymTab);
+      compactNodesIfDue();
       
       lCondition = mExpr->interpret(pSymTab);
       pSymTab->removeUserAttributes(gAttributePrefix);
@@ -524,27 +652,205 @@ public:
     relString* lResult = dynamic_cast<relString*>(lVarIt->second);
     assert(lResult != NULL);             // Must be a STRING variable.
 
+    // No reordering within the loop, because (lRel) and (lVarId) 
+    //   keep a position that does not belong to an attribute any more.
+    ++gReorderLocks;
     // For all elements of the set (all values for attribute at pos lVarId).
-    while (!lRel.isEmpty()) {
-      // Get next value of the attribute.
-      string lValue = lRel.getElement(lVarId);
-
+    for (bddTupleCursor lCursor = lRel.getTuples(lVarId);
+         lCursor.isValid();
+         lCursor.next()) {
       // Change value of string variable.
-      lResult->setValue(lValue);
-
-      // Delete current element from set.
-      bddRelation lCurrentValue( bddRelation::mkEqual(pSymTab, 
-                                 lVarId, 
-                                 pSymTab->getValueNum(lValue)) );
-      lCurrentValue.complement();  
-      lRel.intersect(lCurrentValue);
+      lResult->setValue(pSymTab->getAttributeValue(lCursor.getTuple()[0]));
 
       // Execute body of FOR loop.
       mStmt->interpret(pSymTab);
     }
+    --gReorderLocks;
   }  // method
 };
 
+//////////////////////////////////////////////////////////////////////////////
+/// Statement for explicit reordering of the BDD variables.
+class relStmtReorder : public relStatement
+{
+public:
+  relStmtReorder()
+  {}
+
+  ~relStmtReorder()
+  {}
+
+  virtual void
+  interpret(bddSymTab* pSymTab)
+  {
+    if (gReorderLocks > 0) {
+      if (gPrintWarnings) {
+        cerr << "Warning: REORDER is ignored within FOR loops." << endl;
+      }
+      return;
+    }
+    reorderVariables(pSymTab);
+  }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// Prints the plan of a relational expression: the tree of subexpressions
+///   with their free attributes and the BDD variables of the attributes.
+///   EXPLAIN ANALYZE interprets the expression (without using the result)
+///   and adds the measurements of every subexpression (cf. --profile).
+class relStmtExplain : public relStatement
+{
+private:
+  relExpression* mExpr;
+  bool           mAnalyze;
+  /// Places of the subexpressions with the measuring wrappers,
+  ///   and the original subexpressions.
+  vector<pair<relExpression**, relExpression*> > mWrapped;
+  /// Measurements of the subexpressions.
+  map<relExpression*, relProfileEntry*> mEntries;
+
+  /// Puts measuring wrappers at the place (pExpr) and, recursively, 
+  ///   at the places of its subexpressions.
+  void
+  wrap(relExpression** pExpr)
+  {
+    relExpression* lExpr = *pExpr;
+    vector<relExpression**> lSubExprs = lExpr->getSubExprs();
+    for (unsigned i = 0; i < lSubExprs.size(); ++i) {
+      wrap(lSubExprs[i]);
+    }
+    relProfileEntry* lEntry = new relProfileEntry("", lExpr->getLine());
+    mEntries[lExpr] = lEntry;
+    mWrapped.push_back(make_pair(pExpr, lExpr));
+    *pExpr = new relExprProfile(lExpr, lEntry);
+  }
+
+  /// Removes the measuring wrappers.
+  void
+  unwrap()
+  {
+    for (unsigned i = 0; i < mWrapped.size(); ++i) {
+      delete *mWrapped[i].first;
+      *mWrapped[i].first = mWrapped[i].second;
+    }
+    mWrapped.clear();
+  }
+
+  /// Returns the free attributes of (pExpr) in the variable order,
+  ///   with their BDD variables, e.g., "x:0-9 y:10-19".
+  string
+  explainAttributes(relExpression* pExpr, bddSymTab* pSymTab)
+  {
+    const map<unsigned,string> lVarOrd 
+      = pSymTab->computeVariableOrder(pExpr->collectFreeAttrs());
+    string result;
+    for (map<unsigned,string>::const_iterator lIt = lVarOrd.begin();
+         lIt != lVarOrd.end();
+         ++lIt) {
+      if (!result.empty()) {
+        result += " ";
+      }
+      result += lIt->second + ":" + unsigned2string(lIt->first) + "-"
+        + unsigned2string(lIt->first + pSymTab->getBitNr() - 1);
+    }
+    return result;
+  }
+
+  /// Prints (pExpr) indented by (pDepth), and its subexpressions.
+  ///   Wrappers without label are skipped.
+  void
+  printPlan(relExpression* pExpr, bddSymTab* pSymTab, unsigned pDepth)
+  {
+    const string lLabel = pExpr->getExplainLabel(pSymTab);
+    if (!lLabel.empty()) {
+      if (mAnalyze) {
+        const relProfileEntry& lEntry = *mEntries[pExpr];
+        cout << setw(10) << lEntry.mCallNr;
+        if (lEntry.mCallNr > 0) {
+          cout << setprecision(3)
+               << setw(10) << lEntry.mSelfCpuTime
+               << setw(10) << lEntry.mCpuTime
+               << setw(12) << lEntry.mCreatedNr
+               << setw(10) << lEntry.mPeakNr
+               << setprecision(0)
+               << setw(10) << lEntry.mResultNodeNr
+               << setw(14) << lEntry.mResultTupleNr;
+        } else {
+          cout << setw(10) << "-"
+               << setw(10) << "-"
+               << setw(12) << "-"
+               << setw(10) << "-"
+               << setw(10) << "-"
+               << setw(14) << "-";
+        }
+        cout << "  ";
+      }
+      cout << string(2 * pDepth, ' ') << lLabel;
+      const string lAttributes = explainAttributes(pExpr, pSymTab);
+      if (!lAttributes.empty()) {
+        cout << "  [" << lAttributes << "]";
+      }
+      cout << endl;
+      ++pDepth;
+    }
+    vector<relExpression**> lSubExprs = pExpr->getSubExprs();
+    for (unsigned i = 0; i < lSubExprs.size(); ++i) {
+      printPlan(*lSubExprs[i], pSymTab, pDepth);
+    }
+  }
+
+public:
+  relStmtExplain(relExpression* pExpr, bool pAnalyze)
+    : mExpr(pExpr),
+      mAnalyze(pAnalyze)
+  {}
+
+  ~relStmtExplain()
+  {
+    delete mExpr;
+  }
+
+  virtual void
+  interpret(bddSymTab* pSymTab)
+  {
+    const ios::fmtflags lFlags = cout.flags();
+    const streamsize lPrecision = cout.precision();
+    if (mAnalyze) {
+      wrap(&mExpr);
+      mExpr->interpret(pSymTab);
+      unwrap();
+      cout << "Plan of line " << getLine() 
+           << " (times in seconds, attribute:BDD variables):" << endl
+           << setw(10) << "calls"
+           << setw(10) << "self"
+           << setw(10) << "total"
+           << setw(12) << "created"
+           << setw(10) << "peak"
+           << setw(10) << "nodes"
+           << setw(14) << "tuples"
+           << "  expression" << endl
+           << fixed;
+    } else {
+      // Place the attributes like the interpretation.
+      mExpr->addAttributes(pSymTab);
+      cout << "Plan of line " << getLine() 
+           << " (attribute:BDD variables):" << endl;
+    }
+    printPlan(mExpr, pSymTab, 0);
+    cout.flags(lFlags);
+    cout.precision(lPrecision);
+
+    for (map<relExpression*, relProfileEntry*>::iterator 
+         lIt = mEntries.begin();
+         lIt != mEntries.end();
+         ++lIt) {
+      delete lIt->second;
+    }
+    mEntries.clear();
+    pSymTab->removeUserAttributes(gAttributePrefix);
+  }
+};
+
 //////////////////////////////////////////////////////////////////////////////
 class relStmtExit : public relStatement
 {
@@ -580,7 +886,7 @@ public:
   {}
 
   virtual void
-  interpret(bddSymTab* pSymTab)
+  interpret(bddSymTab*)
   {}
 };
 
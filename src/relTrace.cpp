@@ -0,0 +1,207 @@
+/*
+ * CrocoPat is a tool for relational programming.
+ * This file is part of CrocoPat. 
+ *
+ * Copyright (C) 2002-2008  Dirk Beyer
+ *
+ * CrocoPat is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * CrocoPat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with CrocoPat; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Please find the GNU Lesser General Public License in file
+ * License_LGPL.txt or at http://www.gnu.org/licenses/lgpl.txt
+ *
+ * Author:
+ * Dirk Beyer (firstname.lastname@sfu.ca)
+ * Simon Fraser University
+ *
+ * With contributions of: Andreas Noack, Michael Vogel
+ */
+
+#include "relTrace.h"
+#include "bddZdd.h"
+
+#include <sstream>
+#include <sys/time.h>
+
+ofstream*     relTrace::mStream         = NULL;
+double        relTrace::mStartTime      = 0;
+unsigned      relTrace::mOpenNr         = 0;
+double        relTrace::mSampleTime     = 0;
+unsigned long relTrace::mSampleLookupNr = 0;
+unsigned long relTrace::mSampleHitNr    = 0;
+
+//////////////////////////////////////////////////////////////////////////////
+/// Returns (pStr) as JSON string literal.
+static string
+quoteJson(const string& pStr)
+{
+  string lResult = "\"";
+  for (string::const_iterator lIt = pStr.begin(); lIt != pStr.end(); ++lIt) {
+    const unsigned char lChar = *lIt;
+    if (lChar == '"'  ||  lChar == '\\') {
+      lResult += '\\';
+      lResult += lChar;
+    } else if (lChar < 0x20) {
+      const char* lHex = "0123456789abcdef";
+      lResult += "\\u00";
+      lResult += lHex[lChar >> 4];
+      lResult += lHex[lChar & 15];
+    } else {
+      lResult += lChar;
+    }
+  }
+  return lResult + "\"";
+}
+
+/// Returns the real time in microseconds.
+static double
+getWallTime()
+{
+  struct timeval lTime;
+  gettimeofday(&lTime, NULL);
+  return lTime.tv_sec * 1e6 + lTime.tv_usec;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+double
+relTrace::getTime()
+{
+  return getWallTime() - mStartTime;
+}
+
+void
+relTrace::writeEvent(const string& pName, const char* pCategory, char pPhase,
+                     double pTime, const string* pArgs)
+{
+  *mStream << "{\"name\":" << quoteJson(pName)
+           << ",\"cat\":\"" << pCategory << "\""
+           << ",\"ph\":\"" << pPhase << "\""
+           << ",\"ts\":" << (unsigned long) pTime
+           << ",\"pid\":1,\"tid\":1";
+  if (pArgs != NULL) {
+    *mStream << ",\"args\":{" << *pArgs << "}";
+  }
+  *mStream << "},\n";
+}
+
+void
+relTrace::sample(bool pForce)
+{
+  const double lTime = getTime();
+  if (!pForce  &&  lTime - mSampleTime < mSamplePeriod) {
+    return;
+  }
+  mSampleTime = lTime;
+
+  // The package that represents the relations (see option --zdd).
+  const bool lZdd = bddZdd::isActive();
+  const string lPackage = lZdd ? "ZDD" : "BDD";
+  ostringstream lNodes;
+  if (lZdd) {
+    lNodes << "\"used\":"   << bddZdd::getUsedNodeNr()
+           << ",\"unused\":" << bddZdd::getUnusedNodeNr()
+           << ",\"liveAfterGc\":" << bddZdd::getGcLiveNodeNr();
+  } else {
+    lNodes << "\"used\":"   << bddBdd::getUsedNodeNr()
+           << ",\"unused\":" << bddBdd::getUnusedNodeNr()
+           << ",\"liveAfterGc\":" << bddBdd::getGcLiveNodeNr();
+  }
+  const string lNodeArgs = lNodes.str();
+  writeEvent(lPackage + " nodes", "bdd", 'C', lTime, &lNodeArgs);
+
+  // Hit rate of the caches since the last sample.
+  const unsigned long lLookupNr = lZdd ? bddZdd::getCacheLookupNr()
+                                       : bddBdd::getCacheLookupNr();
+  const unsigned long lHitNr    = lZdd ? bddZdd::getCacheHitNr()
+                                       : bddBdd::getCacheHitNr();
+  if (lLookupNr > mSampleLookupNr) {
+    ostringstream lCache;
+    lCache << "\"hitPercent\":" 
+           << 100 * (lHitNr - mSampleHitNr) / (lLookupNr - mSampleLookupNr);
+    const string lCacheArgs = lCache.str();
+    writeEvent(lPackage + " cache hit rate", "bdd", 'C', lTime, &lCacheArgs);
+  }
+  mSampleLookupNr = lLookupNr;
+  mSampleHitNr    = lHitNr;
+}
+
+void
+relTrace::observe(const char* pEvent, bool pBegin)
+{
+  if (pBegin) {
+    begin(pEvent, "bdd");
+  } else {
+    end();
+    // The effect of the event is visible immediately.
+    sample(true);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+bool
+relTrace::open(const string& pFileName)
+{
+  mStream = new ofstream(pFileName.c_str(), ios::out);
+  if ( !mStream->good() ) {
+    delete mStream;
+    mStream = NULL;
+    return false;
+  }
+  mStartTime = getWallTime();
+  *mStream << "[\n";
+  bddBdd::setObserver(&observe);
+  bddZdd::setObserver(&observe);
+  return true;
+}
+
+void
+relTrace::close()
+{
+  if (mStream == NULL) {
+    return;
+  }
+  bddBdd::setObserver(0);
+  bddZdd::setObserver(0);
+  const double lTime = getTime();
+  for ( ; mOpenNr > 0; --mOpenNr) {
+    writeEvent("", "", 'E', lTime, NULL);
+  }
+  // Metadata event, such that the list ends without comma.
+  *mStream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+           << "\"args\":{\"name\":\"crocopat\"}}\n]\n";
+  delete mStream;
+  mStream = NULL;
+}
+
+void
+relTrace::begin(const string& pName, const char* pCategory)
+{
+  if (mStream == NULL) {
+    return;
+  }
+  sample(false);
+  writeEvent(pName, pCategory, 'B', getTime(), NULL);
+  ++mOpenNr;
+}
+
+void
+relTrace::end()
+{
+  if (mStream == NULL  ||  mOpenNr == 0) {
+    return;
+  }
+  --mOpenNr;
+  writeEvent("", "", 'E', getTime(), NULL);
+  sample(false);
+}
@@ -0,0 +1,108 @@
+/*
+ * CrocoPat is a tool for relational programming.
+ * This file is part of CrocoPat. 
+ *
+ * Copyright (C) 2002-2008  Dirk Beyer
+ *
+ * CrocoPat is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * CrocoPat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with CrocoPat; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Please find the GNU Lesser General Public License in file
+ * License_LGPL.txt or at http://www.gnu.org/licenses/lgpl.txt
+ *
+ * Author:
+ * Dirk Beyer (firstname.lastname@sfu.ca)
+ * Simon Fraser University
+ *
+ * With contributions of: Andreas Noack, Michael Vogel
+ */
+
+#ifndef _relTrace_h
+#define _relTrace_h
+
+#include "bddBdd.h"
+
+#include <string>
+#include <fstream>
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////
+/// Timeline of a run in the Chrome trace event format (option --trace),
+///   viewable in Perfetto or chrome://tracing: Spans for the loader phases,
+///   the statements (see relStmtTrace), and the garbage collections, 
+///   growth and reordering of the BDD package (resp. the ZDD package, 
+///   see option --zdd), and counter samples of its nodes and the cache 
+///   hit rate.
+/// The file is a JSON array of events. Viewers also accept it without
+///   the closing bracket, e.g., if the program is killed.
+class relTrace
+{
+private:
+  /// Minimum distance of the counter samples in microseconds.
+  enum { mSamplePeriod = 1000 };
+
+  /// Output file, NULL if tracing is off.
+  static ofstream*     mStream;
+  /// Real time of open() in microseconds.
+  static double        mStartTime;
+  /// Number of spans begun and not yet ended.
+  static unsigned      mOpenNr;
+  /// Time of the last counter sample, and the cache statistics then.
+  static double        mSampleTime;
+  static unsigned long mSampleLookupNr;
+  static unsigned long mSampleHitNr;
+
+  /// Returns the real time in microseconds since open().
+  static double
+  getTime();
+
+  /// Writes an event of phase (pPhase), without arguments if (pArgs) is 0.
+  static void
+  writeEvent(const string& pName, const char* pCategory, char pPhase, 
+             double pTime, const string* pArgs);
+
+  /// Writes counter samples of the BDD resp. ZDD package, 
+  ///   if the last ones are older than mSamplePeriod or if (pForce).
+  static void
+  sample(bool pForce);
+
+  /// Observer of the BDD and ZDD packages (see bddObserver).
+  static void
+  observe(const char* pEvent, bool pBegin);
+
+public:
+  /// Starts tracing into the file (pFileName).
+  ///   Returns false if the file cannot be written.
+  static bool
+  open(const string& pFileName);
+
+  /// Ends the open spans and closes the file.
+  static void
+  close();
+
+  static bool
+  isOn()
+  {
+    return mStream != NULL;
+  }
+
+  /// Begins resp. ends a span. Spans nest. Only while the BDD package
+  ///   is initialized, because they also write counter samples.
+  static void
+  begin(const string& pName, const char* pCategory);
+  static void
+  end();
+};
+
+#endif
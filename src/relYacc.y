@@ -50,10 +50,8 @@ extern const unsigned  gAttributeNum;
 extern string unsigned2string(unsigned pUnsigned);
 
 //////////////////////////////////////////////////////////////////////////////
-int yylex()
-{
-  return gScanner.yylex();
-}
+/// Defined after the grammar, where the token location yylloc is declared.
+int yylex();
 
 //////////////////////////////////////////////////////////////////////////////
 void yyerror(const string pErrorMsg)
@@ -64,10 +62,40 @@ void yyerror(const string pErrorMsg)
   ++gNoParseErrs;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+/// Records the source line (pLine) of the statement (pStmt), and wraps
+///   the statement for the profiler resp. the timeline if option 
+///   --profile resp. --trace is given.
+///   (pKind) describes the statement in the profile and the timeline.
+relStatement* located(relStatement* pStmt, const string& pKind, int pLine)
+{
+  pStmt->setLine(pLine);
+  if (gProfile) {
+    pStmt = new relStmtProfile(pStmt, pKind);
+  }
+  if (relTrace::isOn()) {
+    pStmt = new relStmtTrace(pStmt, pKind);
+  }
+  return pStmt;
+}
+
+/// Like above, for relational expressions (only for the profiler).
+relExpression* located(relExpression* pExpr, const string& pKind, int pLine)
+{
+  pExpr->setLine(pLine);
+  if (gProfile) {
+    return new relExprProfile(pExpr, pKind);
+  }
+  return pExpr;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 %}
 
+// Track token locations (see yylex()).
+%locations
+
 
 // Operators with precedences.
 // Relational Expressions.
@@ -90,6 +118,7 @@ void yyerror(const string pErrorMsg)
 
 
 %token t_ASSIGN
+%token t_ANALYZE
 %token t_AVG
 %token t_BDT
 %token t_DIV
@@ -99,6 +128,7 @@ void yyerror(const string pErrorMsg)
 %token t_ELAPSED
 %token t_ELEMENT
 %token t_EXISTS
+%token t_EXPLAIN
 %token t_EXEC
 %token t_EXIT
 %token t_FORALL
@@ -120,6 +150,7 @@ void yyerror(const string pErrorMsg)
 %token t_RELINFO
 %token t_RELSYM
 %token t_RELVAR
+%token t_REORDER
 %token t_ROUND
 %token t_STDERR
 %token t_STRING
@@ -207,41 +238,47 @@ Statement:
      |  // Procedure call.
        t_IDENTIFIER ';'
       {
-        $$ = new relStmtCall($1);
+        $$ = located(new relStmtCall($1),
+                     *$1 + ";", @$.first_line);
       }
      |  // Assignment for INT.
        t_NUMVAR t_ASSIGN NumExpr ';'
       {
         // Declaration already done.
-        $$ = new relStmtAssignNum($1, $3);
+        $$ = located(new relStmtAssignNum($1, $3),
+                     *$1 + " := ...", @$.first_line);
       }
      | t_IDENTIFIER t_ASSIGN NumExpr ';'
       {
         assert(gVariables.find(*$1) == gVariables.end());
         // Declare variable.
         gVariables[*$1] = new relNumber(0);             
-        $$ = new relStmtAssignNum($1, $3);
+        $$ = located(new relStmtAssignNum($1, $3),
+                     *$1 + " := ...", @$.first_line);
       }
       
         // Assignment for STRING.
      | t_STRVAR t_ASSIGN StrExpr ';'
       {
         // Declaration already done.
-        $$ = new relStmtAssignStr($1, $3);
+        $$ = located(new relStmtAssignStr($1, $3),
+                     *$1 + " := ...", @$.first_line);
       }
      | t_IDENTIFIER t_ASSIGN StrExpr ';'
       {
         assert(gVariables.find(*$1) == gVariables.end());
         // Declare variable.
         gVariables[*$1] = new relString("");            
-        $$ = new relStmtAssignStr($1, $3);
+        $$ = located(new relStmtAssignStr($1, $3),
+                     *$1 + " := ...", @$.first_line);
       }
             
       // Assignment for REL.
      | t_RELVAR '(' TermListLHS ')' t_ASSIGN Expression ';'
       {
         // Declaration already done.
-        $$ = new relStmtAssign($1, $3, $6);
+        $$ = located(new relStmtAssign($1, $3, $6),
+                     *$1 + "(...) := ...", @$.first_line);
       }
      | t_RELVAR '(' TermListLHS ')' ';'
       {
@@ -249,7 +286,10 @@ Statement:
         // Special case: nothing on the right hand side means TRUE,
         //   i.e. 'R(...);' is a short cut for 'R(...) := TRUE();'.
         vector<relTerm*>* lTermList = new vector<relTerm*>();
-        $$ = new relStmtAssign($1, $3, new relExprRelVar(new string("TRUE"), lTermList));
+        $$ = located(new relStmtAssign($1, $3, 
+                                       new relExprRelVar(new string("TRUE"), 
+                                                         lTermList)),
+                     *$1 + "(...);", @$.first_line);
       }
      | t_IDENTIFIER '(' TermListLHS ')' t_ASSIGN Expression ';'
       {
@@ -261,7 +301,8 @@ Statement:
           // Declare variable.
           gVariables[*$1] = new bddRelation(gSymTab, false);              
         }
-        $$ = new relStmtAssign($1, $3, $6);
+        $$ = located(new relStmtAssign($1, $3, $6),
+                     *$1 + "(...) := ...", @$.first_line);
       }
      | t_IDENTIFIER '(' TermListLHS ')' ';'
       {
@@ -271,53 +312,82 @@ Statement:
         // Special case: nothing means TRUE on the right hand side,
         //   i.e. 'R(...);' is a short cut for 'R(...) := TRUE();'.
         vector<relTerm*>* lTermList = new vector<relTerm*>();
-        $$ = new relStmtAssign($1, $3, new relExprRelVar(new string("TRUE"), lTermList));
+        $$ = located(new relStmtAssign($1, $3, 
+                                       new relExprRelVar(new string("TRUE"), 
+                                                         lTermList)),
+                     *$1 + "(...);", @$.first_line);
       }
 
       // Conditionals.
      | t_IF Expression '{' StmtSeq '}'
       {
-        $$ = new relStmtIf($2, $4, new relStmtEmpty());
+        $$ = located(new relStmtIf($2, $4, new relStmtEmpty()),
+                     "IF ...", @$.first_line);
       }
      | t_IF Expression '{' StmtSeq '}' t_ELSE '{' StmtSeq '}'
       {
-        $$ = new relStmtIf($2, $4, $8);
+        $$ = located(new relStmtIf($2, $4, $8),
+                     "IF ... ELSE ...", @$.first_line);
       }
      | t_WHILE Expression '{' StmtSeq '}'
       {
-        $$ = new relStmtWhile($2, $4);
+        $$ = located(new relStmtWhile($2, $4),
+                     "WHILE ...", @$.first_line);
       }
      | t_FOR StringVar t_IN Expression '{' StmtSeq '}'
       {
-        $$ = new relStmtFor($2, $4, $6);
+        $$ = located(new relStmtFor($2, $4, $6),
+                     "FOR " + *$2 + " IN ...", @$.first_line);
       }
       
       // Output.
       // Standard output.
      | t_PRINT PrintExprList ';'
       {
-        $$ = new relStmtPrint($2, &cout, new relStrExprConst(new string("")));
+        $$ = located(new relStmtPrint($2, &cout, new relStrExprConst(new string(""))),
+                     "PRINT ...", @$.first_line);
       }
       // Standard error output.
      | t_PRINT PrintExprList t_TO t_STDERR ';'
       {
-        $$ = new relStmtPrint($2, &cerr, new relStrExprConst(new string("")));
+        $$ = located(new relStmtPrint($2, &cerr, new relStrExprConst(new string(""))),
+                     "PRINT ... TO STDERR", @$.first_line);
       }
       // Append output to file given by StrExpr.
      | t_PRINT PrintExprList t_TO StrExpr ';'
       {
-        $$ = new relStmtPrint($2, NULL, $4);
+        $$ = located(new relStmtPrint($2, NULL, $4),
+                     "PRINT ... TO ...", @$.first_line);
       }
       
       // External program execution.
      | t_EXEC StrExpr ';'
       {
-        $$ = new relStmtExec($2);
+        $$ = located(new relStmtExec($2),
+                     "EXEC ...", @$.first_line);
       }
       // Program termination.
      | t_EXIT NumExpr ';' 
       {
-        $$ = new relStmtExit($2);
+        $$ = located(new relStmtExit($2),
+                     "EXIT ...", @$.first_line);
+      }
+      // Reordering of the BDD variables.
+     | t_REORDER ';' 
+      {
+        $$ = located(new relStmtReorder(),
+                     "REORDER", @$.first_line);
+      }
+      // Plan of an expression.
+     | t_EXPLAIN Expression ';'
+      {
+        $$ = located(new relStmtExplain($2, false),
+                     "EXPLAIN ...", @$.first_line);
+      }
+     | t_EXPLAIN t_ANALYZE Expression ';'
+      {
+        $$ = located(new relStmtExplain($3, true),
+                     "EXPLAIN ANALYZE ...", @$.first_line);
       }
      | '{' StmtSeq '}'
       {
@@ -354,15 +424,18 @@ Expression:
         vector<relTerm*>* lTermList = new vector<relTerm*>();
         lTermList->push_back($3);
         lTermList->push_back($5);
-        $$ = new relExprRelVar($1, lTermList);
+        $$ = located(new relExprRelVar($1, lTermList),
+                     *$1 + "(...)", @$.first_line);
       }
      | t_RELSYM '(' NumExpr ',' NumExpr ')'
       {
-            $$ = new relExprRelNumCmp($1, $3, $5);
+            $$ = located(new relExprRelNumCmp($1, $3, $5),
+                     *$1 + "(...)", @$.first_line);
       }
      | t_RELVAR '(' TermList ')'
       {
-        $$ = new relExprRelVar($1, $3);
+        $$ = located(new relExprRelVar($1, $3),
+                     *$1 + "(...)", @$.first_line);
       }
      | t_IDENTIFIER '(' TermList ')'
       {
@@ -375,25 +448,29 @@ Expression:
         assert(gVariables.find(*$1) == gVariables.end());
         // Declare variable.
         gVariables[*$1] = new bddRelation(gSymTab, false);              
-        $$ = new relExprRelVar($1, $3);
+        $$ = located(new relExprRelVar($1, $3),
+                     *$1 + "(...)", @$.first_line);
       }
      | Term t_RELSYM Term
       {
         vector<relTerm*>* lTermList = new vector<relTerm*>();
         lTermList->push_back($1);
         lTermList->push_back($3);
-        $$ = new relExprRelVar($2, lTermList);
+        $$ = located(new relExprRelVar($2, lTermList),
+                     "... " + *$2 + " ...", @$.first_line);
       }
      | NumExpr t_RELSYM NumExpr
       {
-        $$ = new relExprRelNumCmp($2, $1, $3);
+        $$ = located(new relExprRelNumCmp($2, $1, $3),
+                     "... " + *$2 + " ...", @$.first_line);
       }
      | Term t_RELVAR Term
       {
         vector<relTerm*>* lTermList = new vector<relTerm*>();
         lTermList->push_back($1);
         lTermList->push_back($3);
-        $$ = new relExprRelVar($2, lTermList);
+        $$ = located(new relExprRelVar($2, lTermList),
+                     "... " + *$2 + " ...", @$.first_line);
       }
      | Term t_IDENTIFIER Term
       {
@@ -410,49 +487,60 @@ Expression:
         vector<relTerm*>* lTermList = new vector<relTerm*>();
         lTermList->push_back($1);
         lTermList->push_back($3);
-        $$ = new relExprRelVar($2, lTermList);
+        $$ = located(new relExprRelVar($2, lTermList),
+                     "... " + *$2 + " ...", @$.first_line);
       }
       
      | '!' Expression
       {
-        $$ = new relExprNot($2);
+        $$ = located(new relExprNot($2),
+                     "!...", @$.first_line);
       }
      | Expression '&' Expression
       {
-        $$ = new relExprAnd($1, $3);
+        $$ = located(new relExprAnd($1, $3),
+                     "... & ...", @$.first_line);
       }
      | Expression '|' Expression 
       {
-        $$ = new relExprOr($1, $3);
+        $$ = located(new relExprOr($1, $3),
+                     "... | ...", @$.first_line);
       }
      | Expression t_IMPLIES Expression 
       {
-        $$ = new relExprOr(new relExprNot($1), $3);
+        $$ = located(new relExprImplies($1, $3),
+                     "... -> ...", @$.first_line);
       }
      | Expression t_EQUIV Expression 
       {
-        $$ = new relExprEquiv($1, $3);
+        $$ = located(new relExprEquiv($1, $3),
+                     "... <-> ...", @$.first_line);
       }
      | t_EXISTS '(' TermList ',' Expression ')'
       {
-        $$ = new relExprExists($3, $5);
+        $$ = located(new relExprExists($3, $5),
+                     "EX(...)", @$.first_line);
       }
      | t_FORALL '(' TermList ',' Expression ')'
       {
-        $$ = new relExprNot( new relExprExists($3, new relExprNot($5)) );
+        $$ = located(new relExprForall($3, $5),
+                     "FA(...)", @$.first_line);
       }
      | t_TC '(' Expression ')'
       {
-        $$ = new relExprClosure($3, relExprClosure::WARSHALLII);
+        $$ = located(new relExprClosure($3, relExprClosure::WARSHALLII),
+                     "TC(...)", @$.first_line);
       }
      | t_TCFAST '(' Expression ')'
       {
-        $$ = new relExprClosure($3, relExprClosure::EXPTRAVERS);
+        $$ = located(new relExprClosure($3, relExprClosure::EXPTRAVERS),
+                     "TCFAST(...)", @$.first_line);
       }
           // Create a matching set of strings for a regular expression.
      | '@' StrExpr '(' Term ')'
       {
-        $$ = new relExprRegExTerm($2, $4);
+        $$ = located(new relExprRegExTerm($2, $4),
+                     "@...(...)", @$.first_line);
       }
      | '(' Expression ')'
       {
@@ -462,12 +550,14 @@ Expression:
           // Expressions with 'Boolean' result.
      | Expression t_RELSYM Expression
       {
-        $$ = new relExprRelOp($1, $2, $3);
+        $$ = located(new relExprRelOp($1, $2, $3),
+                     "... " + *$2 + " ...", @$.first_line);
       }
 
      | t_TUPLEOF '(' Expression ')'
       {
-        $$ = new relExprTupleOf($3);
+        $$ = located(new relExprTupleOf($3),
+                     "TUPLEOF(...)", @$.first_line);
       }
     ;
 
@@ -716,3 +806,12 @@ PrintExpr:
     ;
 
 %%
+
+//////////////////////////////////////////////////////////////////////////////
+int yylex()
+{
+  int lToken = gScanner.yylex();
+  // Location of the token, for the source lines of the syntax tree.
+  yylloc.first_line = yylloc.last_line = gScanner.lineno();
+  return lToken;
+}
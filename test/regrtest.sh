@@ -240,6 +240,54 @@ failTest() {
 
 rw="-rw"
 
+# Checks for runTest that compare runs of CrocoPat:
+#   They print "Test passed. :-)" on success, a line with "Error:" otherwise.
+
+# run CrocoPat with the options $1 and without them,
+#   the outputs must be the same (the extra output on stderr is ignored)
+sameOutput() {
+  opts="$1"
+  shift
+  $CROCOPAT "$@" > same_1.out 2>&1
+  $CROCOPAT $opts "$@" > same_2.out 2> same_2.err
+  if cmp -s same_1.out same_2.out; then
+    echo "Test passed. :-)"
+  else
+    echo "Error: The output differs with the options $opts."
+  fi
+}
+
+# run CrocoPat with --profile, the output must be unchanged
+#   and the profile must be printed to stderr
+profileTest() {
+  sameOutput --profile "$@"
+  if ! grep -q "^Profile " same_2.err; then
+    echo "Error: No profile printed."
+  fi
+  rm -f same_1.out same_2.out same_2.err
+}
+
+# run CrocoPat with --trace, the output must be unchanged and the trace
+#   must be in the Chrome trace event format (a JSON array or object)
+traceTest() {
+  rm -f trace.json
+  sameOutput "--trace trace.json" "$@"
+  first=`head -c 15 trace.json 2>/dev/null`
+  last=`tr -d ' \t\n\r' < trace.json 2>/dev/null | tail -c 1`
+  if [ "${first:0:1}" = "[" ]; then
+    if [ "$last" != "]" ]; then
+      echo "Error: Trace is not terminated."
+    fi
+  elif [ "$first" = '{"traceEvents"' ]; then
+    if [ "$last" != "}" ]; then
+      echo "Error: Trace is not terminated."
+    fi
+  else
+    echo "Error: No trace written."
+  fi
+  rm -f same_1.out same_2.out same_2.err trace.json
+}
+
 # self-contained tests of specific examples 
 
 # easy microbenchmarks
@@ -256,6 +304,38 @@ runTest $CROCOPAT -e -m 1 -l proc_lib.rml proc_call_lib.rml
 failTest $CROCOPAT -e -m 1 -l proc_lib.rml proc_call_libXXXX.rml
 failTest $CROCOPAT -e -m 1 -l proc_libXXXX.rml proc_call_lib.rml
 runTest $CROCOPAT -e -m 1 comment.rml
+runTest $CROCOPAT -e -m 1 zdd.rml
+runTest $CROCOPAT -e -m 1 --zdd zdd.rml
+runTest $CROCOPAT -e -m 1 explain.rml
+runTest profileTest -e -m 1 logic.rml
+runTest traceTest -e -m 1 logic.rml
+runTest sameOutput "-c fifo" -e -m 1 logic.rml
+runTest sameOutput "-c fifo" -e -m 1 quantify.rml
+rm -f same_1.out same_2.out same_2.err
+runTest $CROCOPAT -e -m 1 logic.rml
+runTest $CROCOPAT -e -m 1 quantify.rml
+runTest $CROCOPAT -e -m 1 constant.rml
+runTest $CROCOPAT -e -m 1 --zdd constant.rml
+rm -f reorder.order
+runTest $CROCOPAT -m 1 reorder.rml < reorder.rsf
+runTest $CROCOPAT -m 1 -r 100 -o reorder.order reorder.rml < reorder.rsf
+runTest $CROCOPAT -m 1 -o reorder.order reorder.rml < reorder.rsf
+rm -f reorder.order
+runTest $CROCOPAT -e -m 1 -j 2 logic.rml
+runTest $CROCOPAT -e -m 1 -j 4 logic.rml
+runTest $CROCOPAT -e -m 1 -j 2 quantify.rml
+runTest $CROCOPAT -e -m 1 -j 4 constant.rml
+runTest $CROCOPAT -m 1 -j 2 reorder.rml < reorder.rsf
+runTest $CROCOPAT -m 1 -j 4 -r 100 reorder.rml < reorder.rsf
+runTest $CROCOPAT -m 1 parallel.rml < reorder.rsf
+runTest $CROCOPAT -m 1 -j 2 parallel.rml < reorder.rsf
+runTest $CROCOPAT -m 1 -j 4 parallel.rml < reorder.rsf
+rm -f snapshot.snap
+runTest $CROCOPAT -m 1 snapshot.rml < snapshot.rsf
+runTest $CROCOPAT -m 1 -w snapshot.snap snapshot.rml < snapshot.rsf
+runTest $CROCOPAT -m 1 -i snapshot.snap snapshot.rml
+failTest $CROCOPAT -m 1 -i snapshot.rsf snapshot.rml
+rm -f snapshot.snap
 
 }
 